@@ -63,6 +63,13 @@ extern "C" {
 #define DJVUPURE_IO_SEEK_END 1
 #define DJVUPURE_IO_SEEK_SET 2
 
+#define DJVUPURE_DOCUMENT_FLAG_LAZY 1 // Same as djvupureDocumentReadLazy
+#define DJVUPURE_DOCUMENT_FLAG_ARENA 2 // Whole chunk tree is freed at once with document, its chunks must not be freed separately
+// Memory of removed or replaced chunks isn't reused until document is freed, so long editing of such document grows its memory
+
+#define DJVUPURE_RENDER_FLAG_PACKED_MASK 1 // Pages with mask only are rendered as packed rows of (width+7)/8 bytes (1 is black, msb is left pixel) instead of 1 byte per pixel
+#define DJVUPURE_RENDER_FLAG_PARALLEL_LAYERS 2 // Background, mask and foreground of compound page are decoded by separate threads in one stage, allocator must be thread safe
+
 typedef size_t (DJVUPURE_APIENTRY * djvupure_io_callback_read_t)(void *fctx, void *buf, size_t size);
 typedef size_t (DJVUPURE_APIENTRY * djvupure_io_callback_write_t)(void *fctx, const void *buf, size_t size);
 typedef int (DJVUPURE_APIENTRY * djvupure_io_callback_seek_t)(void *fctx, int64_t offset, int origin);
@@ -80,6 +87,18 @@ typedef struct {
 typedef bool (DJVUPURE_APIENTRY * djvupure_io_callback_openu8_t)(uint8_t *fname, bool write, djvupure_io_callback_t *io, void **fctx);
 typedef void (DJVUPURE_APIENTRY * djvupure_io_callback_close_t)(void* fctx);
 
+typedef void * (DJVUPURE_APIENTRY * djvupure_allocator_callback_alloc_t)(void *user, size_t size);
+typedef void * (DJVUPURE_APIENTRY * djvupure_allocator_callback_realloc_t)(void *user, void *ptr, size_t size);
+typedef void (DJVUPURE_APIENTRY * djvupure_allocator_callback_free_t)(void *user, void *ptr);
+
+typedef struct {
+	uint32_t hash;
+	djvupure_allocator_callback_alloc_t callback_alloc;
+	djvupure_allocator_callback_realloc_t callback_realloc;
+	djvupure_allocator_callback_free_t callback_free;
+	void *user; // Passed to callbacks
+} djvupure_allocator_t;
+
 typedef void (DJVUPURE_APIENTRY * djvupure_chunk_callback_free_t)(void *ctx);
 typedef bool (DJVUPURE_APIENTRY * djvupure_chunk_callback_render_t)(void *ctx, djvupure_io_callback_t *io, void *fctx);
 typedef size_t (DJVUPURE_APIENTRY * djvupure_chunk_callback_size_t)(void *ctx);
@@ -96,6 +115,11 @@ typedef struct {
 	djvupure_chunk_callback_free_aux_t callback_free_aux;
 } djvupure_chunk_t;
 
+// Called concurrently from worker threads. image_buffer is 0 if page can't be rendered, otherwise it's valid only during the call. Return false to stop rendering
+typedef bool (DJVUPURE_APIENTRY * djvupure_page_sink_t)(void *sink_ctx, size_t index, uint16_t width, uint16_t height, uint8_t channels, void *image_buffer);
+// y is first row of band in rendered rectangle, band_buffer holds nof_rows rows of rectangle width. Returning false stops rendering
+typedef bool (DJVUPURE_APIENTRY * djvupure_band_sink_t)(void *sink_ctx, uint16_t y, uint16_t nof_rows, uint8_t channels, void *band_buffer);
+
 typedef struct {
 	uint16_t width;
 	uint16_t height;
@@ -104,6 +128,13 @@ typedef struct {
 	uint8_t rotation; // 1 - without, 5 - 90deg, 2 - 180deg, 6 - 270deg
 } djvupure_page_info_t;
 
+typedef struct {
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+} djvupure_rect_t;
+
 enum {
 	DJVUPURE_IMAGE_RENDERER_ERROR,
 	DJVUPURE_IMAGE_RENDERER_NEXT_STAGE, // Another stage needed
@@ -119,11 +150,17 @@ DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureChunkSize(djvupure_chunk_t
 
 DJVUPURE_API uint32_t DJVUPURE_APIENTRY_EXPORT djvupureIOGetStructHash(void);
 
+DJVUPURE_API uint32_t DJVUPURE_APIENTRY_EXPORT djvupureAllocatorGetStructHash(void);
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureAllocatorSetDefault(djvupure_allocator_t *allocator); // malloc, realloc and free
+
 DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupureFileOpenA(char *filename, bool write);
 DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupureFileOpenW(wchar_t *filename, bool write);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFileOpenU8(uint8_t *fname, bool write, djvupure_io_callback_t *io, void **fctx);
 DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureFileClose(void *fctx);
 DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureFileSetIoCallbacks(djvupure_io_callback_t *io);
+DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupureFileMapA(char *filename);
+DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupureFileMapW(wchar_t *filename);
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureFileUnmap(void *fmap);
 
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureRawChunkCreate(const uint8_t sign[4], void *data, size_t data_len);
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureRawChunkRead(djvupure_io_callback_t *io, void *fctx);
@@ -133,6 +170,7 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureContainerCheckSign(const uint
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureContainerIs(djvupure_chunk_t *container, const uint8_t subsign[4]);
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerCreate(const uint8_t subsign[4]);
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerRead(djvupure_io_callback_t *io, void *fctx);
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerReadLazy(djvupure_io_callback_t *io, void *fctx); // fctx must stay open until container is freed
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureContainerInsertChunk(djvupure_chunk_t *container, djvupure_chunk_t *chunk, size_t index);
 DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureContainerSize(djvupure_chunk_t *container);
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerGetSubchunk(djvupure_chunk_t *container, size_t index);
@@ -150,7 +188,25 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageCheckSubsign(const uint8_
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageIs(djvupure_chunk_t *page);
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupurePageCreate(void);
 DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererCreate(djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t *width, uint16_t *height, uint8_t *channels);
+DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererCreateWithAllocator(djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t *width, uint16_t *height, uint8_t *channels, djvupure_allocator_t *allocator); // All renderer buffers are allocated with allocator
+// Prepares renderer for another page like djvupurePageImageRendererCreate. Flags and scratch buffers are kept, so pages of similar size are rendered without allocating them again
+// If false is returned renderer can only be reset again or destroyed
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererReset(void *image_renderer_ctx, djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t *width, uint16_t *height, uint8_t *channels);
+// Frees scratch buffers kept by renderer, they are allocated again when needed. Shouldn't be called from band sink
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererShrink(void *image_renderer_ctx);
+// Renders page reduced to width*height (size of rotated page), layers are scaled while decoding. Should be called before djvupurePageImageRendererSetRect and djvupurePageImageRendererNext
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetSize(void *image_renderer_ctx, uint16_t width, uint16_t height);
+// Same as djvupurePageImageRendererSetSize, page size is divided by factor and rounded up. width and height receive reduced size
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetReduction(void *image_renderer_ctx, uint8_t factor, uint16_t *width, uint16_t *height);
+// Renders only rect of rotated and scaled page, image_buffer holds rect->width*rect->height pixels. Should be called before djvupurePageImageRendererNext
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetRect(void *image_renderer_ctx, const djvupure_rect_t *rect);
+// Same as djvupurePageImageRendererSetRect for tile of tile_size*tile_size grid, tiles on edges are clipped. rect receives tile rectangle
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetTile(void *image_renderer_ctx, uint16_t tile_size, uint32_t column, uint32_t row, djvupure_rect_t *rect);
+// Sets DJVUPURE_RENDER_FLAG_* flags. Should be called before djvupurePageImageRendererNext
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetFlags(void *image_renderer_ctx, uint32_t flags);
 DJVUPURE_API int DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererNext(void *image_renderer_ctx, void *image_buffer);
+// Renders page (or rect) by bands of band_height rows and passes them to sink instead of djvupurePageImageRendererNext. Layers are decoded once at their own resolution (mask as 1 bit per pixel), only buffers for one band are allocated
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererRenderBands(void *image_renderer_ctx, uint16_t band_height, djvupure_band_sink_t sink, void *sink_ctx);
 DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererDestroy(void *image_renderer_ctx);
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirCheckSign(const uint8_t sign[4]);
@@ -158,31 +214,78 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirIs(djvupure_chunk_t *dir);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirInit(djvupure_chunk_t *dir, djvupure_chunk_t *document);
 DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureDirCountPages(djvupure_chunk_t *dir);
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDirGetPage(djvupure_chunk_t *dir, size_t index, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close);
+DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureDirFindPage(djvupure_chunk_t *dir, djvupure_chunk_t *page); // Returns page index or number of pages if not found
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirPutPage(djvupure_chunk_t *dir, djvupure_chunk_t *page, bool changed, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close);
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentIs(djvupure_chunk_t *document);
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentRead(djvupure_io_callback_t *io, void *fctx);
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentReadLazy(djvupure_io_callback_t *io, void *fctx); // fctx must stay open until document is freed
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentMap(void *fmap); // Chunks point to fmap data, so free document before djvupureFileUnmap
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentReadWithFlags(djvupure_io_callback_t *io, void *fctx, uint32_t flags);
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentMapWithFlags(void *fmap, uint32_t flags); // DJVUPURE_DOCUMENT_FLAG_LAZY is ignored
+// Chunk tree is allocated from arena backed by allocator (DJVUPURE_DOCUMENT_FLAG_ARENA is implied), allocator is copied and user pointer must stay valid until document is freed
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentReadWithAllocator(djvupure_io_callback_t *io, void *fctx, uint32_t flags, djvupure_allocator_t *allocator);
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentMapWithAllocator(void *fmap, uint32_t flags, djvupure_allocator_t *allocator);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentRender(djvupure_chunk_t *chunk, djvupure_io_callback_t *io, void *fctx);
 DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureDocumentCountPages(djvupure_chunk_t *document);
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentGetPage(djvupure_chunk_t *document, size_t index, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close);
+DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureDocumentFindPage(djvupure_chunk_t *document, djvupure_chunk_t *page); // Returns page index or number of pages if not found
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentPutPage(djvupure_chunk_t *document, djvupure_chunk_t *page, bool changed, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close);
+// Renders pages with nof_threads workers (0 means number of processors). Document must not be used by other threads until function returns. allocator must be thread safe (0 means malloc)
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentRenderPages(djvupure_chunk_t *document, size_t first_page, size_t nof_pages, djvupure_page_sink_t sink, void *sink_ctx, unsigned int nof_threads, djvupure_allocator_t *allocator, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close);
+// Same as djvupureDocumentRenderPages, pages are rendered with DJVUPURE_RENDER_FLAG_* flags
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentRenderPagesWithFlags(djvupure_chunk_t *document, size_t first_page, size_t nof_pages, djvupure_page_sink_t sink, void *sink_ctx, unsigned int nof_threads, djvupure_allocator_t *allocator, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close, uint32_t flags);
+
+// Cache of rendered pages, least recently used pages are evicted when cached pixels take more than budget bytes. Functions can be called from several threads
+// Pages are taken from document like djvupureDocumentRenderPages does, so document must not be used by other threads while cache is used. allocator must be thread safe (0 means malloc)
+DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheCreate(size_t budget, djvupure_allocator_t *allocator);
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheDestroy(void *render_cache); // All pixels should be released
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheSetBudget(void *render_cache, size_t budget);
+DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheGetSize(void *render_cache); // Returns size of cached pixels
+// Removes pages of document (all pages if document is 0), it should be called before document is freed. Borrowed pixels stay valid until they are released
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheRemoveDocument(void *render_cache, djvupure_chunk_t *document);
+// Returns page reduced by factor (or rect of reduced page if rect isn't 0) rendered with DJVUPURE_RENDER_FLAG_* flags, it's rendered only if it isn't in cache
+// Pixels are borrowed from cache and must not be changed, they stay valid until djvupureRenderCacheRelease. Returns 0 on error
+DJVUPURE_API const void * DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheAcquire(void *render_cache, djvupure_chunk_t *document, size_t index, uint8_t factor, const djvupure_rect_t *rect, uint32_t flags, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close, uint16_t *width, uint16_t *height, uint8_t *channels);
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheRelease(void *render_cache, const void *pixels);
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSmmrCheckSign(const uint8_t sign[4]);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSmmrIs(djvupure_chunk_t *dir);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSmmrGetInfo(djvupure_chunk_t *smmr, uint16_t *width, uint16_t *height);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSmmrDecode(djvupure_chunk_t *smmr, uint16_t width, uint16_t height, void* buf);
 
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSjbzCheckSign(const uint8_t sign[4]);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSjbzIs(djvupure_chunk_t *sjbz);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSjbzGetInfo(djvupure_chunk_t *sjbz, uint16_t *width, uint16_t *height);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSjbzDecode(djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t width, uint16_t height, void *buf); // Shared dictionary is taken from document (may be 0) and kept there for other pages
+
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpCheckSign(const uint8_t sign[4]);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpIs(djvupure_chunk_t *dir);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpGetInfo(djvupure_chunk_t *fgjp, uint16_t *width, uint16_t *height);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpDecode(djvupure_chunk_t *fgjp, uint16_t width, uint16_t height, void *buf);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpGetReducedInfo(djvupure_chunk_t *fgjp, uint8_t factor, uint16_t *width, uint16_t *height); // factor is 1, 2, 4 or 8
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpDecodeReduced(djvupure_chunk_t *fgjp, uint8_t factor, void *buf); // Image is reduced while decoding, buf has size from djvupureFGjpGetReducedInfo
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpCheckSign(const uint8_t sign[4]);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpIs(djvupure_chunk_t *dir);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpGetInfo(djvupure_chunk_t *bgjp, uint16_t *width, uint16_t *height);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpDecode(djvupure_chunk_t *bgjp, uint16_t width, uint16_t height, void *buf);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpGetReducedInfo(djvupure_chunk_t *bgjp, uint8_t factor, uint16_t *width, uint16_t *height); // factor is 1, 2, 4 or 8
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpDecodeReduced(djvupure_chunk_t *bgjp, uint8_t factor, void *buf); // Image is reduced while decoding, buf has size from djvupureBGjpGetReducedInfo
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFG44CheckSign(const uint8_t sign[4]);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFG44Is(djvupure_chunk_t *fg44);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFG44GetInfo(djvupure_chunk_t *fg44, uint16_t *width, uint16_t *height); // Only first chunk of image has size
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFG44Decode(djvupure_chunk_t *page, uint16_t width, uint16_t height, void *buf); // Decodes all FG44 chunks of page
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBG44CheckSign(const uint8_t sign[4]);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBG44Is(djvupure_chunk_t *bg44);
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBG44GetInfo(djvupure_chunk_t *bg44, uint16_t *width, uint16_t *height); // Only first chunk of image has size
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBG44Decode(djvupure_chunk_t *page, uint16_t width, uint16_t height, void *buf); // Decodes all BG44 chunks of page
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageRotate(uint16_t old_width, uint16_t old_height, uint16_t new_width, uint16_t new_height, uint8_t channels, uint8_t rot, uint8_t *buffer);
+// Same as djvupureImageRotate, but width*height image is rotated from src to dst, so nothing is allocated. Buffers must not overlap
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageRotateCopy(uint16_t width, uint16_t height, const uint8_t *src, uint8_t *dst, uint8_t channels, uint8_t rot);
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageResizeFine(uint16_t old_width, uint16_t old_height, const uint8_t *old_buffer, uint16_t new_width, uint16_t new_height, uint8_t *new_buffer, uint8_t channels);
 
 #ifdef __cplusplus
@@ -38,6 +38,7 @@ extern "C" {
 
 extern bool ppmSave(unsigned int sizex, unsigned int sizey, unsigned int channels, const unsigned char *buf, FILE *f);
 extern bool pamSave(unsigned int sizex, unsigned int sizey, unsigned int channels, const unsigned char *buf, FILE *f);
+// buf holds packed rows of (sizex+7)/8 bytes, 1 is black and most significant bit is left pixel
 extern bool pbmSave(unsigned int sizex, unsigned int sizey, const unsigned char *buf, FILE *f);
 
 #ifdef __cplusplus
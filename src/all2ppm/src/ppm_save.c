@@ -89,45 +89,18 @@ bool pamSave(unsigned int sizex, unsigned int sizey, unsigned int channels, cons
 
 bool pbmSave(unsigned int sizex, unsigned int sizey, const unsigned char *buf, FILE *f)
 {
-	unsigned char *filebuf, *p;
-	size_t fileline, filesize, i, j;
+	size_t fileline;
 
 	if(sizex == 0 || sizey == 0) return false;
 	if(!buf || !f) return false;
 
-	fileline = (size_t)sizex/8;
-	if((size_t)sizex%8 > 0) fileline++;
-	
+	fileline = ((size_t)sizex+7)/8;
+
 	if((SIZE_MAX / sizey) <= fileline) return false;
-	
-	filesize = fileline*(size_t)sizey;
-
-	filebuf = malloc(filesize);
-	if(!filebuf) return false;
-
-	p = filebuf;
-	for(i = 0; i < (size_t)sizey; i++) {
-		unsigned char b;
-		size_t k;
-		
-		k = 0;
-		b = 0;
-		for(j = 0; j < (size_t)sizex; j++, k++) {
-			if(k == 8) {
-				k = 0;
-				*(p++) = b;
-				b = 0;
-			}
-			if(buf[i*sizex+j] < 128)
-				b |= 1<<(7-k);
-		}
-		if(k > 0) *(p++) = b;
-	}	
 
+	// Rows of buf are already packed as in file
 	fprintf(f, "P4\n%u %u\n", sizex, sizey);
-	fwrite(filebuf, filesize, 1, f);
-
-	free(filebuf);
+	fwrite(buf, fileline*(size_t)sizey, 1, f);
 
  	return true;
 }
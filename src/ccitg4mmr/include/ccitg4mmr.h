@@ -43,8 +43,43 @@ extern "C" {
 #endif
 
 typedef void * (MMR_APIENTRY *mmr_malloc_t)(size_t size);
+typedef void (MMR_APIENTRY *mmr_free_t)(void *ptr);
 
-extern bool mmrDecode(uint8_t *buf, size_t bufsize, size_t *width, size_t *height, uint8_t **out_buf, mmr_malloc_t mmr_malloc);
+// Streaming decoder state, rows are decoded from top to bottom
+typedef struct {
+	const uint8_t *buf;
+	size_t pos; // Next byte to be loaded into bits
+	size_t data_end; // End of current stripe
+	size_t bufsize;
+	uint64_t bits; // Bit buffer, next bit is msb
+	unsigned int nof_bits;
+	unsigned int nof_padding_bits; // Zero bits loaded past data_end
+	size_t width;
+	size_t height;
+	size_t row; // Next row to be decoded
+	size_t rows_per_stripe;
+	size_t stripe_row;
+	bool is_striped;
+	bool is_inverted;
+	// Changing elements of previous and current rows, first run is white
+	uint32_t *ref_line;
+	uint32_t *cur_line;
+	size_t nof_ref_changes;
+} mmr_decoder_t;
+
+// Parses DjVu MMR header
+extern bool mmrParseHeader(const uint8_t *buf, size_t bufsize, size_t *width, size_t *height);
+// Size of memory for changing elements, it should be passed to mmrDecoderInit
+extern size_t mmrGetLinesSize(size_t width);
+extern bool mmrDecoderInit(mmr_decoder_t *mmr, const uint8_t *buf, size_t bufsize, void *lines);
+// Skips rows, whole stripes are skipped without decoding
+extern bool mmrSkipRows(mmr_decoder_t *mmr, size_t nof_rows);
+// Decode next row and write pixels from x to x+width as packed bits (1 is black, msb is left pixel)
+extern bool mmrDecodeRowBits(mmr_decoder_t *mmr, size_t x, size_t width, uint8_t *bits);
+// Decode next row and write pixels from x to x+width as bytes
+extern bool mmrDecodeRowBytes(mmr_decoder_t *mmr, size_t x, size_t width, uint8_t black, uint8_t white, uint8_t *row);
+// Decodes whole image as packed bits with stride (width+7)/8, out_buf should be freed by caller
+extern bool mmrDecode(uint8_t *buf, size_t bufsize, size_t *width, size_t *height, uint8_t **out_buf, mmr_malloc_t mmr_malloc, mmr_free_t mmr_free);
 
 #ifdef __cplusplus
 }
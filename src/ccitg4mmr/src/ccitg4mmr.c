@@ -26,15 +26,387 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "../include/ccitg4mmr.h"
+#include "ccitg4mmr_tables.h"
 
-bool mmrDecode(uint8_t *buf, size_t bufsize, size_t *width, size_t *height, uint8_t **out_buf, mmr_malloc_t mmr_malloc)
+#include <string.h>
+
+#define MMR_FLAGS_INVERTED 0x1
+#define MMR_FLAGS_STRIPED 0x2
+
+#define MMR_HEADER_SIZE 8
+
+static bool MMRParseHeader(const uint8_t *buf, size_t bufsize, size_t *width, size_t *height, uint8_t *flags)
+{
+	if(bufsize < MMR_HEADER_SIZE) return false;
+	if(buf[0] != 'M' || buf[1] != 'M' || buf[2] != 'R') return false;
+	if(buf[3]&0xFC) return false;
+
+	*width = (size_t)buf[4]*256+buf[5];
+	*height = (size_t)buf[6]*256+buf[7];
+	if(flags) *flags = buf[3];
+
+	return true;
+}
+
+bool mmrParseHeader(const uint8_t *buf, size_t bufsize, size_t *width, size_t *height)
 {
-	(void)buf;
-	(void)bufsize;
+	return MMRParseHeader(buf, bufsize, width, height, 0);
+}
+
+size_t mmrGetLinesSize(size_t width)
+{
+	// Each line holds up to width changes and 3 sentinels
+	return 2*(width+3)*sizeof(uint32_t);
+}
+
+static void MMRResetRefLine(mmr_decoder_t *mmr)
+{
+	mmr->ref_line[0] = mmr->ref_line[1] = mmr->ref_line[2] = (uint32_t)mmr->width;
+	mmr->nof_ref_changes = 0;
+}
+
+static void MMRLoadBits(mmr_decoder_t *mmr)
+{
+	// Whole bytes are loaded while they fit into bit buffer, data ends with zero padding
+	while(mmr->nof_bits <= 56) {
+		uint64_t byte = 0;
+
+		if(mmr->pos < mmr->data_end)
+			byte = mmr->buf[mmr->pos++];
+		else
+			mmr->nof_padding_bits += 8;
+
+		mmr->bits |= byte<<(56-mmr->nof_bits);
+		mmr->nof_bits += 8;
+	}
+}
+
+static void MMRSkipBits(mmr_decoder_t *mmr, unsigned int nof_bits)
+{
+	mmr->bits <<= nof_bits;
+	mmr->nof_bits -= nof_bits;
+}
+
+static bool MMRNextStripe(mmr_decoder_t *mmr)
+{
+	size_t stripe_size;
+
+	// Rest of previous stripe is skipped
+	mmr->pos = mmr->data_end;
+	if(mmr->bufsize-mmr->pos < 4) return false;
+
+	stripe_size = ((size_t)mmr->buf[mmr->pos]<<24)+((size_t)mmr->buf[mmr->pos+1]<<16)+((size_t)mmr->buf[mmr->pos+2]<<8)+mmr->buf[mmr->pos+3];
+	mmr->pos += 4;
+	if(stripe_size > mmr->bufsize-mmr->pos) stripe_size = mmr->bufsize-mmr->pos;
+	mmr->data_end = mmr->pos+stripe_size;
+
+	mmr->bits = 0;
+	mmr->nof_bits = 0;
+	mmr->nof_padding_bits = 0;
+	mmr->stripe_row = 0;
+	MMRResetRefLine(mmr);
+
+	return true;
+}
+
+bool mmrDecoderInit(mmr_decoder_t *mmr, const uint8_t *buf, size_t bufsize, void *lines)
+{
+	uint8_t flags;
+
+	memset(mmr, 0, sizeof(mmr_decoder_t));
+
+	if(!MMRParseHeader(buf, bufsize, &mmr->width, &mmr->height, &flags)) return false;
+
+	mmr->buf = buf;
+	mmr->bufsize = bufsize;
+	mmr->is_inverted = (flags&MMR_FLAGS_INVERTED)?true:false;
+	mmr->is_striped = (flags&MMR_FLAGS_STRIPED)?true:false;
+	mmr->ref_line = (uint32_t *)lines;
+	mmr->cur_line = mmr->ref_line+mmr->width+3;
+
+	if(mmr->is_striped) {
+		if(bufsize < MMR_HEADER_SIZE+2) return false;
+
+		mmr->rows_per_stripe = (size_t)buf[MMR_HEADER_SIZE]*256+buf[MMR_HEADER_SIZE+1];
+		if(!mmr->rows_per_stripe) return false;
+
+		// First stripe is read before first row
+		mmr->data_end = MMR_HEADER_SIZE+2;
+		mmr->stripe_row = mmr->rows_per_stripe;
+	} else {
+		mmr->rows_per_stripe = mmr->height;
+		mmr->pos = MMR_HEADER_SIZE;
+		mmr->data_end = bufsize;
+		MMRResetRefLine(mmr);
+	}
+
+	return true;
+}
+
+static bool MMRDecodeRun(mmr_decoder_t *mmr, const mmr_run_code_t *codes, uint32_t *run)
+{
+	const mmr_run_code_t *code;
+
+	*run = 0;
+
+	// Makeup codes are followed by terminating code
+	do {
+		MMRLoadBits(mmr);
+
+		code = codes+(mmr->bits>>56);
+		if(code->next)
+			code = codes+code->run+((mmr->bits>>(56-code->next))&((1u<<code->next)-1));
+		if(!code->len) return false;
+
+		MMRSkipBits(mmr, code->len);
+
+		*run += code->run;
+		if(*run > mmr->width) return false;
+	} while(code->run >= 64);
+
+	return true;
+}
+
+static bool MMRAddChange(mmr_decoder_t *mmr, size_t *nof_changes, uint32_t pos)
+{
+	// Changes at end of row are implied
+	if(pos >= mmr->width) return true;
+
+	// Zero length run cancels previous change
+	if(*nof_changes && mmr->cur_line[*nof_changes-1] == pos) {
+		(*nof_changes)--;
+
+		return true;
+	}
+
+	if(*nof_changes && mmr->cur_line[*nof_changes-1] > pos) return false;
+	if(*nof_changes >= mmr->width) return false;
+
+	mmr->cur_line[(*nof_changes)++] = pos;
+
+	return true;
+}
+
+// Decodes next row into changing elements of cur_line, then it becomes reference line
+static bool MMRDecodeChanges(mmr_decoder_t *mmr)
+{
+	const uint32_t *ref;
+	uint32_t *temp;
+	size_t nof_changes = 0, ref_pos = 0;
+	int64_t a0 = -1;
+	unsigned int color = 0;
+
+	if(mmr->row >= mmr->height) return false;
+	if(mmr->stripe_row == mmr->rows_per_stripe)
+		if(!MMRNextStripe(mmr)) return false;
+
+	ref = mmr->ref_line;
+
+	while(a0 < (int64_t)mmr->width) {
+		const mmr_mode_code_t *mode;
+		uint32_t b1, b2, a1, a2, run1, run2;
+		int delta = 0;
+
+		// b1 is first change on reference line after a0 to opposite color, even changes are to black
+		while((int64_t)ref[ref_pos] <= a0) ref_pos++;
+		if((ref_pos&1) != color) ref_pos++;
+		b1 = ref[ref_pos];
+		b2 = ref[ref_pos+1];
+
+		MMRLoadBits(mmr);
+
+		mode = mmr_mode_codes+(mmr->bits>>57);
+
+		MMRSkipBits(mmr, mode->len);
+
+		switch(mode->mode) {
+			case MMR_MODE_P:
+				a0 = b2;
+				ref_pos += 2;
+				continue;
+			case MMR_MODE_H:
+				if(!MMRDecodeRun(mmr, color?mmr_black_codes:mmr_white_codes, &run1)) return false;
+				if(!MMRDecodeRun(mmr, color?mmr_white_codes:mmr_black_codes, &run2)) return false;
+
+				a1 = (uint32_t)(a0 < 0?0:a0)+run1;
+				a2 = a1+run2;
+				if(!MMRAddChange(mmr, &nof_changes, a1)) return false;
+				if(!MMRAddChange(mmr, &nof_changes, a2)) return false;
+
+				a0 = a2;
+				continue;
+			case MMR_MODE_V0:
+				break;
+			case MMR_MODE_VR1:
+				delta = 1;
+				break;
+			case MMR_MODE_VR2:
+				delta = 2;
+				break;
+			case MMR_MODE_VR3:
+				delta = 3;
+				break;
+			case MMR_MODE_VL1:
+				delta = -1;
+				break;
+			case MMR_MODE_VL2:
+				delta = -2;
+				break;
+			case MMR_MODE_VL3:
+				delta = -3;
+				break;
+			default:
+				return false;
+		}
+
+		// Vertical modes
+		if((int64_t)b1+delta < (a0 < 0?0:a0) || (int64_t)b1+delta > (int64_t)mmr->width) return false;
+
+		a1 = (uint32_t)((int64_t)b1+delta);
+		if(!MMRAddChange(mmr, &nof_changes, a1)) return false;
+
+		a0 = a1;
+		color ^= 1;
+		if(ref_pos) ref_pos--;
+	}
+
+	// Data ended in the middle of row
+	if(mmr->nof_padding_bits > mmr->nof_bits) return false;
+
+	temp = mmr->ref_line;
+	mmr->ref_line = mmr->cur_line;
+	mmr->cur_line = temp;
+	mmr->ref_line[nof_changes] = mmr->ref_line[nof_changes+1] = mmr->ref_line[nof_changes+2] = (uint32_t)mmr->width;
+	mmr->nof_ref_changes = nof_changes;
+
+	mmr->row++;
+	mmr->stripe_row++;
+
+	return true;
+}
+
+bool mmrSkipRows(mmr_decoder_t *mmr, size_t nof_rows)
+{
+	if(nof_rows > mmr->height-mmr->row) return false;
+
+	while(nof_rows) {
+		if(mmr->is_striped && mmr->stripe_row == mmr->rows_per_stripe && nof_rows >= mmr->rows_per_stripe) {
+			if(!MMRNextStripe(mmr)) return false;
+
+			mmr->stripe_row = mmr->rows_per_stripe;
+			mmr->row += mmr->rows_per_stripe;
+			nof_rows -= mmr->rows_per_stripe;
+
+			continue;
+		}
+
+		if(!MMRDecodeChanges(mmr)) return false;
+
+		nof_rows--;
+	}
+
+	return true;
+}
+
+static void MMRFillBits(uint8_t *bits, size_t from, size_t to)
+{
+	size_t first, last;
+	uint8_t first_mask, last_mask;
+
+	first = from>>3;
+	last = (to-1)>>3;
+	first_mask = (uint8_t)(0xFF>>(from&7));
+	last_mask = (uint8_t)(0xFF<<(7-((to-1)&7)));
+
+	if(first == last)
+		bits[first] |= first_mask&last_mask;
+	else {
+		bits[first] |= first_mask;
+		memset(bits+first+1, 0xFF, last-first-1);
+		bits[last] |= last_mask;
+	}
+}
+
+bool mmrDecodeRowBits(mmr_decoder_t *mmr, size_t x, size_t width, uint8_t *bits)
+{
+	size_t start = 0, end = 0;
+	bool is_black;
+
+	if(x > mmr->width || width > mmr->width-x) return false;
+	if(!MMRDecodeChanges(mmr)) return false;
+
+	memset(bits, 0, (width+7)/8);
+
+	is_black = mmr->is_inverted;
+	for(size_t i = 0; i <= mmr->nof_ref_changes; i++, start = end, is_black = !is_black) {
+		end = mmr->ref_line[i];
+
+		// Only black runs in region are filled
+		if(!is_black || end <= x || start >= x+width) continue;
+
+		MMRFillBits(bits, (start > x?start:x)-x, (end < x+width?end:x+width)-x);
+	}
+
+	return true;
+}
+
+bool mmrDecodeRowBytes(mmr_decoder_t *mmr, size_t x, size_t width, uint8_t black, uint8_t white, uint8_t *row)
+{
+	size_t start = 0, end = 0;
+	bool is_black;
+
+	if(x > mmr->width || width > mmr->width-x) return false;
+	if(!MMRDecodeChanges(mmr)) return false;
+
+	memset(row, white, width);
+
+	is_black = mmr->is_inverted;
+	for(size_t i = 0; i <= mmr->nof_ref_changes; i++, start = end, is_black = !is_black) {
+		size_t from, to;
+
+		end = mmr->ref_line[i];
+
+		if(!is_black || end <= x || start >= x+width) continue;
+
+		from = (start > x?start:x)-x;
+		to = (end < x+width?end:x+width)-x;
+		memset(row+from, black, to-from);
+	}
+
+	return true;
+}
+
+bool mmrDecode(uint8_t *buf, size_t bufsize, size_t *width, size_t *height, uint8_t **out_buf, mmr_malloc_t mmr_malloc, mmr_free_t mmr_free)
+{
+	mmr_decoder_t mmr;
+	size_t stride, image_size;
+	uint8_t *image;
 
 	*width = 0;
 	*height = 0;
 	*out_buf = 0;
 
+	if(!MMRParseHeader(buf, bufsize, width, height, 0)) return false;
+
+	stride = (*width+7)/8;
+	image_size = stride*(*height);
+	image_size = (image_size+sizeof(uint32_t)-1)/sizeof(uint32_t)*sizeof(uint32_t);
+
+	// Changing elements are stored after image, so caller frees only one buffer
+	image = mmr_malloc(image_size+mmrGetLinesSize(*width));
+	if(!image) return false;
+
+	if(!mmrDecoderInit(&mmr, buf, bufsize, image+image_size)) goto FAILURE;
+
+	for(size_t row = 0; row < *height; row++)
+		if(!mmrDecodeRowBits(&mmr, 0, *width, image+row*stride)) goto FAILURE;
+
+	*out_buf = image;
+
+	return true;
+
+FAILURE:
+	mmr_free(image);
+
 	return false;
-}
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*Code tables for G4 decoder, derived from ITU-T T.4 and T.6*/
+
+#ifndef CCITG4MMR_TABLES_H
+#define CCITG4MMR_TABLES_H
+
+enum {
+	MMR_MODE_INVALID,
+	MMR_MODE_P,
+	MMR_MODE_H,
+	MMR_MODE_V0,
+	MMR_MODE_VR1,
+	MMR_MODE_VR2,
+	MMR_MODE_VR3,
+	MMR_MODE_VL1,
+	MMR_MODE_VL2,
+	MMR_MODE_VL3
+};
+
+// Indexed by next 7 bits
+typedef struct {
+	uint8_t mode;
+	uint8_t len;
+} mmr_mode_code_t;
+
+// First 256 entries are indexed by next 8 bits. If next is not zero, then code is looked up
+// in second level table at offset run, indexed by next bits after first 8 bits
+typedef struct {
+	uint16_t run;
+	uint8_t len;
+	uint8_t next;
+} mmr_run_code_t;
+
+static const mmr_mode_code_t mmr_mode_codes[128] = {
+	{MMR_MODE_INVALID, 0}, {MMR_MODE_INVALID, 0}, {MMR_MODE_VL3, 7}, {MMR_MODE_VR3, 7},
+	{MMR_MODE_VL2, 6}, {MMR_MODE_VL2, 6}, {MMR_MODE_VR2, 6}, {MMR_MODE_VR2, 6},
+	{MMR_MODE_P, 4}, {MMR_MODE_P, 4}, {MMR_MODE_P, 4}, {MMR_MODE_P, 4},
+	{MMR_MODE_P, 4}, {MMR_MODE_P, 4}, {MMR_MODE_P, 4}, {MMR_MODE_P, 4},
+	{MMR_MODE_H, 3}, {MMR_MODE_H, 3}, {MMR_MODE_H, 3}, {MMR_MODE_H, 3},
+	{MMR_MODE_H, 3}, {MMR_MODE_H, 3}, {MMR_MODE_H, 3}, {MMR_MODE_H, 3},
+	{MMR_MODE_H, 3}, {MMR_MODE_H, 3}, {MMR_MODE_H, 3}, {MMR_MODE_H, 3},
+	{MMR_MODE_H, 3}, {MMR_MODE_H, 3}, {MMR_MODE_H, 3}, {MMR_MODE_H, 3},
+	{MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3},
+	{MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3},
+	{MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3},
+	{MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3}, {MMR_MODE_VL1, 3},
+	{MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3},
+	{MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3},
+	{MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3},
+	{MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3}, {MMR_MODE_VR1, 3},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1},
+	{MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}, {MMR_MODE_V0, 1}
+};
+
+static const mmr_run_code_t mmr_white_codes[288] = {
+	{0, 0, 0}, {256, 0, 4}, {29, 8, 0}, {30, 8, 0}, {45, 8, 0}, {46, 8, 0}, {22, 7, 0}, {22, 7, 0},
+	{23, 7, 0}, {23, 7, 0}, {47, 8, 0}, {48, 8, 0}, {13, 6, 0}, {13, 6, 0}, {13, 6, 0}, {13, 6, 0},
+	{20, 7, 0}, {20, 7, 0}, {33, 8, 0}, {34, 8, 0}, {35, 8, 0}, {36, 8, 0}, {37, 8, 0}, {38, 8, 0},
+	{19, 7, 0}, {19, 7, 0}, {31, 8, 0}, {32, 8, 0}, {1, 6, 0}, {1, 6, 0}, {1, 6, 0}, {1, 6, 0},
+	{12, 6, 0}, {12, 6, 0}, {12, 6, 0}, {12, 6, 0}, {53, 8, 0}, {54, 8, 0}, {26, 7, 0}, {26, 7, 0},
+	{39, 8, 0}, {40, 8, 0}, {41, 8, 0}, {42, 8, 0}, {43, 8, 0}, {44, 8, 0}, {21, 7, 0}, {21, 7, 0},
+	{28, 7, 0}, {28, 7, 0}, {61, 8, 0}, {62, 8, 0}, {63, 8, 0}, {0, 8, 0}, {320, 8, 0}, {384, 8, 0},
+	{10, 5, 0}, {10, 5, 0}, {10, 5, 0}, {10, 5, 0}, {10, 5, 0}, {10, 5, 0}, {10, 5, 0}, {10, 5, 0},
+	{11, 5, 0}, {11, 5, 0}, {11, 5, 0}, {11, 5, 0}, {11, 5, 0}, {11, 5, 0}, {11, 5, 0}, {11, 5, 0},
+	{27, 7, 0}, {27, 7, 0}, {59, 8, 0}, {60, 8, 0}, {272, 0, 1}, {274, 0, 1}, {18, 7, 0}, {18, 7, 0},
+	{24, 7, 0}, {24, 7, 0}, {49, 8, 0}, {50, 8, 0}, {51, 8, 0}, {52, 8, 0}, {25, 7, 0}, {25, 7, 0},
+	{55, 8, 0}, {56, 8, 0}, {57, 8, 0}, {58, 8, 0}, {192, 6, 0}, {192, 6, 0}, {192, 6, 0}, {192, 6, 0},
+	{1664, 6, 0}, {1664, 6, 0}, {1664, 6, 0}, {1664, 6, 0}, {448, 8, 0}, {512, 8, 0}, {276, 0, 1}, {640, 8, 0},
+	{576, 8, 0}, {278, 0, 1}, {280, 0, 1}, {282, 0, 1}, {284, 0, 1}, {286, 0, 1}, {256, 7, 0}, {256, 7, 0},
+	{2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0},
+	{2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0}, {2, 4, 0},
+	{3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0},
+	{3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0}, {3, 4, 0},
+	{128, 5, 0}, {128, 5, 0}, {128, 5, 0}, {128, 5, 0}, {128, 5, 0}, {128, 5, 0}, {128, 5, 0}, {128, 5, 0},
+	{8, 5, 0}, {8, 5, 0}, {8, 5, 0}, {8, 5, 0}, {8, 5, 0}, {8, 5, 0}, {8, 5, 0}, {8, 5, 0},
+	{9, 5, 0}, {9, 5, 0}, {9, 5, 0}, {9, 5, 0}, {9, 5, 0}, {9, 5, 0}, {9, 5, 0}, {9, 5, 0},
+	{16, 6, 0}, {16, 6, 0}, {16, 6, 0}, {16, 6, 0}, {17, 6, 0}, {17, 6, 0}, {17, 6, 0}, {17, 6, 0},
+	{4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0},
+	{4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0}, {4, 4, 0},
+	{5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0},
+	{5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0},
+	{14, 6, 0}, {14, 6, 0}, {14, 6, 0}, {14, 6, 0}, {15, 6, 0}, {15, 6, 0}, {15, 6, 0}, {15, 6, 0},
+	{64, 5, 0}, {64, 5, 0}, {64, 5, 0}, {64, 5, 0}, {64, 5, 0}, {64, 5, 0}, {64, 5, 0}, {64, 5, 0},
+	{6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0},
+	{6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0},
+	{7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0},
+	{7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0}, {7, 4, 0},
+	{1792, 11, 0}, {1792, 11, 0}, {1984, 12, 0}, {2048, 12, 0}, {2112, 12, 0}, {2176, 12, 0}, {2240, 12, 0}, {2304, 12, 0},
+	{1856, 11, 0}, {1856, 11, 0}, {1920, 11, 0}, {1920, 11, 0}, {2368, 12, 0}, {2432, 12, 0}, {2496, 12, 0}, {2560, 12, 0},
+	{1472, 9, 0}, {1536, 9, 0}, {1600, 9, 0}, {1728, 9, 0}, {704, 9, 0}, {768, 9, 0}, {832, 9, 0}, {896, 9, 0},
+	{960, 9, 0}, {1024, 9, 0}, {1088, 9, 0}, {1152, 9, 0}, {1216, 9, 0}, {1280, 9, 0}, {1344, 9, 0}, {1408, 9, 0}
+};
+
+static const mmr_run_code_t mmr_black_codes[400] = {
+	{0, 0, 0}, {256, 0, 4}, {272, 0, 5}, {304, 0, 5}, {13, 8, 0}, {336, 0, 4}, {352, 0, 4}, {14, 8, 0},
+	{10, 7, 0}, {10, 7, 0}, {11, 7, 0}, {11, 7, 0}, {368, 0, 4}, {384, 0, 4}, {12, 7, 0}, {12, 7, 0},
+	{9, 6, 0}, {9, 6, 0}, {9, 6, 0}, {9, 6, 0}, {8, 6, 0}, {8, 6, 0}, {8, 6, 0}, {8, 6, 0},
+	{7, 5, 0}, {7, 5, 0}, {7, 5, 0}, {7, 5, 0}, {7, 5, 0}, {7, 5, 0}, {7, 5, 0}, {7, 5, 0},
+	{6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0},
+	{6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0}, {6, 4, 0},
+	{5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0},
+	{5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0}, {5, 4, 0},
+	{1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0},
+	{1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0},
+	{1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0},
+	{1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0}, {1, 3, 0},
+	{4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0},
+	{4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0},
+	{4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0},
+	{4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0}, {4, 3, 0},
+	{3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0},
+	{3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0},
+	{3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0},
+	{3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0},
+	{3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0},
+	{3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0},
+	{3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0},
+	{3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0}, {3, 2, 0},
+	{2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0},
+	{2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0},
+	{2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0},
+	{2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0},
+	{2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0},
+	{2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0},
+	{2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0},
+	{2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0}, {2, 2, 0},
+	{1792, 11, 0}, {1792, 11, 0}, {1984, 12, 0}, {2048, 12, 0}, {2112, 12, 0}, {2176, 12, 0}, {2240, 12, 0}, {2304, 12, 0},
+	{1856, 11, 0}, {1856, 11, 0}, {1920, 11, 0}, {1920, 11, 0}, {2368, 12, 0}, {2432, 12, 0}, {2496, 12, 0}, {2560, 12, 0},
+	{18, 10, 0}, {18, 10, 0}, {18, 10, 0}, {18, 10, 0}, {18, 10, 0}, {18, 10, 0}, {18, 10, 0}, {18, 10, 0},
+	{52, 12, 0}, {52, 12, 0}, {640, 13, 0}, {704, 13, 0}, {768, 13, 0}, {832, 13, 0}, {55, 12, 0}, {55, 12, 0},
+	{56, 12, 0}, {56, 12, 0}, {1280, 13, 0}, {1344, 13, 0}, {1408, 13, 0}, {1472, 13, 0}, {59, 12, 0}, {59, 12, 0},
+	{60, 12, 0}, {60, 12, 0}, {1536, 13, 0}, {1600, 13, 0}, {24, 11, 0}, {24, 11, 0}, {24, 11, 0}, {24, 11, 0},
+	{25, 11, 0}, {25, 11, 0}, {25, 11, 0}, {25, 11, 0}, {1664, 13, 0}, {1728, 13, 0}, {320, 12, 0}, {320, 12, 0},
+	{384, 12, 0}, {384, 12, 0}, {448, 12, 0}, {448, 12, 0}, {512, 13, 0}, {576, 13, 0}, {53, 12, 0}, {53, 12, 0},
+	{54, 12, 0}, {54, 12, 0}, {896, 13, 0}, {960, 13, 0}, {1024, 13, 0}, {1088, 13, 0}, {1152, 13, 0}, {1216, 13, 0},
+	{64, 10, 0}, {64, 10, 0}, {64, 10, 0}, {64, 10, 0}, {64, 10, 0}, {64, 10, 0}, {64, 10, 0}, {64, 10, 0},
+	{23, 11, 0}, {23, 11, 0}, {50, 12, 0}, {51, 12, 0}, {44, 12, 0}, {45, 12, 0}, {46, 12, 0}, {47, 12, 0},
+	{57, 12, 0}, {58, 12, 0}, {61, 12, 0}, {256, 12, 0}, {16, 10, 0}, {16, 10, 0}, {16, 10, 0}, {16, 10, 0},
+	{17, 10, 0}, {17, 10, 0}, {17, 10, 0}, {17, 10, 0}, {48, 12, 0}, {49, 12, 0}, {62, 12, 0}, {63, 12, 0},
+	{30, 12, 0}, {31, 12, 0}, {32, 12, 0}, {33, 12, 0}, {40, 12, 0}, {41, 12, 0}, {22, 11, 0}, {22, 11, 0},
+	{15, 9, 0}, {15, 9, 0}, {15, 9, 0}, {15, 9, 0}, {15, 9, 0}, {15, 9, 0}, {15, 9, 0}, {15, 9, 0},
+	{128, 12, 0}, {192, 12, 0}, {26, 12, 0}, {27, 12, 0}, {28, 12, 0}, {29, 12, 0}, {19, 11, 0}, {19, 11, 0},
+	{20, 11, 0}, {20, 11, 0}, {34, 12, 0}, {35, 12, 0}, {36, 12, 0}, {37, 12, 0}, {38, 12, 0}, {39, 12, 0},
+	{21, 11, 0}, {21, 11, 0}, {42, 12, 0}, {43, 12, 0}, {0, 10, 0}, {0, 10, 0}, {0, 10, 0}, {0, 10, 0}
+};
+
+#endif
\ No newline at end of file
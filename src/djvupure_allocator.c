@@ -0,0 +1,90 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../include/djvupure.h"
+#include "djvupure_allocator.h"
+
+#include <stdlib.h>
+
+DJVUPURE_API uint32_t DJVUPURE_APIENTRY_EXPORT djvupureAllocatorGetStructHash(void)
+{
+	return (uint32_t)(sizeof(djvupure_allocator_t)%(UINT16_MAX+1))*(UINT16_MAX+1)+DJVUPURE_VERSION_MAJOR%(UINT16_MAX+1);
+}
+
+static void * DJVUPURE_APIENTRY djvupureAllocatorDefaultAlloc(void *user, size_t size)
+{
+	(void)user;
+
+	return malloc(size?size:1);
+}
+
+static void * DJVUPURE_APIENTRY djvupureAllocatorDefaultRealloc(void *user, void *ptr, size_t size)
+{
+	(void)user;
+
+	return realloc(ptr, size?size:1);
+}
+
+static void DJVUPURE_APIENTRY djvupureAllocatorDefaultFree(void *user, void *ptr)
+{
+	(void)user;
+
+	free(ptr);
+}
+
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureAllocatorSetDefault(djvupure_allocator_t *allocator)
+{
+	allocator->hash = djvupureAllocatorGetStructHash();
+	allocator->callback_alloc = djvupureAllocatorDefaultAlloc;
+	allocator->callback_realloc = djvupureAllocatorDefaultRealloc;
+	allocator->callback_free = djvupureAllocatorDefaultFree;
+	allocator->user = 0;
+}
+
+void * DJVUPURE_APIENTRY AllocatorAlloc(djvupure_allocator_t *allocator, size_t size)
+{
+	if(!allocator) return malloc(size?size:1);
+
+	return allocator->callback_alloc(allocator->user, size?size:1);
+}
+
+void * DJVUPURE_APIENTRY AllocatorRealloc(djvupure_allocator_t *allocator, void *ptr, size_t size)
+{
+	if(!allocator) return realloc(ptr, size?size:1);
+
+	if(!ptr) return allocator->callback_alloc(allocator->user, size?size:1);
+
+	return allocator->callback_realloc(allocator->user, ptr, size?size:1);
+}
+
+void DJVUPURE_APIENTRY AllocatorFree(djvupure_allocator_t *allocator, void *ptr)
+{
+	if(!ptr) return;
+
+	if(!allocator) free(ptr);
+	else allocator->callback_free(allocator->user, ptr);
+}
\ No newline at end of file
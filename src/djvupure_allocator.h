@@ -0,0 +1,48 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*Internal module for allocations with user allocator*/
+
+#ifndef DJVUPURE_ALLOCATOR_H
+#define DJVUPURE_ALLOCATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+
+// If allocator is 0, functions below work like malloc, realloc and free
+void * DJVUPURE_APIENTRY AllocatorAlloc(djvupure_allocator_t *allocator, size_t size);
+void * DJVUPURE_APIENTRY AllocatorRealloc(djvupure_allocator_t *allocator, void *ptr, size_t size);
+void DJVUPURE_APIENTRY AllocatorFree(djvupure_allocator_t *allocator, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
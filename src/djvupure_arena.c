@@ -0,0 +1,228 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "djvupure_arena.h"
+#include "djvupure_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+	DJVUPURE_ARENA_ALIGN = 16,
+	DJVUPURE_ARENA_MIN_SLAB = 65536,
+	DJVUPURE_ARENA_MAX_SLAB = 16777216
+};
+
+typedef struct djvupure_arena_slab_t {
+	struct djvupure_arena_slab_t *next;
+	size_t size;
+	size_t used;
+	size_t last; // Offset of the last allocation, it can be resized in place
+} djvupure_arena_slab_t;
+
+struct djvupure_arena_t {
+	djvupure_arena_slab_t *slabs; // Current slab is first
+	size_t next_slab_size;
+	size_t nof_chunks;
+	size_t nof_allocchunks;
+	djvupure_chunk_t **chunks;
+	djvupure_allocator_t allocator;
+	bool has_allocator;
+};
+
+// Slab header is padded so data stays aligned
+#define DJVUPURE_ARENA_SLAB_HEADER ((sizeof(djvupure_arena_slab_t)+DJVUPURE_ARENA_ALIGN-1)/DJVUPURE_ARENA_ALIGN*DJVUPURE_ARENA_ALIGN)
+
+djvupure_arena_t * DJVUPURE_APIENTRY ArenaCreate(djvupure_allocator_t *allocator)
+{
+	djvupure_arena_t *arena;
+
+	arena = AllocatorAlloc(allocator, sizeof(djvupure_arena_t));
+	if(!arena) return 0;
+
+	memset(arena, 0, sizeof(djvupure_arena_t));
+	arena->next_slab_size = DJVUPURE_ARENA_MIN_SLAB;
+	if(allocator) {
+		arena->allocator = *allocator;
+		arena->has_allocator = true;
+	}
+
+	return arena;
+}
+
+djvupure_allocator_t * DJVUPURE_APIENTRY ArenaGetAllocator(djvupure_arena_t *arena)
+{
+	if(!arena || !arena->has_allocator) return 0;
+
+	return &(arena->allocator);
+}
+
+void DJVUPURE_APIENTRY ArenaDestroy(djvupure_arena_t *arena)
+{
+	djvupure_arena_slab_t *slab;
+	djvupure_allocator_t allocator, *p_allocator;
+
+	if(!arena) return;
+
+	// Arena itself is allocated with allocator, so it's copied
+	allocator = arena->allocator;
+	p_allocator = arena->has_allocator?&allocator:0;
+
+	for(size_t i = 0; i < arena->nof_chunks; i++)
+		djvupureChunkFree(arena->chunks[i]);
+	AllocatorFree(p_allocator, arena->chunks);
+
+	slab = arena->slabs;
+	while(slab) {
+		djvupure_arena_slab_t *next;
+
+		next = slab->next;
+		AllocatorFree(p_allocator, slab);
+		slab = next;
+	}
+
+	AllocatorFree(p_allocator, arena);
+}
+
+void * DJVUPURE_APIENTRY ArenaAlloc(djvupure_arena_t *arena, size_t size)
+{
+	djvupure_arena_slab_t *slab;
+	size_t aligned_size;
+
+	if(!arena) return malloc(size?size:1);
+
+	if(size > SIZE_MAX-DJVUPURE_ARENA_ALIGN-DJVUPURE_ARENA_SLAB_HEADER) return 0;
+	aligned_size = (size+DJVUPURE_ARENA_ALIGN-1)/DJVUPURE_ARENA_ALIGN*DJVUPURE_ARENA_ALIGN;
+	if(!aligned_size) aligned_size = DJVUPURE_ARENA_ALIGN;
+
+	slab = arena->slabs;
+	if(!slab || slab->size-slab->used < aligned_size) {
+		size_t slab_size;
+
+		slab_size = arena->next_slab_size;
+		if(slab_size < aligned_size) slab_size = aligned_size;
+
+		slab = AllocatorAlloc(ArenaGetAllocator(arena), DJVUPURE_ARENA_SLAB_HEADER+slab_size);
+		if(!slab) return 0;
+
+		slab->size = slab_size;
+		slab->used = 0;
+		slab->last = 0;
+
+		// Big allocations get their own slab, so current slab remains usable
+		if(arena->slabs && slab_size > arena->next_slab_size) {
+			slab->next = arena->slabs->next;
+			arena->slabs->next = slab;
+		} else {
+			slab->next = arena->slabs;
+			arena->slabs = slab;
+
+			if(arena->next_slab_size < DJVUPURE_ARENA_MAX_SLAB) arena->next_slab_size *= 2;
+		}
+	}
+
+	slab->last = slab->used;
+	slab->used += aligned_size;
+
+	return (uint8_t *)slab+DJVUPURE_ARENA_SLAB_HEADER+slab->last;
+}
+
+void * DJVUPURE_APIENTRY ArenaRealloc(djvupure_arena_t *arena, void *ptr, size_t old_size, size_t size)
+{
+	djvupure_arena_slab_t *slab;
+	void *new_ptr;
+
+	if(!arena) return realloc(ptr, size?size:1);
+
+	if(!ptr) return ArenaAlloc(arena, size);
+
+	// Grow last allocation in place if possible
+	slab = arena->slabs;
+	if(slab && (uint8_t *)ptr == (uint8_t *)slab+DJVUPURE_ARENA_SLAB_HEADER+slab->last && size <= slab->size-slab->last) {
+		size_t aligned_size;
+
+		aligned_size = (size+DJVUPURE_ARENA_ALIGN-1)/DJVUPURE_ARENA_ALIGN*DJVUPURE_ARENA_ALIGN;
+		if(!aligned_size) aligned_size = DJVUPURE_ARENA_ALIGN;
+
+		if(aligned_size <= slab->size-slab->last) {
+			slab->used = slab->last+aligned_size;
+
+			return ptr;
+		}
+	}
+
+	new_ptr = ArenaAlloc(arena, size);
+	if(!new_ptr) return 0;
+
+	memcpy(new_ptr, ptr, (old_size < size)?old_size:size);
+
+	return new_ptr;
+}
+
+void DJVUPURE_APIENTRY ArenaFree(djvupure_arena_t *arena, void *ptr)
+{
+	if(!arena) free(ptr);
+}
+
+static bool djvupureArenaSlabHas(djvupure_arena_slab_t *slab, void *ptr)
+{
+	return (uint8_t *)ptr >= (uint8_t *)slab+DJVUPURE_ARENA_SLAB_HEADER && (uint8_t *)ptr < (uint8_t *)slab+DJVUPURE_ARENA_SLAB_HEADER+slab->used;
+}
+
+bool DJVUPURE_APIENTRY ArenaAddChunk(djvupure_arena_t *arena, djvupure_chunk_t *chunk)
+{
+	djvupure_arena_slab_t *slab;
+
+	// Chunks from arena are freed with it
+	// Chunk is usually just read, so it's in current slab and other slabs aren't walked
+	if(arena->slabs) {
+		if(djvupureArenaSlabHas(arena->slabs, chunk)) return true;
+
+		for(slab = arena->slabs->next; slab; slab = slab->next)
+			if(djvupureArenaSlabHas(slab, chunk)) return true;
+	}
+
+	if(arena->nof_chunks >= arena->nof_allocchunks) {
+		djvupure_chunk_t **_chunks;
+		size_t nof_allocchunks;
+
+		if(arena->nof_allocchunks == 0) nof_allocchunks = 4;
+		else nof_allocchunks = arena->nof_allocchunks*2;
+
+		if(SIZE_MAX/sizeof(void *) < nof_allocchunks) return false;
+
+		_chunks = AllocatorRealloc(ArenaGetAllocator(arena), arena->chunks, nof_allocchunks*sizeof(void *));
+		if(!_chunks) return false;
+
+		arena->chunks = _chunks;
+		arena->nof_allocchunks = nof_allocchunks;
+	}
+
+	arena->chunks[arena->nof_chunks++] = chunk;
+
+	return true;
+}
\ No newline at end of file
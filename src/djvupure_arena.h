@@ -0,0 +1,57 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*Internal module for arena allocation of chunk trees*/
+
+#ifndef DJVUPURE_ARENA_H
+#define DJVUPURE_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+
+typedef struct djvupure_arena_t djvupure_arena_t;
+
+// If allocator is 0, malloc is used. allocator is copied
+djvupure_arena_t * DJVUPURE_APIENTRY ArenaCreate(djvupure_allocator_t *allocator);
+void DJVUPURE_APIENTRY ArenaDestroy(djvupure_arena_t *arena);
+djvupure_allocator_t * DJVUPURE_APIENTRY ArenaGetAllocator(djvupure_arena_t *arena); // Returns 0 if arena uses malloc
+
+// If arena is 0, functions below work like malloc, realloc and free
+void * DJVUPURE_APIENTRY ArenaAlloc(djvupure_arena_t *arena, size_t size);
+void * DJVUPURE_APIENTRY ArenaRealloc(djvupure_arena_t *arena, void *ptr, size_t old_size, size_t size);
+void DJVUPURE_APIENTRY ArenaFree(djvupure_arena_t *arena, void *ptr); // Memory from arena is freed only with arena, it isn't reused before that
+
+// Chunks not allocated from arena, i.e. inserted by user, are freed on arena destruction
+bool DJVUPURE_APIENTRY ArenaAddChunk(djvupure_arena_t *arena, djvupure_chunk_t *chunk);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,218 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../include/djvupure.h"
+#include "djvupure_allocator.h"
+#include "djvupure_read.h"
+#include "djvupure_thread.h"
+
+#include <stdlib.h>
+
+typedef struct {
+	djvupure_chunk_t *document;
+	djvupure_page_sink_t sink;
+	void *sink_ctx;
+	djvupure_io_callback_openu8_t openu8;
+	djvupure_io_callback_close_t close;
+	djvupure_allocator_t *allocator;
+	uint32_t flags; // Renderer flags
+	void *mutex; // Guards fields below and the document tree
+	size_t next_page;
+	size_t end_page;
+	bool is_stopped;
+	bool result;
+} djvupure_batch_t;
+
+static bool djvupureBatchRenderPage(djvupure_batch_t *batch, void *renderer, uint16_t width, uint16_t height, uint8_t channels, uint8_t **buffer, size_t *buffer_size)
+{
+	size_t size, row_size;
+
+	if(channels == 1 && (batch->flags & DJVUPURE_RENDER_FLAG_PACKED_MASK))
+		row_size = ((size_t)width+7)/8;
+	else {
+		if(SIZE_MAX/width < channels) return false;
+
+		row_size = (size_t)width*channels;
+	}
+
+	if(SIZE_MAX/row_size < height) return false;
+
+	size = row_size*height;
+
+	// Buffer is reused between pages of one worker
+	if(size > *buffer_size) {
+		uint8_t *_buffer;
+
+		_buffer = AllocatorRealloc(batch->allocator, *buffer, size);
+		if(!_buffer) return false;
+
+		*buffer = _buffer;
+		*buffer_size = size;
+	}
+
+	while(1) {
+		int step;
+
+		step = djvupurePageImageRendererNext(renderer, *buffer);
+
+		if(step == DJVUPURE_IMAGE_RENDERER_LAST_STAGE) break;
+		else if(step != DJVUPURE_IMAGE_RENDERER_NEXT_STAGE) return false;
+	}
+
+	return true;
+}
+
+static void DJVUPURE_APIENTRY djvupureBatchWorker(void *arg)
+{
+	djvupure_batch_t *batch;
+	void *renderer = 0;
+	uint8_t *buffer = 0;
+	size_t buffer_size = 0;
+
+	batch = (djvupure_batch_t *)arg;
+
+	while(1) {
+		djvupure_chunk_t *page;
+		uint16_t width, height;
+		uint8_t channels;
+		size_t index;
+		bool is_ready = false, is_rendered = false, is_accepted;
+
+		// Pages are taken one by one, so fast workers take more pages
+		MutexLock(batch->mutex);
+
+		if(batch->is_stopped || batch->next_page >= batch->end_page) {
+			MutexUnlock(batch->mutex);
+
+			break;
+		}
+
+		index = batch->next_page++;
+
+		page = djvupureDocumentGetPage(batch->document, index, batch->openu8, batch->close);
+		// Page with unreadable subchunks isn't rendered and fails the batch
+		if(page && ContainerLoadSubchunks(page)) {
+			// Renderer of worker is reused, so its buffers are allocated once
+			if(renderer)
+				is_ready = djvupurePageImageRendererReset(renderer, page, batch->document, &width, &height, &channels);
+			else {
+				renderer = djvupurePageImageRendererCreateWithAllocator(page, batch->document, &width, &height, &channels, batch->allocator);
+				if(renderer) {
+					djvupurePageImageRendererSetFlags(renderer, batch->flags);
+					is_ready = true;
+				}
+			}
+		}
+
+		MutexUnlock(batch->mutex);
+
+		if(is_ready)
+			is_rendered = djvupureBatchRenderPage(batch, renderer, width, height, channels, &buffer, &buffer_size);
+
+		if(is_rendered)
+			is_accepted = batch->sink(batch->sink_ctx, index, width, height, channels, buffer);
+		else
+			is_accepted = batch->sink(batch->sink_ctx, index, 0, 0, 0, 0);
+
+		MutexLock(batch->mutex);
+
+		if(page) djvupureDocumentPutPage(batch->document, page, false, batch->openu8, batch->close);
+
+		if(!is_rendered) batch->result = false;
+		if(!is_accepted) {
+			batch->is_stopped = true;
+			batch->result = false;
+		}
+
+		MutexUnlock(batch->mutex);
+	}
+
+	if(renderer) djvupurePageImageRendererDestroy(renderer);
+	AllocatorFree(batch->allocator, buffer);
+}
+
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentRenderPages(djvupure_chunk_t *document, size_t first_page, size_t nof_pages, djvupure_page_sink_t sink, void *sink_ctx, unsigned int nof_threads, djvupure_allocator_t *allocator, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close)
+{
+	return djvupureDocumentRenderPagesWithFlags(document, first_page, nof_pages, sink, sink_ctx, nof_threads, allocator, openu8, close, 0);
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentRenderPagesWithFlags(djvupure_chunk_t *document, size_t first_page, size_t nof_pages, djvupure_page_sink_t sink, void *sink_ctx, unsigned int nof_threads, djvupure_allocator_t *allocator, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close, uint32_t flags)
+{
+	djvupure_batch_t batch;
+	void **threads = 0;
+	unsigned int nof_created = 0;
+
+	if(!djvupureDocumentIs(document) || !sink) return false;
+
+	if(allocator)
+		if(allocator->hash != djvupureAllocatorGetStructHash()) return false;
+
+	if(first_page > SIZE_MAX-nof_pages) return false;
+	if(first_page+nof_pages > djvupureDocumentCountPages(document)) return false;
+
+	if(nof_pages == 0) return true;
+
+	if(nof_threads == 0) nof_threads = ThreadGetProcessorsCount();
+	if(nof_threads > nof_pages) nof_threads = (unsigned int)nof_pages;
+
+	batch.document = document;
+	batch.sink = sink;
+	batch.sink_ctx = sink_ctx;
+	batch.openu8 = openu8;
+	batch.close = close;
+	batch.allocator = allocator;
+	batch.flags = flags;
+	batch.next_page = first_page;
+	batch.end_page = first_page+nof_pages;
+	batch.is_stopped = false;
+	batch.result = true;
+
+	batch.mutex = MutexCreate();
+	if(!batch.mutex) return false;
+
+	// Calling thread is a worker too
+	if(nof_threads > 1) {
+		threads = AllocatorAlloc(batch.allocator, (nof_threads-1)*sizeof(void *));
+
+		if(threads)
+			for(; nof_created < nof_threads-1; nof_created++) {
+				threads[nof_created] = ThreadCreate(djvupureBatchWorker, &batch);
+				if(!threads[nof_created]) break;
+			}
+	}
+
+	djvupureBatchWorker(&batch);
+
+	for(unsigned int i = 0; i < nof_created; i++)
+		ThreadJoin(threads[i]);
+
+	if(threads) AllocatorFree(batch.allocator, threads);
+	MutexDestroy(batch.mutex);
+
+	return batch.result;
+}
\ No newline at end of file
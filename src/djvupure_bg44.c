@@ -0,0 +1,61 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "djvupure_iw44.h"
+#include "djvupure_sign.h"
+
+#include <string.h>
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBG44CheckSign(const uint8_t sign[4])
+{
+	if(!memcmp(sign, djvupure_bg44_sign, 4))
+		return true;
+	else
+		return false;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBG44Is(djvupure_chunk_t *bg44)
+{
+	if(djvupureChunkGetStructHash() != bg44->hash) return false;
+	if(!djvupureBG44CheckSign(bg44->sign)) return false;
+
+	return true;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBG44GetInfo(djvupure_chunk_t *bg44, uint16_t *width, uint16_t *height)
+{
+	if(!djvupureBG44Is(bg44)) return false;
+
+	return IW44GetInfo(bg44, width, height);
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBG44Decode(djvupure_chunk_t *page, uint16_t width, uint16_t height, void *buf)
+{
+	if(!djvupurePageIs(page)) return false;
+
+	return IW44DecodeRegion(0, page, djvupure_bg44_sign, width, height, 0, 0, width, height, buf);
+}
\ No newline at end of file
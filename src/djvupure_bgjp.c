@@ -57,5 +57,21 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpDecode(djvupure_chunk_t *
 {
 	if(!djvupureBGjpIs(bgjp)) return false;
 
-	return JpegDecode(bgjp, width, height, buf);
+	return JpegDecode(0, bgjp, width, height, buf);
 }
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpGetReducedInfo(djvupure_chunk_t *bgjp, uint8_t factor, uint16_t *width, uint16_t *height)
+{
+	if(!djvupureBGjpIs(bgjp)) return false;
+
+	return JpegGetReducedInfo(bgjp, factor, width, height);
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureBGjpDecodeReduced(djvupure_chunk_t *bgjp, uint8_t factor, void *buf)
+{
+	uint16_t width, height;
+
+	if(!djvupureBGjpGetReducedInfo(bgjp, factor, &width, &height)) return false;
+
+	return JpegDecode(0, bgjp, width, height, buf);
+}
\ No newline at end of file
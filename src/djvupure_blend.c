@@ -0,0 +1,302 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "djvupure_blend.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DJVUPURE_BLEND_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(DJVUPURE_BLEND_X86) && (defined(__GNUC__) || defined(__clang__)) && !defined(_MSC_VER)
+#define DJVUPURE_BLEND_TARGET_SSE2 __attribute__((target("sse2")))
+#define DJVUPURE_BLEND_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define DJVUPURE_BLEND_TARGET_SSE2
+#define DJVUPURE_BLEND_TARGET_AVX2
+#endif
+
+enum {
+	DJVUPURE_BLEND_KERNEL_SCALAR,
+	DJVUPURE_BLEND_KERNEL_SSE2,
+	DJVUPURE_BLEND_KERNEL_AVX2
+};
+
+static int BlendGetKernel(void)
+{
+#if defined(DJVUPURE_BLEND_X86) && defined(_MSC_VER)
+	static volatile int kernel = -1;
+
+	if(kernel < 0) {
+		int regs[4], max_leaf, result = DJVUPURE_BLEND_KERNEL_SCALAR;
+
+		__cpuid(regs, 0);
+		max_leaf = regs[0];
+		__cpuid(regs, 1);
+		if(regs[3] & (1 << 26)) result = DJVUPURE_BLEND_KERNEL_SSE2;
+		// AVX2 also needs OS support of YMM state (OSXSAVE and XCR0)
+		if(max_leaf >= 7 && (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6) {
+			__cpuidex(regs, 7, 0);
+			if(regs[1] & (1 << 5)) result = DJVUPURE_BLEND_KERNEL_AVX2;
+		}
+
+		kernel = result;
+	}
+
+	return kernel;
+#elif defined(DJVUPURE_BLEND_X86)
+	if(__builtin_cpu_supports("avx2")) return DJVUPURE_BLEND_KERNEL_AVX2;
+	if(__builtin_cpu_supports("sse2")) return DJVUPURE_BLEND_KERNEL_SSE2;
+
+	return DJVUPURE_BLEND_KERNEL_SCALAR;
+#else
+	return DJVUPURE_BLEND_KERNEL_SCALAR;
+#endif
+}
+
+static uint8_t BlendReverseBits(uint8_t b)
+{
+	b = (uint8_t)((b >> 4) | (b << 4));
+	b = (uint8_t)(((b & 0xCC) >> 2) | ((b & 0x33) << 2));
+	b = (uint8_t)(((b & 0xAA) >> 1) | ((b & 0x55) << 1));
+
+	return b;
+}
+
+// Returns flags of 8 pixels of packed mask starting at bit, least significant bit is first pixel
+static uint8_t BlendBitsFlags(const uint8_t *bits, size_t bit)
+{
+	const uint8_t *p;
+	unsigned int shift;
+	uint8_t b;
+
+	p = bits + (bit >> 3);
+	shift = (unsigned int)(bit & 7);
+	b = p[0];
+	if(shift) b = (uint8_t)((b << shift) | (p[1] >> (8 - shift)));
+
+	return BlendReverseBits(b);
+}
+
+static void BlendMaskScalar(const uint8_t *mask, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels)
+{
+	size_t i;
+
+	if(channels == 3) {
+		for(i = 0; i < nof_pixels; i++, fg += 3, bg += 3)
+			if(mask[i] < 128) { // Black pixels of mask are foreground
+				bg[0] = fg[0];
+				bg[1] = fg[1];
+				bg[2] = fg[2];
+			}
+	} else {
+		for(i = 0; i < nof_pixels; i++, fg += channels, bg += channels)
+			if(mask[i] < 128) memcpy(bg, fg, channels);
+	}
+}
+
+static void BlendBitsScalar(const uint8_t *bits, size_t first_bit, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels)
+{
+	size_t i = 0;
+
+	while(i < nof_pixels) {
+		if(!(first_bit & 7) && nof_pixels-i >= 8 && !bits[first_bit >> 3]) { // Whole byte of background
+			i += 8;
+			first_bit += 8;
+
+			continue;
+		}
+
+		if(bits[first_bit >> 3] & (0x80 >> (first_bit & 7)))
+			memcpy(bg + i*channels, fg + i*channels, channels);
+
+		i++;
+		first_bit++;
+	}
+}
+
+#if defined(DJVUPURE_BLEND_X86)
+// Selects 16 pixels, pixel i is taken from fg if bit i of flags is set
+// Every 4 pixels are expanded to bytes by testing the same broadcasted nibble against per byte bit pattern
+// For 3 channels 12 bytes are used and last 4 bytes of the vector are written back unchanged from bg
+DJVUPURE_BLEND_TARGET_SSE2 static void BlendFlags16SSE2(uint32_t flags, const uint8_t *fg, uint8_t *bg, uint8_t channels)
+{
+	__m128i pattern, zero;
+	unsigned int k, step;
+
+	if(channels == 3) {
+		pattern = _mm_setr_epi8(1, 1, 1, 2, 2, 2, 4, 4, 4, 8, 8, 8, 0, 0, 0, 0);
+		step = 12;
+	} else {
+		pattern = _mm_setr_epi8(1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 8, 8, 8, 8);
+		step = 16;
+	}
+	zero = _mm_setzero_si128();
+
+	for(k = 0; k < 4; k++, flags >>= 4, fg += step, bg += step) {
+		__m128i keep, vfg, vbg;
+
+		if(!(flags & 15)) continue;
+
+		keep = _mm_cmpeq_epi8(_mm_and_si128(_mm_set1_epi8((char)(flags & 15)), pattern), zero);
+		vfg = _mm_loadu_si128((const __m128i *)fg);
+		vbg = _mm_loadu_si128((const __m128i *)bg);
+		_mm_storeu_si128((__m128i *)bg, _mm_or_si128(_mm_and_si128(keep, vbg), _mm_andnot_si128(keep, vfg)));
+	}
+}
+
+// 3 channel vectors read 4 bytes after the last pixel, so 2 more pixels must be available
+#define DJVUPURE_BLEND_SSE2_PIXELS(channels) ((channels) == 3 ? 18 : 16)
+
+DJVUPURE_BLEND_TARGET_SSE2 static void BlendMaskSSE2(const uint8_t *mask, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels)
+{
+	size_t i = 0;
+
+	for(; nof_pixels-i >= DJVUPURE_BLEND_SSE2_PIXELS(channels); i += 16) {
+		uint32_t flags;
+
+		// Sign bit is set for mask values not less than 128, i.e. background
+		flags = ~(uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(mask + i))) & 0xFFFF;
+		if(flags) BlendFlags16SSE2(flags, fg + i*channels, bg + i*channels, channels);
+	}
+
+	BlendMaskScalar(mask + i, fg + i*channels, bg + i*channels, nof_pixels-i, channels);
+}
+
+DJVUPURE_BLEND_TARGET_SSE2 static void BlendBitsSSE2(const uint8_t *bits, size_t first_bit, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels)
+{
+	size_t i = 0;
+
+	for(; nof_pixels-i >= DJVUPURE_BLEND_SSE2_PIXELS(channels); i += 16) {
+		uint32_t flags;
+
+		flags = BlendBitsFlags(bits, first_bit + i) | ((uint32_t)BlendBitsFlags(bits, first_bit + i + 8) << 8);
+		if(flags) BlendFlags16SSE2(flags, fg + i*channels, bg + i*channels, channels);
+	}
+
+	BlendBitsScalar(bits, first_bit + i, fg + i*channels, bg + i*channels, nof_pixels-i, channels);
+}
+
+// Same as BlendFlags16SSE2 for 32 pixels, every 8 pixels are selected with one blend
+DJVUPURE_BLEND_TARGET_AVX2 static void BlendFlags32AVX2(uint32_t flags, const uint8_t *fg, uint8_t *bg, uint8_t channels)
+{
+	__m256i pattern, zero;
+	unsigned int k, step;
+
+	if(channels == 3) {
+		pattern = _mm256_setr_epi8(1, 1, 1, 2, 2, 2, 4, 4, 4, 8, 8, 8, 16, 16, 16, 32, 32, 32, 64, 64, 64, -128, -128, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+		step = 24;
+	} else {
+		pattern = _mm256_setr_epi8(1, 1, 1, 1, 2, 2, 2, 2, 4, 4, 4, 4, 8, 8, 8, 8, 16, 16, 16, 16, 32, 32, 32, 32, 64, 64, 64, 64, -128, -128, -128, -128);
+		step = 32;
+	}
+	zero = _mm256_setzero_si256();
+
+	for(k = 0; k < 4; k++, flags >>= 8, fg += step, bg += step) {
+		__m256i keep, vfg, vbg;
+
+		if(!(flags & 255)) continue;
+
+		keep = _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_set1_epi8((char)(flags & 255)), pattern), zero);
+		vfg = _mm256_loadu_si256((const __m256i *)fg);
+		vbg = _mm256_loadu_si256((const __m256i *)bg);
+		_mm256_storeu_si256((__m256i *)bg, _mm256_blendv_epi8(vfg, vbg, keep));
+	}
+}
+
+// 3 channel vectors read 8 bytes after the last pixel, so 3 more pixels must be available
+#define DJVUPURE_BLEND_AVX2_PIXELS(channels) ((channels) == 3 ? 35 : 32)
+
+DJVUPURE_BLEND_TARGET_AVX2 static void BlendMaskAVX2(const uint8_t *mask, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels)
+{
+	size_t i = 0;
+
+	for(; nof_pixels-i >= DJVUPURE_BLEND_AVX2_PIXELS(channels); i += 32) {
+		uint32_t flags;
+
+		flags = ~(uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(mask + i)));
+		if(flags) BlendFlags32AVX2(flags, fg + i*channels, bg + i*channels, channels);
+	}
+
+	BlendMaskSSE2(mask + i, fg + i*channels, bg + i*channels, nof_pixels-i, channels);
+}
+
+DJVUPURE_BLEND_TARGET_AVX2 static void BlendBitsAVX2(const uint8_t *bits, size_t first_bit, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels)
+{
+	size_t i = 0;
+
+	for(; nof_pixels-i >= DJVUPURE_BLEND_AVX2_PIXELS(channels); i += 32) {
+		uint32_t flags;
+
+		flags = BlendBitsFlags(bits, first_bit + i) | ((uint32_t)BlendBitsFlags(bits, first_bit + i + 8) << 8)
+			| ((uint32_t)BlendBitsFlags(bits, first_bit + i + 16) << 16) | ((uint32_t)BlendBitsFlags(bits, first_bit + i + 24) << 24);
+		if(flags) BlendFlags32AVX2(flags, fg + i*channels, bg + i*channels, channels);
+	}
+
+	BlendBitsSSE2(bits, first_bit + i, fg + i*channels, bg + i*channels, nof_pixels-i, channels);
+}
+#endif
+
+void DJVUPURE_APIENTRY BlendMask(const uint8_t *mask, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels)
+{
+#if defined(DJVUPURE_BLEND_X86)
+	if(channels == 3 || channels == 4) {
+		switch(BlendGetKernel()) {
+			case DJVUPURE_BLEND_KERNEL_AVX2:
+				BlendMaskAVX2(mask, fg, bg, nof_pixels, channels);
+				return;
+			case DJVUPURE_BLEND_KERNEL_SSE2:
+				BlendMaskSSE2(mask, fg, bg, nof_pixels, channels);
+				return;
+		}
+	}
+#endif
+
+	BlendMaskScalar(mask, fg, bg, nof_pixels, channels);
+}
+
+void DJVUPURE_APIENTRY BlendBits(const uint8_t *bits, size_t first_bit, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels)
+{
+#if defined(DJVUPURE_BLEND_X86)
+	if(channels == 3 || channels == 4) {
+		switch(BlendGetKernel()) {
+			case DJVUPURE_BLEND_KERNEL_AVX2:
+				BlendBitsAVX2(bits, first_bit, fg, bg, nof_pixels, channels);
+				return;
+			case DJVUPURE_BLEND_KERNEL_SSE2:
+				BlendBitsSSE2(bits, first_bit, fg, bg, nof_pixels, channels);
+				return;
+		}
+	}
+#endif
+
+	BlendBitsScalar(bits, first_bit, fg, bg, nof_pixels, channels);
+}
\ No newline at end of file
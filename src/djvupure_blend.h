@@ -0,0 +1,51 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*Internal module for compositing of foreground layer over background layer*/
+
+#ifndef DJVUPURE_BLEND_H
+#define DJVUPURE_BLEND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Copies pixels of fg to bg where mask is black (mask byte is less than 128)
+// fg and bg are packed pixels with 3 or 4 channels (other values use scalar code), vectorized kernel is selected at runtime
+void DJVUPURE_APIENTRY BlendMask(const uint8_t *mask, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels);
+// Same for packed 1-bpp mask (1 is black, most significant bit is left pixel), first pixel is bit first_bit of bits
+void DJVUPURE_APIENTRY BlendBits(const uint8_t *bits, size_t first_bit, const uint8_t *fg, uint8_t *bg, size_t nof_pixels, uint8_t channels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,234 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "djvupure_bzz.h"
+#include "djvupure_zp.h"
+#include "djvupure_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+	DJVUPURE_BZZ_MAX_BLOCK = 4096*1024,
+	DJVUPURE_BZZ_CTXIDS = 3,
+	DJVUPURE_BZZ_FREQMAX = 4,
+	DJVUPURE_BZZ_MARKER = 256
+};
+
+static uint32_t djvupureBZZDecodeRaw(djvupure_zp_t *zp, int bits)
+{
+	uint32_t n = 1, m;
+
+	m = 1u<<bits;
+	while(n < m)
+		n = (n<<1)|ZPDecodePassthrough(zp);
+
+	return n-m;
+}
+
+static int djvupureBZZDecodeBinary(djvupure_zp_t *zp, djvupure_zp_context_t *ctx, int bits)
+{
+	int n = 1, m;
+
+	m = 1<<bits;
+	ctx--;
+	while(n < m)
+		n = (n<<1)|ZPDecode(zp, ctx+n);
+
+	return n-m;
+}
+
+// Decodes MTF position, returns DJVUPURE_BZZ_MARKER for end of block marker
+static int djvupureBZZDecodeMtfNo(djvupure_zp_t *zp, djvupure_zp_context_t *ctx, int ctxid)
+{
+	if(ZPDecode(zp, ctx+ctxid)) return 0;
+	ctx += DJVUPURE_BZZ_CTXIDS;
+	if(ZPDecode(zp, ctx+ctxid)) return 1;
+	ctx += DJVUPURE_BZZ_CTXIDS;
+
+	// Positions 2^k..2^(k+1)-1 share one context for prefix and 2^k-1 contexts for the rest bits
+	for(int bits = 1; bits < 8; bits++) {
+		if(ZPDecode(zp, ctx)) return (1<<bits)+djvupureBZZDecodeBinary(zp, ctx+1, bits);
+		ctx += 1<<bits;
+	}
+
+	return DJVUPURE_BZZ_MARKER;
+}
+
+// Decodes one block and appends it to *out, returns false on error, sets *is_end on last block
+static bool djvupureBZZDecodeBlock(djvupure_allocator_t *allocator, djvupure_zp_t *zp, uint8_t **out, size_t *out_len, size_t *out_alloc, bool *is_end)
+{
+	djvupure_zp_context_t ctx[300];
+	uint8_t mtf[256], *data = 0;
+	uint32_t freq[DJVUPURE_BZZ_FREQMAX], *posn = 0, fadd = 4;
+	size_t count[256];
+	uint32_t size;
+	int fshift = 0, mtfno = 3;
+	int64_t markerpos = -1;
+	bool result = false;
+
+	*is_end = false;
+
+	size = djvupureBZZDecodeRaw(zp, 24);
+	if(!size) {
+		*is_end = true;
+
+		return true;
+	}
+	if(size > DJVUPURE_BZZ_MAX_BLOCK) return false;
+
+	if(ZPDecodePassthrough(zp)) {
+		fshift++;
+		if(ZPDecodePassthrough(zp)) fshift++;
+	}
+
+	data = AllocatorAlloc(allocator, size);
+	posn = AllocatorAlloc(allocator, size*sizeof(uint32_t));
+	if(!data || !posn) goto FINAL;
+
+	memset(ctx, 0, sizeof(ctx));
+	memset(freq, 0, sizeof(freq));
+	for(int i = 0; i < 256; i++) mtf[i] = (uint8_t)i;
+
+	// Decode MTF positions
+	for(uint32_t i = 0; i < size; i++) {
+		uint32_t fc;
+		int k, ctxid;
+
+		ctxid = DJVUPURE_BZZ_CTXIDS-1;
+		if(ctxid > mtfno) ctxid = mtfno;
+
+		mtfno = djvupureBZZDecodeMtfNo(zp, ctx, ctxid);
+		if(mtfno == DJVUPURE_BZZ_MARKER) {
+			data[i] = 0;
+			markerpos = i;
+
+			continue;
+		}
+
+		data[i] = mtf[mtfno];
+
+		// Rotate MTF according to empirical frequencies
+		fadd = fadd+(fadd>>fshift);
+		if(fadd > 0x10000000) {
+			fadd >>= 24;
+			for(k = 0; k < DJVUPURE_BZZ_FREQMAX; k++) freq[k] >>= 24;
+		}
+
+		fc = fadd;
+		if(mtfno < DJVUPURE_BZZ_FREQMAX) fc += freq[mtfno];
+		for(k = mtfno; k >= DJVUPURE_BZZ_FREQMAX; k--) mtf[k] = mtf[k-1];
+		for(; k > 0 && fc >= freq[k-1]; k--) {
+			mtf[k] = mtf[k-1];
+			freq[k] = freq[k-1];
+		}
+		mtf[k] = data[i];
+		freq[k] = fc;
+	}
+
+	if(zp->is_overrun) goto FINAL;
+	if(markerpos < 1 || markerpos >= size) goto FINAL;
+
+	// Undo Burrows-Wheeler transform
+	memset(count, 0, sizeof(count));
+	for(uint32_t i = 0; i < size; i++) {
+		if(i == markerpos) continue;
+
+		posn[i] = ((uint32_t)data[i]<<24)|(count[data[i]]&0xffffff);
+		count[data[i]]++;
+	}
+
+	{
+		size_t last = 1, i = 0;
+
+		for(int c = 0; c < 256; c++) {
+			size_t tmp = count[c];
+
+			count[c] = last;
+			last += tmp;
+		}
+
+		if(*out_alloc-*out_len < size-1) {
+			uint8_t *_out;
+			size_t out_alloc_new;
+
+			out_alloc_new = *out_len+size-1;
+			if(out_alloc_new < *out_alloc*2) out_alloc_new = *out_alloc*2;
+
+			_out = AllocatorRealloc(allocator, *out, out_alloc_new);
+			if(!_out) goto FINAL;
+
+			*out = _out;
+			*out_alloc = out_alloc_new;
+		}
+
+		last = size-1;
+		while(last > 0) {
+			uint32_t n = posn[i];
+			uint8_t c = (uint8_t)(n>>24);
+
+			(*out)[*out_len+(--last)] = c;
+			i = count[c]+(n&0xffffff);
+			if(i >= size) goto FINAL;
+		}
+
+		if(i != (size_t)markerpos) goto FINAL;
+	}
+
+	*out_len += size-1;
+	result = true;
+
+FINAL:
+	AllocatorFree(allocator, data);
+	AllocatorFree(allocator, posn);
+
+	return result;
+}
+
+bool DJVUPURE_APIENTRY BZZDecode(djvupure_allocator_t *allocator, const void *data, size_t data_len, uint8_t **out, size_t *out_len)
+{
+	djvupure_zp_t zp;
+	size_t out_alloc = 0;
+	bool is_end = false;
+
+	*out = 0;
+	*out_len = 0;
+
+	ZPInit(&zp, data, data_len);
+
+	while(!is_end) {
+		if(!djvupureBZZDecodeBlock(allocator, &zp, out, out_len, &out_alloc, &is_end)) {
+			AllocatorFree(allocator, *out);
+			*out = 0;
+			*out_len = 0;
+
+			return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,513 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "../include/djvupure.h"
+#include "djvupure_allocator.h"
+#include "djvupure_read.h"
+#include "djvupure_thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+	DJVUPURE_CACHE_MIN_BUCKETS = 64
+};
+
+typedef struct {
+	djvupure_chunk_t *document;
+	size_t index;
+	djvupure_rect_t rect;
+	uint32_t flags; // Only flags changing rendered pixels
+	uint8_t factor;
+	bool is_whole; // rect isn't used, whole page is rendered
+} djvupure_cache_key_t;
+
+typedef struct djvupure_cache_entry_t {
+	struct djvupure_cache_entry_t *prev; // Entries from most to least recently used
+	struct djvupure_cache_entry_t *next;
+	struct djvupure_cache_entry_t *next_in_bucket;
+	djvupure_cache_key_t key;
+	size_t size; // Size of pixels
+	size_t nof_users; // Entry isn't freed while pixels are borrowed
+	uint16_t width;
+	uint16_t height;
+	uint8_t channels;
+	bool is_cached; // Entry that isn't in cache is freed when it's released
+} djvupure_cache_entry_t;
+
+// Pixels are allocated together with entry, they follow aligned header
+#define DJVUPURE_CACHE_HEADER ((sizeof(djvupure_cache_entry_t)+15)/16*16)
+
+typedef struct {
+	void *mutex; // Guards fields below and document trees
+	djvupure_cache_entry_t **buckets;
+	size_t nof_buckets;
+	size_t nof_entries;
+	djvupure_cache_entry_t *first;
+	djvupure_cache_entry_t *last;
+	size_t size; // Total size of cached pixels
+	size_t budget;
+	void *renderer; // Spare renderer, it's reset for every rendered page
+	djvupure_allocator_t allocator;
+	bool has_allocator;
+} djvupure_cache_t;
+
+static djvupure_allocator_t *djvupureRenderCacheGetAllocator(djvupure_cache_t *cache)
+{
+	return cache->has_allocator?&(cache->allocator):0;
+}
+
+static size_t djvupureRenderCacheHash(const djvupure_cache_key_t *key)
+{
+	size_t hash;
+
+	hash = (size_t)(uintptr_t)key->document/16;
+	hash = hash*31+key->index;
+	hash = hash*31+key->factor;
+	hash = hash*31+key->flags;
+
+	if(!key->is_whole) {
+		hash = hash*31+key->rect.x;
+		hash = hash*31+key->rect.y;
+		hash = hash*31+key->rect.width;
+		hash = hash*31+key->rect.height;
+	}
+
+	return hash;
+}
+
+static bool djvupureRenderCacheIsSameKey(const djvupure_cache_key_t *key1, const djvupure_cache_key_t *key2)
+{
+	if(key1->document != key2->document || key1->index != key2->index) return false;
+	if(key1->factor != key2->factor || key1->flags != key2->flags) return false;
+	if(key1->is_whole != key2->is_whole) return false;
+
+	if(!key1->is_whole) {
+		if(key1->rect.x != key2->rect.x || key1->rect.y != key2->rect.y) return false;
+		if(key1->rect.width != key2->rect.width || key1->rect.height != key2->rect.height) return false;
+	}
+
+	return true;
+}
+
+static djvupure_cache_entry_t *djvupureRenderCacheFind(djvupure_cache_t *cache, const djvupure_cache_key_t *key)
+{
+	djvupure_cache_entry_t *entry;
+
+	entry = cache->buckets[djvupureRenderCacheHash(key)%cache->nof_buckets];
+
+	for(; entry; entry = entry->next_in_bucket)
+		if(djvupureRenderCacheIsSameKey(&(entry->key), key)) return entry;
+
+	return 0;
+}
+
+// Makes entry most recently used
+static void djvupureRenderCacheTouch(djvupure_cache_t *cache, djvupure_cache_entry_t *entry)
+{
+	if(cache->first == entry) return;
+
+	entry->prev->next = entry->next;
+	if(entry->next) entry->next->prev = entry->prev;
+	else cache->last = entry->prev;
+
+	entry->prev = 0;
+	entry->next = cache->first;
+	cache->first->prev = entry;
+	cache->first = entry;
+}
+
+// Doubles number of buckets when there are more entries than buckets, cache still works if it fails
+static void djvupureRenderCacheGrow(djvupure_cache_t *cache)
+{
+	djvupure_cache_entry_t **buckets;
+	size_t nof_buckets;
+
+	if(cache->nof_entries < cache->nof_buckets) return;
+	if(SIZE_MAX/2/sizeof(void *) < cache->nof_buckets) return;
+
+	nof_buckets = cache->nof_buckets*2;
+
+	buckets = AllocatorAlloc(djvupureRenderCacheGetAllocator(cache), nof_buckets*sizeof(void *));
+	if(!buckets) return;
+
+	memset(buckets, 0, nof_buckets*sizeof(void *));
+
+	for(djvupure_cache_entry_t *entry = cache->first; entry; entry = entry->next) {
+		size_t bucket;
+
+		bucket = djvupureRenderCacheHash(&(entry->key))%nof_buckets;
+		entry->next_in_bucket = buckets[bucket];
+		buckets[bucket] = entry;
+	}
+
+	AllocatorFree(djvupureRenderCacheGetAllocator(cache), cache->buckets);
+	cache->buckets = buckets;
+	cache->nof_buckets = nof_buckets;
+}
+
+static void djvupureRenderCacheInsert(djvupure_cache_t *cache, djvupure_cache_entry_t *entry)
+{
+	size_t bucket;
+
+	cache->nof_entries++;
+	djvupureRenderCacheGrow(cache);
+
+	bucket = djvupureRenderCacheHash(&(entry->key))%cache->nof_buckets;
+	entry->next_in_bucket = cache->buckets[bucket];
+	cache->buckets[bucket] = entry;
+
+	entry->prev = 0;
+	entry->next = cache->first;
+	if(cache->first) cache->first->prev = entry;
+	else cache->last = entry;
+	cache->first = entry;
+
+	cache->size += entry->size;
+	entry->is_cached = true;
+}
+
+// Removes entry from cache, it's freed if nobody uses it
+static void djvupureRenderCacheRemove(djvupure_cache_t *cache, djvupure_cache_entry_t *entry)
+{
+	djvupure_cache_entry_t **link;
+
+	link = &(cache->buckets[djvupureRenderCacheHash(&(entry->key))%cache->nof_buckets]);
+	while(*link != entry) link = &((*link)->next_in_bucket);
+	*link = entry->next_in_bucket;
+
+	if(entry->prev) entry->prev->next = entry->next;
+	else cache->first = entry->next;
+	if(entry->next) entry->next->prev = entry->prev;
+	else cache->last = entry->prev;
+
+	cache->nof_entries--;
+	cache->size -= entry->size;
+	entry->is_cached = false;
+
+	if(!entry->nof_users) AllocatorFree(djvupureRenderCacheGetAllocator(cache), entry);
+}
+
+// Removes least recently used entries until size of cache isn't greater than budget
+static void djvupureRenderCacheEvict(djvupure_cache_t *cache, size_t budget)
+{
+	djvupure_cache_entry_t *entry;
+
+	entry = cache->last;
+	while(entry && cache->size > budget) {
+		djvupure_cache_entry_t *prev;
+
+		prev = entry->prev;
+
+		// Borrowed entries are removed after they are released
+		if(!entry->nof_users) djvupureRenderCacheRemove(cache, entry);
+
+		entry = prev;
+	}
+}
+
+// Renders page into new entry which isn't inserted to cache
+static djvupure_cache_entry_t *djvupureRenderCacheRender(djvupure_cache_t *cache, void *renderer, const djvupure_cache_key_t *key, uint32_t flags, uint8_t channels)
+{
+	djvupure_cache_entry_t *entry;
+	size_t row_size, size;
+	uint16_t width, height;
+
+	if(!djvupurePageImageRendererSetFlags(renderer, flags)) return 0;
+	if(!djvupurePageImageRendererSetReduction(renderer, key->factor, &width, &height)) return 0;
+
+	if(!key->is_whole) {
+		if(!djvupurePageImageRendererSetRect(renderer, &(key->rect))) return 0;
+
+		width = key->rect.width;
+		height = key->rect.height;
+	}
+
+	if(channels == 1 && (flags & DJVUPURE_RENDER_FLAG_PACKED_MASK))
+		row_size = ((size_t)width+7)/8;
+	else
+		row_size = (size_t)width*channels;
+
+	if(SIZE_MAX/row_size < height) return 0;
+	size = row_size*height;
+	if(size > SIZE_MAX-DJVUPURE_CACHE_HEADER) return 0;
+
+	entry = AllocatorAlloc(djvupureRenderCacheGetAllocator(cache), DJVUPURE_CACHE_HEADER+size);
+	if(!entry) return 0;
+
+	while(1) {
+		int step;
+
+		step = djvupurePageImageRendererNext(renderer, (uint8_t *)entry+DJVUPURE_CACHE_HEADER);
+
+		if(step == DJVUPURE_IMAGE_RENDERER_LAST_STAGE) break;
+		else if(step != DJVUPURE_IMAGE_RENDERER_NEXT_STAGE) {
+			AllocatorFree(djvupureRenderCacheGetAllocator(cache), entry);
+
+			return 0;
+		}
+	}
+
+	entry->key = *key;
+	entry->size = size;
+	entry->nof_users = 0;
+	entry->width = width;
+	entry->height = height;
+	entry->channels = channels;
+	entry->is_cached = false;
+
+	return entry;
+}
+
+DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheCreate(size_t budget, djvupure_allocator_t *allocator)
+{
+	djvupure_cache_t *cache;
+
+	if(allocator)
+		if(allocator->hash != djvupureAllocatorGetStructHash()) return 0;
+
+	cache = AllocatorAlloc(allocator, sizeof(djvupure_cache_t));
+	if(!cache) return 0;
+
+	memset(cache, 0, sizeof(djvupure_cache_t));
+	cache->budget = budget;
+	cache->has_allocator = allocator != 0;
+	if(allocator) cache->allocator = *allocator;
+
+	cache->nof_buckets = DJVUPURE_CACHE_MIN_BUCKETS;
+	cache->buckets = AllocatorAlloc(allocator, cache->nof_buckets*sizeof(void *));
+	if(!cache->buckets) goto FAILURE;
+
+	memset(cache->buckets, 0, cache->nof_buckets*sizeof(void *));
+
+	cache->mutex = MutexCreate();
+	if(!cache->mutex) goto FAILURE;
+
+	return cache;
+
+FAILURE:
+	if(cache->buckets) AllocatorFree(allocator, cache->buckets);
+	AllocatorFree(allocator, cache);
+
+	return 0;
+}
+
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheDestroy(void *render_cache)
+{
+	djvupure_cache_t *cache;
+	djvupure_cache_entry_t *entry;
+	djvupure_allocator_t allocator, *p_allocator;
+
+	if(!render_cache) return;
+
+	cache = (djvupure_cache_t *)render_cache;
+
+	// Cache itself is allocated with allocator, so it's copied
+	p_allocator = 0;
+	if(cache->has_allocator) {
+		allocator = cache->allocator;
+		p_allocator = &allocator;
+	}
+
+	entry = cache->first;
+	while(entry) {
+		djvupure_cache_entry_t *next;
+
+		next = entry->next;
+		AllocatorFree(p_allocator, entry);
+		entry = next;
+	}
+
+	if(cache->renderer) djvupurePageImageRendererDestroy(cache->renderer);
+	MutexDestroy(cache->mutex);
+	AllocatorFree(p_allocator, cache->buckets);
+	AllocatorFree(p_allocator, cache);
+}
+
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheSetBudget(void *render_cache, size_t budget)
+{
+	djvupure_cache_t *cache;
+
+	cache = (djvupure_cache_t *)render_cache;
+
+	MutexLock(cache->mutex);
+
+	cache->budget = budget;
+	djvupureRenderCacheEvict(cache, budget);
+
+	MutexUnlock(cache->mutex);
+}
+
+DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheGetSize(void *render_cache)
+{
+	djvupure_cache_t *cache;
+	size_t size;
+
+	cache = (djvupure_cache_t *)render_cache;
+
+	MutexLock(cache->mutex);
+	size = cache->size;
+	MutexUnlock(cache->mutex);
+
+	return size;
+}
+
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheRemoveDocument(void *render_cache, djvupure_chunk_t *document)
+{
+	djvupure_cache_t *cache;
+	djvupure_cache_entry_t *entry;
+
+	cache = (djvupure_cache_t *)render_cache;
+
+	MutexLock(cache->mutex);
+
+	entry = cache->first;
+	while(entry) {
+		djvupure_cache_entry_t *next;
+
+		next = entry->next;
+		if(!document || entry->key.document == document) djvupureRenderCacheRemove(cache, entry);
+		entry = next;
+	}
+
+	MutexUnlock(cache->mutex);
+}
+
+DJVUPURE_API const void * DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheAcquire(void *render_cache, djvupure_chunk_t *document, size_t index, uint8_t factor, const djvupure_rect_t *rect, uint32_t flags, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close, uint16_t *width, uint16_t *height, uint8_t *channels)
+{
+	djvupure_cache_t *cache;
+	djvupure_cache_entry_t *entry, *cached;
+	djvupure_cache_key_t key;
+	djvupure_chunk_t *page;
+	void *renderer = 0;
+	uint16_t page_width, page_height;
+	uint8_t page_channels;
+	bool is_ready = false;
+
+	cache = (djvupure_cache_t *)render_cache;
+
+	if(!djvupureDocumentIs(document)) return 0;
+	if(!factor || !width || !height || !channels) return 0;
+
+	key.document = document;
+	key.index = index;
+	key.factor = factor;
+	key.flags = flags & DJVUPURE_RENDER_FLAG_PACKED_MASK;
+	key.is_whole = rect == 0;
+	if(rect) key.rect = *rect;
+	else memset(&(key.rect), 0, sizeof(djvupure_rect_t));
+
+	MutexLock(cache->mutex);
+
+	entry = djvupureRenderCacheFind(cache, &key);
+	if(entry) {
+		djvupureRenderCacheTouch(cache, entry);
+		entry->nof_users++;
+
+		MutexUnlock(cache->mutex);
+
+		goto FINAL;
+	}
+
+	page = djvupureDocumentGetPage(document, index, openu8, close);
+	// Page with unreadable subchunks isn't rendered
+	if(page && ContainerLoadSubchunks(page)) {
+		// Spare renderer is taken, so other threads create their own
+		renderer = cache->renderer;
+		cache->renderer = 0;
+
+		if(renderer)
+			is_ready = djvupurePageImageRendererReset(renderer, page, document, &page_width, &page_height, &page_channels);
+		else {
+			renderer = djvupurePageImageRendererCreateWithAllocator(page, document, &page_width, &page_height, &page_channels, djvupureRenderCacheGetAllocator(cache));
+			is_ready = renderer != 0;
+		}
+	}
+
+	MutexUnlock(cache->mutex);
+
+	if(is_ready) entry = djvupureRenderCacheRender(cache, renderer, &key, flags, page_channels);
+
+	MutexLock(cache->mutex);
+
+	if(page) djvupureDocumentPutPage(document, page, false, openu8, close);
+
+	if(renderer) {
+		if(!cache->renderer) cache->renderer = renderer;
+		else djvupurePageImageRendererDestroy(renderer);
+	}
+
+	if(entry) {
+		// Page could be rendered by other thread meanwhile
+		cached = djvupureRenderCacheFind(cache, &key);
+		if(cached) {
+			AllocatorFree(djvupureRenderCacheGetAllocator(cache), entry);
+			entry = cached;
+			djvupureRenderCacheTouch(cache, entry);
+		} else if(entry->size <= cache->budget) {
+			djvupureRenderCacheEvict(cache, cache->budget-entry->size);
+			djvupureRenderCacheInsert(cache, entry);
+		}
+
+		entry->nof_users++;
+	}
+
+	MutexUnlock(cache->mutex);
+
+	if(!entry) return 0;
+
+FINAL:
+	*width = entry->width;
+	*height = entry->height;
+	*channels = entry->channels;
+
+	return (uint8_t *)entry+DJVUPURE_CACHE_HEADER;
+}
+
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRenderCacheRelease(void *render_cache, const void *pixels)
+{
+	djvupure_cache_t *cache;
+	djvupure_cache_entry_t *entry;
+
+	if(!pixels) return;
+
+	cache = (djvupure_cache_t *)render_cache;
+	entry = (djvupure_cache_entry_t *)((uint8_t *)pixels-DJVUPURE_CACHE_HEADER);
+
+	MutexLock(cache->mutex);
+
+	entry->nof_users--;
+
+	if(!entry->nof_users) {
+		if(!entry->is_cached)
+			AllocatorFree(djvupureRenderCacheGetAllocator(cache), entry);
+		else if(cache->size > cache->budget)
+			djvupureRenderCacheEvict(cache, cache->budget);
+	}
+
+	MutexUnlock(cache->mutex);
+}
\ No newline at end of file
@@ -27,6 +27,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../include/djvupure.h"
 #include "djvupure_sign.h"
+#include "djvupure_read.h"
+#include "djvupure_arena.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -53,303 +55,765 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureContainerIs(djvupure_chunk_t
 	return true;
 }
 
+typedef struct {
+	djvupure_io_callback_t io;
+	void *fctx;
+	djvupure_raw_chunk_read_t raw_read;
+	int64_t start; // Offset of the first subchunk or of the header if it isn't read yet
+	int64_t end;
+	size_t size;
+	bool is_header_read;
+} djvupure_container_lazy_t;
+
+typedef struct {
+	uint8_t sign[4];
+	uint8_t subsign[4];
+	bool is_used;
+	bool has_subsign; // Otherwise entry counts all chunks with sign
+	size_t nof_positions;
+	size_t nof_allocpositions;
+	size_t *positions; // Sorted subchunk indexes
+} djvupure_container_index_entry_t;
+
+typedef struct {
+	size_t nof_entries;
+	size_t nof_allocentries; // Power of 2
+	djvupure_container_index_entry_t *entries;
+} djvupure_container_index_t;
+
+typedef struct djvupure_container_ctx_t {
+	uint8_t subsign[4];
+	size_t nof_allocsubchunks;
+	size_t nof_subchunks;
+	djvupure_chunk_t **subchunks;
+	djvupure_container_lazy_t *lazy; // Subchunks are not read yet
+	djvupure_container_index_t *index; // Built on first search by sign, 0 if not built
+	struct djvupure_container_ctx_t *parent;
+	size_t size; // Cached djvupureContainerCallbackSize value
+	bool is_size_valid; // If false, sizes of all parents are invalid too (except for not loaded containers)
+	djvupure_arena_t *arena; // If not 0, container, its subchunks and index are allocated from arena
+	bool is_arena_owner; // Container itself isn't allocated from arena and arena is destroyed with it
+} djvupure_container_ctx_t;
+
+static bool djvupureContainerLoadHeader(djvupure_container_ctx_t *ctx);
+static bool djvupureContainerLoad(djvupure_container_ctx_t *ctx);
+static void djvupureContainerIndexFree(djvupure_container_ctx_t *ctx);
+static bool djvupureContainerIndexAdd(djvupure_container_ctx_t *ctx, djvupure_chunk_t *chunk, size_t position);
+
 static void DJVUPURE_APIENTRY djvupureContainerCallbackFree(void *ctx)
 {
-	uintptr_t uctx;
-	size_t nof_subchunks;
-	djvupure_chunk_t **subchunk;
+	djvupure_container_ctx_t *container_ctx;
 
 	if(!ctx) return;
 
-	uctx = (uintptr_t)ctx;
-	nof_subchunks = *((size_t *)(uctx+4+4+sizeof(size_t)));
-	subchunk = (djvupure_chunk_t **)(uctx+4+4+sizeof(size_t)*2);
-	
-	for(size_t i = 0; i < nof_subchunks; i++) {
-		djvupureChunkFree(*subchunk);
-		subchunk++;
+	container_ctx = (djvupure_container_ctx_t *)ctx;
+
+	if(container_ctx->arena) { // Whole tree is freed at once
+		if(container_ctx->is_arena_owner) {
+			ArenaDestroy(container_ctx->arena);
+			free(ctx);
+		}
+
+		return;
 	}
 	
+	for(size_t i = 0; i < container_ctx->nof_subchunks; i++)
+		djvupureChunkFree(container_ctx->subchunks[i]);
+
+	if(container_ctx->subchunks) free(container_ctx->subchunks);
+	if(container_ctx->lazy) free(container_ctx->lazy);
+	djvupureContainerIndexFree(container_ctx);
+	
 	free(ctx);
 }
 
 static bool DJVUPURE_APIENTRY djvupureContainerCallbackRender(void *ctx, djvupure_io_callback_t *io, void *fctx)
 {
-	uintptr_t uctx;
-	size_t nof_subchunks;
-	djvupure_chunk_t **subchunk;
+	djvupure_container_ctx_t *container_ctx;
 
 	if(!ctx) return false;
 
-	uctx = (uintptr_t)ctx;
-	nof_subchunks = *((size_t *)(uctx+4+4+sizeof(size_t)));
-	subchunk = (djvupure_chunk_t **)(uctx+4+4+sizeof(size_t)*2);
+	container_ctx = (djvupure_container_ctx_t *)ctx;
+
+	if(!djvupureContainerLoad(container_ctx)) return false;
 	
-	if(io->callback_write(fctx, ctx, 4) != 4) return false;
+	if(io->callback_write(fctx, container_ctx->subsign, 4) != 4) return false;
 	
-	for(size_t i = 0; i < nof_subchunks; i++) {
-		if(!djvupureChunkRender(*subchunk, io, fctx)) return false;
-		
-		subchunk++;
-	}
+	for(size_t i = 0; i < container_ctx->nof_subchunks; i++)
+		if(!djvupureChunkRender(container_ctx->subchunks[i], io, fctx)) return false;
 	
 	return true;
 }
 
 static size_t DJVUPURE_APIENTRY djvupureContainerCallbackSize(void *ctx)
 {
-	uintptr_t uctx;
-	size_t sz = 4, nof_subchunks;
-	djvupure_chunk_t **subchunk;
+	djvupure_container_ctx_t *container_ctx;
+	size_t sz = 4;
 
 	if(!ctx) return 0;
 
-	uctx = (uintptr_t)ctx;
-	nof_subchunks = *((size_t *)(uctx+4+4+sizeof(size_t)));
-	subchunk = (djvupure_chunk_t **)(uctx+4+4+sizeof(size_t)*2);
+	container_ctx = (djvupure_container_ctx_t *)ctx;
 
-	for(size_t i = 0; i < nof_subchunks; i++) {
-		if(sz%2) sz++;
+	if(container_ctx->lazy) {
+		if(!djvupureContainerLoadHeader(container_ctx)) return 0;
+
+		return container_ctx->lazy->size;
+	}
+	if(container_ctx->is_size_valid) return container_ctx->size;
 
-		sz += djvupureChunkSize(*subchunk);
+	for(size_t i = 0; i < container_ctx->nof_subchunks; i++) {
+		if(sz%2) sz++;
 
-		subchunk++;
+		sz += djvupureChunkSize(container_ctx->subchunks[i]);
 	}
 
+	container_ctx->size = sz;
+	container_ctx->is_size_valid = true;
+
 	return sz;
 }
 
-DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerCreate(const uint8_t subsign[4])
+static void djvupureContainerInvalidateSize(djvupure_container_ctx_t *ctx)
+{
+	ctx->is_size_valid = false;
+	ctx = ctx->parent;
+
+	while(ctx && ctx->is_size_valid) {
+		ctx->is_size_valid = false;
+		ctx = ctx->parent;
+	}
+}
+
+// If is_arena_owner is true, arena is destroyed when container is freed, even on allocation failure
+static djvupure_chunk_t *djvupureContainerAlloc(djvupure_arena_t *arena, bool is_arena_owner)
 {
 	djvupure_chunk_t *container = 0;
-	size_t ctx_size;
+	djvupure_arena_t *container_arena;
+
+	container_arena = is_arena_owner?0:arena;
 	
-	container = malloc(sizeof(djvupure_chunk_t));
-	if(!container) return 0;
+	container = ArenaAlloc(container_arena, sizeof(djvupure_chunk_t));
+	if(!container) goto FAILURE;
 	
 	memset(container, 0, sizeof(djvupure_chunk_t));
 	container->callback_free = djvupureContainerCallbackFree;
 	container->callback_render = djvupureContainerCallbackRender;
 	container->callback_size = djvupureContainerCallbackSize;
 	container->hash = djvupureChunkGetStructHash();
-	ctx_size = 4+4+sizeof(size_t)*2;
-	container->ctx = malloc(ctx_size);
+	container->ctx = ArenaAlloc(container_arena, sizeof(djvupure_container_ctx_t));
 	if(!container->ctx) {
-		free(container);
+		ArenaFree(container_arena, container);
 		
-		return 0;
+		goto FAILURE;
 	}
-	memset(container->ctx, 0, 4+4+sizeof(size_t)*2);
+	memset(container->ctx, 0, sizeof(djvupure_container_ctx_t));
+	((djvupure_container_ctx_t *)(container->ctx))->arena = arena;
+	((djvupure_container_ctx_t *)(container->ctx))->is_arena_owner = is_arena_owner;
 	
 	memcpy(container->sign, djvupure_form_sign, 4);
-	memcpy(container->ctx, subsign, 4);
 	
 	return container;
+
+FAILURE:
+	if(is_arena_owner) ArenaDestroy(arena);
+
+	return 0;
 }
 
-DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerRead(djvupure_io_callback_t *io, void *fctx)
+// Chunks from arena are freed only with arena
+static void djvupureContainerDiscardChunk(djvupure_arena_t *arena, djvupure_chunk_t *chunk)
+{
+	if(!arena) djvupureChunkFree(chunk);
+}
+
+static bool djvupureContainerCtxInsertChunk(djvupure_container_ctx_t *ctx, djvupure_chunk_t *chunk, size_t index)
+{
+	if(index > ctx->nof_subchunks) return false;
+
+	if(ctx->nof_subchunks >= ctx->nof_allocsubchunks) {
+		djvupure_chunk_t **_subchunks;
+		size_t nof_allocsubchunks;
+
+		if(ctx->nof_allocsubchunks == 0) nof_allocsubchunks = 2;
+		else nof_allocsubchunks = ctx->nof_allocsubchunks*2;
+
+		if(SIZE_MAX/sizeof(void *) < nof_allocsubchunks) return false;
+
+		_subchunks = ArenaRealloc(ctx->arena, ctx->subchunks, ctx->nof_allocsubchunks*sizeof(void *), nof_allocsubchunks*sizeof(void *));
+		if(!_subchunks) return false;
+
+		ctx->subchunks = _subchunks;
+		ctx->nof_allocsubchunks = nof_allocsubchunks;
+	}
+
+	if(ctx->arena)
+		if(!ArenaAddChunk(ctx->arena, chunk)) return false;
+
+	// Only sizes of our own containers are cached, so other chunks shouldn't change their size after insertion
+	if(chunk->callback_size == djvupureContainerCallbackSize && chunk->ctx)
+		((djvupure_container_ctx_t *)(chunk->ctx))->parent = ctx;
+	djvupureContainerInvalidateSize(ctx);
+
+	if(ctx->index) {
+		if(index == ctx->nof_subchunks) { // Appending keeps index sorted
+			if(!djvupureContainerIndexAdd(ctx, chunk, index)) djvupureContainerIndexFree(ctx);
+		} else // Positions are shifted, so index will be rebuilt on next search
+			djvupureContainerIndexFree(ctx);
+	}
+
+	for(size_t i = ctx->nof_subchunks; i > index; i--) {
+		ctx->subchunks[i] = ctx->subchunks[i-1];
+	}
+
+	ctx->subchunks[index] = chunk;
+	ctx->nof_subchunks++;
+	 
+	return true;
+}
+
+static djvupure_chunk_t *djvupureContainerReadStub(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, djvupure_arena_t *arena);
+
+static bool djvupureContainerReadSubchunks(djvupure_container_ctx_t *ctx, djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, bool lazy, int64_t chunk_end)
+{
+	while(1) {
+		uint8_t sign[4];
+		djvupure_chunk_t *subchunk;
+		int64_t pos;
+
+		pos = io->callback_tell(fctx);
+		if(pos < 0) return false;
+		if(pos % 2) pos++;
+		if(pos >= chunk_end) break;
+
+		if(io->callback_seek(fctx, pos, DJVUPURE_IO_SEEK_SET)) return false;
+
+		if(io->callback_read(fctx, sign, 4) != 4) return false;
+		if(io->callback_seek(fctx, -4, DJVUPURE_IO_SEEK_CUR)) return false;
+		
+		if(djvupureContainerCheckSign(sign)) {
+			if(lazy)
+				subchunk = djvupureContainerReadStub(io, fctx, raw_read, ctx->arena);
+			else
+				subchunk = ContainerReadEx(io, fctx, raw_read, false, ctx->arena, false);
+		} else
+			subchunk = raw_read(io, fctx, ctx->arena);
+		if(!subchunk) return false;
+		
+		if(!djvupureContainerCtxInsertChunk(ctx, subchunk, ctx->nof_subchunks)) {
+			djvupureContainerDiscardChunk(ctx->arena, subchunk);
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static djvupure_chunk_t *djvupureContainerReadHeader(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena, bool is_arena_owner, int64_t *chunk_end)
 {
 	djvupure_chunk_t *container = 0;
-	void *ctx;
-	size_t ctx_size;
-	int64_t chunk_start, chunk_end, chunk_len;
+	int64_t chunk_start, chunk_len;
 	uint8_t chunk_len_be4[4];
 	
-	container = malloc(sizeof(djvupure_chunk_t));
+	container = djvupureContainerAlloc(arena, is_arena_owner);
 	if(!container) return 0;
-	
-	memset(container, 0, sizeof(djvupure_chunk_t));
-	container->callback_free = djvupureContainerCallbackFree;
-	container->callback_render = djvupureContainerCallbackRender;
-	container->callback_size = djvupureContainerCallbackSize;
-	container->hash = djvupureChunkGetStructHash();
-	ctx_size = 4+4+sizeof(size_t)*2;
-	container->ctx = malloc(ctx_size);
-	if(!container->ctx) goto FAILURE;
-	memset(container->ctx, 0, 4+4+sizeof(size_t)*2);
-	
-	chunk_start = io->callback_tell(fctx);
-	ctx = container->ctx;
 
 	if(io->callback_tell(fctx) % 2)
 		if(io->callback_seek(fctx, 1, DJVUPURE_IO_SEEK_CUR)) goto FAILURE;
+
+	chunk_start = io->callback_tell(fctx);
 	
 	if(io->callback_read(fctx, container->sign, 4) != 4) goto FAILURE;
 	if(!djvupureContainerCheckSign(container->sign)) goto FAILURE;
 	if(io->callback_read(fctx, chunk_len_be4, 4) != 4) goto FAILURE;
-	if(io->callback_read(fctx, ctx, 4) != 4) goto FAILURE;
+	if(io->callback_read(fctx, container->ctx, 4) != 4) goto FAILURE;
 	
 	chunk_len = (((int64_t)(chunk_len_be4[0]))<<24)+
 		(((int64_t)(chunk_len_be4[1]))<<16)+
 		(((int64_t)(chunk_len_be4[2]))<<8)+
 		chunk_len_be4[3];
+
+	if(chunk_len < 4) goto FAILURE;
 	
-	chunk_end = chunk_start;
-	if(INT64_MAX-8 < chunk_end) goto FAILURE;
-	chunk_end += 8;
-	if(INT64_MAX-chunk_len < chunk_end) goto FAILURE;
-	chunk_end += chunk_len;
+	*chunk_end = chunk_start;
+	if(INT64_MAX-8 < *chunk_end) goto FAILURE;
+	*chunk_end += 8;
+	if(INT64_MAX-chunk_len < *chunk_end) goto FAILURE;
+	*chunk_end += chunk_len;
+
+	return container;
+
+FAILURE:
+	if(is_arena_owner) djvupureChunkFree(container);
+	else djvupureContainerDiscardChunk(arena, container);
 	
-	while(io->callback_tell(fctx) < chunk_end) {
-		uint8_t sign[4];
-		djvupure_chunk_t *subchunk;
-		size_t index;
+	return 0;
+}
 
-		if(io->callback_tell(fctx) % 2)
-			if(io->callback_seek(fctx, 1, DJVUPURE_IO_SEEK_CUR)) goto FAILURE;
+static djvupure_chunk_t *djvupureContainerReadStub(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, djvupure_arena_t *arena)
+{
+	djvupure_chunk_t *container;
+	djvupure_container_lazy_t *lazy;
+	int64_t chunk_end;
 
-		if(io->callback_read(fctx, sign, 4) != 4) goto FAILURE;
-		if(io->callback_seek(fctx, -4, DJVUPURE_IO_SEEK_CUR)) goto FAILURE;
-		
-		if(djvupureContainerCheckSign(sign))
-			subchunk = djvupureContainerRead(io, fctx);
-		else
-			subchunk = djvupureRawChunkRead(io, fctx);
-		if(!subchunk) goto FAILURE;
-		
-		index = djvupureContainerSize(container);
-		if(!djvupureContainerInsertChunk(container, subchunk, index)) {
-			djvupureChunkFree(subchunk);
+	container = djvupureContainerReadHeader(io, fctx, arena, false, &chunk_end);
+	if(!container) return 0;
+
+	lazy = ArenaAlloc(arena, sizeof(djvupure_container_lazy_t));
+	if(!lazy) goto FAILURE;
+	((djvupure_container_ctx_t *)(container->ctx))->lazy = lazy;
+
+	lazy->io = *io;
+	lazy->fctx = fctx;
+	lazy->raw_read = raw_read;
+	lazy->start = io->callback_tell(fctx);
+	lazy->end = chunk_end;
+	if((uint64_t)(chunk_end-lazy->start+4) > SIZE_MAX) goto FAILURE;
+	lazy->size = (size_t)(chunk_end-lazy->start+4);
+	lazy->is_header_read = true;
+
+	if(io->callback_seek(fctx, chunk_end, DJVUPURE_IO_SEEK_SET)) goto FAILURE;
+
+	return container;
 
-			goto FAILURE;
+FAILURE:
+	djvupureContainerDiscardChunk(arena, container);
+
+	return 0;
+}
+
+static bool djvupureContainerLoadHeader(djvupure_container_ctx_t *ctx)
+{
+	djvupure_container_lazy_t *lazy;
+	djvupure_chunk_t *header;
+	int64_t pos, chunk_end;
+	bool result = false;
+
+	lazy = ctx->lazy;
+	if(lazy->is_header_read) return true;
+
+	pos = lazy->io.callback_tell(lazy->fctx);
+	if(pos < 0) return false;
+	if(lazy->io.callback_seek(lazy->fctx, lazy->start, DJVUPURE_IO_SEEK_SET)) return false;
+
+	header = djvupureContainerReadHeader(&(lazy->io), lazy->fctx, 0, false, &chunk_end);
+	if(header) {
+		int64_t start;
+
+		start = lazy->io.callback_tell(lazy->fctx);
+
+		// Stub was created with expected subsign, so it shouldn't change
+		if(!memcmp(header->ctx, ctx->subsign, 4) && (uint64_t)(chunk_end-start+4) <= SIZE_MAX) {
+			lazy->start = start;
+			lazy->end = chunk_end;
+			lazy->size = (size_t)(chunk_end-start+4);
+			lazy->is_header_read = true;
+			result = true;
 		}
+
+		djvupureChunkFree(header);
 	}
+
+	if(lazy->io.callback_seek(lazy->fctx, pos, DJVUPURE_IO_SEEK_SET)) result = false;
+
+	return result;
+}
+
+static bool djvupureContainerLoad(djvupure_container_ctx_t *ctx)
+{
+	djvupure_container_lazy_t *lazy;
+	int64_t pos;
+	bool result = false;
+
+	if(!ctx->lazy) return true;
+	if(!djvupureContainerLoadHeader(ctx)) return false;
+
+	lazy = ctx->lazy;
+	ctx->lazy = 0;
+
+	pos = lazy->io.callback_tell(lazy->fctx);
+
+	if(pos >= 0 && !lazy->io.callback_seek(lazy->fctx, lazy->start, DJVUPURE_IO_SEEK_SET)) {
+		result = djvupureContainerReadSubchunks(ctx, &(lazy->io), lazy->fctx, lazy->raw_read, true, lazy->end);
+
+		if(lazy->io.callback_seek(lazy->fctx, pos, DJVUPURE_IO_SEEK_SET)) result = false;
+	}
+
+	if(!result) { // Don't leave partially read container, it stays lazy so error is reported again
+		for(size_t i = 0; i < ctx->nof_subchunks; i++)
+			djvupureContainerDiscardChunk(ctx->arena, ctx->subchunks[i]);
+
+		ctx->nof_subchunks = 0;
+		djvupureContainerIndexFree(ctx);
+		djvupureContainerInvalidateSize(ctx);
+		ctx->lazy = lazy;
+
+		return false;
+	}
+
+	ArenaFree(ctx->arena, lazy);
+
+	return true;
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerCreate(const uint8_t subsign[4])
+{
+	djvupure_chunk_t *container;
+	
+	container = djvupureContainerAlloc(0, false);
+	if(!container) return 0;
+	
+	memcpy(container->ctx, subsign, 4);
 	
 	return container;
+}
 
-FAILURE:
-	if(container) djvupureChunkFree(container);
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerRead(djvupure_io_callback_t *io, void *fctx)
+{
+	return ContainerReadEx(io, fctx, RawChunkReadEx, false, 0, false);
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerReadLazy(djvupure_io_callback_t *io, void *fctx)
+{
+	return ContainerReadEx(io, fctx, RawChunkReadLazy, true, 0, false);
+}
+
+djvupure_chunk_t * DJVUPURE_APIENTRY ContainerReadEx(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, bool lazy, djvupure_arena_t *arena, bool is_arena_owner)
+{
+	djvupure_chunk_t *container;
+	int64_t chunk_end;
 	
-	return 0;
+	container = djvupureContainerReadHeader(io, fctx, arena, is_arena_owner, &chunk_end);
+	if(!container) return 0;
+	
+	if(!djvupureContainerReadSubchunks((djvupure_container_ctx_t *)(container->ctx), io, fctx, raw_read, lazy, chunk_end)) {
+		if(is_arena_owner) djvupureChunkFree(container);
+		else djvupureContainerDiscardChunk(arena, container);
+	
+		return 0;
+	}
+	
+	return container;
 }
 
-DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureContainerInsertChunk(djvupure_chunk_t *container, djvupure_chunk_t *chunk, size_t index)
+djvupure_chunk_t * DJVUPURE_APIENTRY ContainerReadHeaderEx(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena, bool is_arena_owner, int64_t *chunk_end)
+{
+	return djvupureContainerReadHeader(io, fctx, arena, is_arena_owner, chunk_end);
+}
+
+bool DJVUPURE_APIENTRY ContainerReadSubchunksEx(djvupure_chunk_t *container, djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, bool lazy, int64_t chunk_end)
 {
-	uintptr_t uctx;
-	size_t nof_allocsubchunks, nof_subchunks;
-	djvupure_chunk_t **subchunk;
+	djvupure_container_ctx_t *ctx;
 
-	if(djvupureChunkGetStructHash() != container->hash) return false;
-	if(!djvupureContainerCheckSign(container->sign)) return false;
+	ctx = (djvupure_container_ctx_t *)(container->ctx);
+	if(!djvupureContainerLoad(ctx)) return false;
 
-	uctx = (uintptr_t)(container->ctx);
-	nof_allocsubchunks = *((size_t *)(uctx+4+4));
-	nof_subchunks = *((size_t *)(uctx+4+4+sizeof(size_t)));
-	if(index > nof_subchunks) return false;
+	return djvupureContainerReadSubchunks(ctx, io, fctx, raw_read, lazy, chunk_end);
+}
 
-	if(nof_subchunks >= nof_allocsubchunks) {
-		void *_ctx;
+djvupure_chunk_t * DJVUPURE_APIENTRY ContainerCreateStub(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, djvupure_arena_t *arena, const uint8_t subsign[4], int64_t offset)
+{
+	djvupure_chunk_t *container;
+	djvupure_container_lazy_t *lazy;
 
-		if(nof_allocsubchunks == 0) nof_allocsubchunks = 2;
-		else nof_allocsubchunks *= 2;
+	container = djvupureContainerAlloc(arena, false);
+	if(!container) return 0;
 
-		if((SIZE_MAX-4-4-sizeof(size_t)*2)/sizeof(void *) < nof_allocsubchunks) return false;
+	memcpy(container->ctx, subsign, 4);
 
-		_ctx = realloc(container->ctx, 4+4+sizeof(size_t)*2+nof_allocsubchunks*sizeof(void *));
-		if(!_ctx) return false;
+	lazy = ArenaAlloc(arena, sizeof(djvupure_container_lazy_t));
+	if(!lazy) {
+		djvupureContainerDiscardChunk(arena, container);
 
-		container->ctx = _ctx;
-		uctx = (uintptr_t)(container->ctx);
-		*((size_t *)(uctx+4+4)) = nof_allocsubchunks;
+		return 0;
 	}
 
-	subchunk = (djvupure_chunk_t **)(uctx+4+4+sizeof(size_t)*2);
+	lazy->io = *io;
+	lazy->fctx = fctx;
+	lazy->raw_read = raw_read;
+	lazy->start = offset;
+	lazy->end = 0;
+	lazy->size = 0;
+	lazy->is_header_read = false;
+	((djvupure_container_ctx_t *)(container->ctx))->lazy = lazy;
+
+	return container;
+}
+
+bool DJVUPURE_APIENTRY ContainerLoadSubchunks(djvupure_chunk_t *container)
+{
+	djvupure_container_ctx_t *ctx;
+
+	if(djvupureChunkGetStructHash() != container->hash) return false;
+	if(!djvupureContainerCheckSign(container->sign)) return false;
 
-	for(size_t i = nof_subchunks; i > index; i--) {
-		subchunk[i] = subchunk[i-1];
+	ctx = (djvupure_container_ctx_t *)(container->ctx);
+	if(!djvupureContainerLoad(ctx)) return false;
+
+	for(size_t i = 0; i < ctx->nof_subchunks; i++) {
+		if(!ctx->subchunks[i]) return false;
+		if(!RawChunkLoad(ctx->subchunks[i])) return false;
 	}
 
-	subchunk[index] = chunk;
-	nof_subchunks++;
-	 *((size_t *)(uctx+4+4+sizeof(size_t))) = nof_subchunks;
-	 
-	 return true;
+	return true;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureContainerInsertChunk(djvupure_chunk_t *container, djvupure_chunk_t *chunk, size_t index)
+{
+	djvupure_container_ctx_t *ctx;
+
+	if(djvupureChunkGetStructHash() != container->hash) return false;
+	if(!djvupureContainerCheckSign(container->sign)) return false;
+
+	ctx = (djvupure_container_ctx_t *)(container->ctx);
+	if(!djvupureContainerLoad(ctx)) return false;
+
+	return djvupureContainerCtxInsertChunk(ctx, chunk, index);
 }
 
 DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureContainerSize(djvupure_chunk_t *container)
 {
-	uintptr_t uctx;
+	djvupure_container_ctx_t *ctx;
 	
 	if(djvupureChunkGetStructHash() != container->hash) return 0;
 	if(!djvupureContainerCheckSign(container->sign)) return 0;
 
-	uctx = (uintptr_t)(container->ctx);
-	return *((size_t *)(uctx+4+4+sizeof(size_t)));
+	ctx = (djvupure_container_ctx_t *)(container->ctx);
+	if(!djvupureContainerLoad(ctx)) return 0;
+
+	return ctx->nof_subchunks;
 }
 
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerGetSubchunk(djvupure_chunk_t *container, size_t index)
 {
-	uintptr_t uctx;
-	size_t nof_subchunks;
-	djvupure_chunk_t **subchunk;
+	djvupure_container_ctx_t *ctx;
 	
 	if(djvupureChunkGetStructHash() != container->hash) return 0;
 	if(!djvupureContainerCheckSign(container->sign)) return 0;
 
-	uctx = (uintptr_t)(container->ctx);
-	nof_subchunks = *((size_t *)(uctx+4+4+sizeof(size_t)));
-	subchunk = (djvupure_chunk_t **)(uctx+4+4+sizeof(size_t)*2);
+	ctx = (djvupure_container_ctx_t *)(container->ctx);
+	if(!djvupureContainerLoad(ctx)) return 0;
 	
-	if(index >= nof_subchunks) return 0;
+	if(index >= ctx->nof_subchunks) return 0;
 	
-	return *(subchunk+index);
+	return ctx->subchunks[index];
 }
 
-DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureContainerFindSubchunkBySign(djvupure_chunk_t *container, const uint8_t sign[4], const uint8_t subsign[4], size_t start)
+static size_t djvupureContainerIndexHash(const uint8_t sign[4], const uint8_t subsign[4])
 {
-	size_t nof_chunks, index;
+	size_t hash = 2166136261u;
 
-	nof_chunks = djvupureContainerSize(container);
+	for(size_t i = 0; i < 4; i++) hash = (hash^sign[i])*16777619u;
+	if(subsign)
+		for(size_t i = 0; i < 4; i++) hash = (hash^subsign[i])*16777619u;
+
+	return hash;
+}
+
+static djvupure_container_index_entry_t *djvupureContainerIndexFind(djvupure_container_index_t *index, const uint8_t sign[4], const uint8_t subsign[4])
+{
+	size_t mask, i;
 
-	for(index = start; index < nof_chunks; index++) {
-		djvupure_chunk_t *chunk;
+	mask = index->nof_allocentries-1;
+	i = djvupureContainerIndexHash(sign, subsign)&mask;
 
-		chunk = djvupureContainerGetSubchunk(container, index);
-		if(!chunk) return nof_chunks;
+	while(index->entries[i].is_used) { // There is always at least one unused entry
+		djvupure_container_index_entry_t *entry;
 
-		if(!memcmp(chunk->sign, sign, 4)) {
+		entry = index->entries+i;
+
+		if(!memcmp(entry->sign, sign, 4)) {
 			if(subsign) {
-				if(djvupureContainerIs(chunk, subsign)) break;
-			} else break;
+				if(entry->has_subsign && !memcmp(entry->subsign, subsign, 4)) return entry;
+			} else if(!entry->has_subsign) return entry;
 		}
+
+		i = (i+1)&mask;
 	}
 
-	return index;
+	return index->entries+i;
 }
 
-DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerGetSubchunkBySign(djvupure_chunk_t *container, const uint8_t sign[4], const uint8_t subsign[4], size_t index)
+static bool djvupureContainerIndexAddPosition(djvupure_arena_t *arena, djvupure_container_index_t *index, const uint8_t sign[4], const uint8_t subsign[4], size_t position)
 {
-	size_t nof_chunks, i = 0, count = 0;
-		
-	nof_chunks = djvupureContainerSize(container);
+	djvupure_container_index_entry_t *entry;
+
+	if(index->nof_entries*2 >= index->nof_allocentries) { // Grow hash table
+		djvupure_container_index_t new_index;
+
+		if(SIZE_MAX/2/sizeof(djvupure_container_index_entry_t) < index->nof_allocentries) return false;
+
+		new_index.nof_entries = index->nof_entries;
+		new_index.nof_allocentries = index->nof_allocentries*2;
+		new_index.entries = ArenaAlloc(arena, new_index.nof_allocentries*sizeof(djvupure_container_index_entry_t));
+		if(!new_index.entries) return false;
+		memset(new_index.entries, 0, new_index.nof_allocentries*sizeof(djvupure_container_index_entry_t));
 
-	while(count <= index) {
-		i = djvupureContainerFindSubchunkBySign(container, sign, subsign, i);
-		if(i >= nof_chunks) break;
+		for(size_t i = 0; i < index->nof_allocentries; i++) {
+			djvupure_container_index_entry_t *old_entry;
 
-		if(count == index) return djvupureContainerGetSubchunk(container, i);
+			old_entry = index->entries+i;
+			if(!old_entry->is_used) continue;
 
-		i++;
-		count++;
+			*djvupureContainerIndexFind(&new_index, old_entry->sign, old_entry->has_subsign?old_entry->subsign:0) = *old_entry;
+		}
+
+		ArenaFree(arena, index->entries);
+		*index = new_index;
 	}
 
-	return 0;
+	entry = djvupureContainerIndexFind(index, sign, subsign);
+	if(!entry->is_used) {
+		entry->is_used = true;
+		memcpy(entry->sign, sign, 4);
+		if(subsign) {
+			entry->has_subsign = true;
+			memcpy(entry->subsign, subsign, 4);
+		}
+		index->nof_entries++;
+	}
+
+	if(entry->nof_positions >= entry->nof_allocpositions) {
+		size_t *_positions, nof_allocpositions;
+
+		if(entry->nof_allocpositions == 0) nof_allocpositions = 4;
+		else nof_allocpositions = entry->nof_allocpositions*2;
+
+		if(SIZE_MAX/sizeof(size_t) < nof_allocpositions) return false;
+
+		_positions = ArenaRealloc(arena, entry->positions, entry->nof_allocpositions*sizeof(size_t), nof_allocpositions*sizeof(size_t));
+		if(!_positions) return false;
+
+		entry->positions = _positions;
+		entry->nof_allocpositions = nof_allocpositions;
+	}
+
+	entry->positions[entry->nof_positions++] = position;
+
+	return true;
 }
 
-DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureContainerCountSubchunksBySign(djvupure_chunk_t *container, const uint8_t sign[4], const uint8_t subsign[4])
+static bool djvupureContainerIndexAdd(djvupure_container_ctx_t *ctx, djvupure_chunk_t *chunk, size_t position)
 {
-	size_t nof_chunks, i = 0, count = 0;
-		
+	if(!djvupureContainerIndexAddPosition(ctx->arena, ctx->index, chunk->sign, 0, position)) return false;
+
+	if(djvupureContainerIs(chunk, 0) && chunk->ctx)
+		if(!djvupureContainerIndexAddPosition(ctx->arena, ctx->index, chunk->sign, (uint8_t *)(chunk->ctx), position)) return false;
+
+	return true;
+}
+
+static void djvupureContainerIndexFree(djvupure_container_ctx_t *ctx)
+{
+	djvupure_container_index_t *index;
+
+	if(!ctx->index) return;
+
+	index = ctx->index;
+	ctx->index = 0;
+
+	for(size_t i = 0; i < index->nof_allocentries; i++)
+		if(index->entries[i].positions) ArenaFree(ctx->arena, index->entries[i].positions);
+
+	ArenaFree(ctx->arena, index->entries);
+	ArenaFree(ctx->arena, index);
+}
+
+static djvupure_container_index_t *djvupureContainerGetIndex(djvupure_chunk_t *container)
+{
+	djvupure_container_ctx_t *ctx;
+	
+	if(djvupureChunkGetStructHash() != container->hash) return 0;
+	if(!djvupureContainerCheckSign(container->sign)) return 0;
+
+	ctx = (djvupure_container_ctx_t *)(container->ctx);
+	if(!djvupureContainerLoad(ctx)) return 0;
+
+	if(ctx->index) return ctx->index;
+
+	ctx->index = ArenaAlloc(ctx->arena, sizeof(djvupure_container_index_t));
+	if(!ctx->index) return 0;
+
+	ctx->index->nof_entries = 0;
+	ctx->index->nof_allocentries = 16;
+	ctx->index->entries = ArenaAlloc(ctx->arena, ctx->index->nof_allocentries*sizeof(djvupure_container_index_entry_t));
+	if(!ctx->index->entries) {
+		ArenaFree(ctx->arena, ctx->index);
+		ctx->index = 0;
+
+		return 0;
+	}
+	memset(ctx->index->entries, 0, ctx->index->nof_allocentries*sizeof(djvupure_container_index_entry_t));
+
+	for(size_t i = 0; i < ctx->nof_subchunks; i++)
+		if(!djvupureContainerIndexAdd(ctx, ctx->subchunks[i], i)) {
+			djvupureContainerIndexFree(ctx);
+
+			return 0;
+		}
+
+	return ctx->index;
+}
+
+DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureContainerFindSubchunkBySign(djvupure_chunk_t *container, const uint8_t sign[4], const uint8_t subsign[4], size_t start)
+{
+	djvupure_container_index_t *index;
+	djvupure_container_index_entry_t *entry;
+	size_t nof_chunks, first, last;
+
 	nof_chunks = djvupureContainerSize(container);
 
-	while(true) {
-		i = djvupureContainerFindSubchunkBySign(container, sign, subsign, i);
-		if(i >= nof_chunks) break;
+	index = djvupureContainerGetIndex(container);
+	if(!index) return nof_chunks;
+
+	entry = djvupureContainerIndexFind(index, sign, subsign);
+	if(!entry->is_used) return nof_chunks;
+
+	// Search first position not less than start
+	first = 0;
+	last = entry->nof_positions;
+	while(first < last) {
+		size_t middle;
 
-		i++;
-		count++;
+		middle = first+(last-first)/2;
+
+		if(entry->positions[middle] < start)
+			first = middle+1;
+		else
+			last = middle;
 	}
 
-	return count;
+	if(first == entry->nof_positions) return nof_chunks;
+
+	return entry->positions[first];
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureContainerGetSubchunkBySign(djvupure_chunk_t *container, const uint8_t sign[4], const uint8_t subsign[4], size_t index)
+{
+	djvupure_container_index_t *container_index;
+	djvupure_container_index_entry_t *entry;
+
+	container_index = djvupureContainerGetIndex(container);
+	if(!container_index) return 0;
+
+	entry = djvupureContainerIndexFind(container_index, sign, subsign);
+	if(!entry->is_used) return 0;
+
+	if(index >= entry->nof_positions) return 0;
+
+	return djvupureContainerGetSubchunk(container, entry->positions[index]);
 }
 
+DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureContainerCountSubchunksBySign(djvupure_chunk_t *container, const uint8_t sign[4], const uint8_t subsign[4])
+{
+	djvupure_container_index_t *index;
+	djvupure_container_index_entry_t *entry;
+
+	index = djvupureContainerGetIndex(container);
+	if(!index) return 0;
+
+	entry = djvupureContainerIndexFind(index, sign, subsign);
+	if(!entry->is_used) return 0;
+
+	return entry->nof_positions;
+}
\ No newline at end of file
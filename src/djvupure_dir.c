@@ -27,6 +27,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../include/djvupure.h"
 #include "djvupure_sign.h"
+#include "djvupure_read.h"
+#include "djvupure_bzz.h"
+#include "djvupure_allocator.h"
+#include "djvupure_jb2.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -34,11 +38,22 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 enum {
 	DJVUPURE_DIR_FILE_TYPE_SHARED = 0,
 	DJVUPURE_DIR_FILE_TYPE_PAGE = 1,
-	DJVUPURE_DIR_FILE_TYPE_THUMB = 2
+	DJVUPURE_DIR_FILE_TYPE_THUMB = 2,
+	DJVUPURE_DIR_FILE_TYPE_SHARED_ANNO = 3,
+	DJVUPURE_DIR_FILE_TYPE_MASK = 63
 };
 
 enum {
-	DJVUPURE_DIR_FLAG_BUNDLED = 128
+	DJVUPURE_DIR_FILE_FLAG_HAS_NAME = 128,
+	DJVUPURE_DIR_FILE_FLAG_HAS_TITLE = 64,
+	DJVUPURE_DIR_FILE_FLAG_IS_PAGE_0 = 1,
+	DJVUPURE_DIR_FILE_FLAG_HAS_NAME_0 = 2,
+	DJVUPURE_DIR_FILE_FLAG_HAS_TITLE_0 = 4
+};
+
+enum {
+	DJVUPURE_DIR_FLAG_BUNDLED = 128,
+	DJVUPURE_DIR_VERSION_MASK = 127
 };
 
 typedef struct {
@@ -49,11 +64,27 @@ typedef struct {
 	unsigned int type;
 } djvupure_dir_aux_file_t;
 
+typedef struct {
+	djvupure_chunk_t *chunk; // 0 if entry is unused
+	size_t page;
+} djvupure_dir_aux_page_map_entry_t;
+
+typedef struct {
+	char *id;
+	djvupure_jb2_dict_t *dict;
+} djvupure_dir_aux_dict_t;
+
 typedef struct {
 	size_t nof_files;
 	size_t nof_pages;
 	djvupure_dir_aux_file_t *files;
+	size_t *pages; // Page index -> file index
+	size_t nof_allocpagemap; // Power of 2, more than nof_pages
+	djvupure_dir_aux_page_map_entry_t *page_map; // Page chunk -> page index
+	size_t nof_dicts;
+	djvupure_dir_aux_dict_t *dicts; // Decoded shared dictionaries, they are reused by all pages
 	uint8_t flags;
+	djvupure_arena_t *arena; // If not 0, aux is freed with arena
 } djvupure_dir_aux_t;
 
 static void DJVUPURE_APIENTRY djvupureDirCallbackFreeAux(void *aux)
@@ -63,6 +94,8 @@ static void DJVUPURE_APIENTRY djvupureDirCallbackFreeAux(void *aux)
 
 	dir_aux = (djvupure_dir_aux_t *)aux;
 
+	if(dir_aux->arena) return;
+
 	if(dir_aux->files) {
 		djvupure_dir_aux_file_t *files;
 		size_t nof_files;
@@ -78,6 +111,17 @@ static void DJVUPURE_APIENTRY djvupureDirCallbackFreeAux(void *aux)
 		free(dir_aux->files);
 	}
 
+	if(dir_aux->pages) free(dir_aux->pages);
+	if(dir_aux->page_map) free(dir_aux->page_map);
+
+	if(dir_aux->dicts) {
+		for(size_t i = 0; i < dir_aux->nof_dicts; i++) {
+			free(dir_aux->dicts[i].id);
+			JB2DictFree(0, dir_aux->dicts[i].dict);
+		}
+		free(dir_aux->dicts);
+	}
+
 	free(aux);
 }
 
@@ -97,96 +141,373 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirIs(djvupure_chunk_t *dir)
 	return true;
 }
 
-DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirInit(djvupure_chunk_t *dir, djvupure_chunk_t *document)
+typedef struct {
+	size_t offset;
+	size_t file;
+} djvupure_dir_offset_t;
+
+static int djvupureDirOffsetCompare(const void *a, const void *b)
+{
+	const djvupure_dir_offset_t *offset_a, *offset_b;
+
+	offset_a = (const djvupure_dir_offset_t *)a;
+	offset_b = (const djvupure_dir_offset_t *)b;
+
+	if(offset_a->offset != offset_b->offset) return (offset_a->offset < offset_b->offset)?-1:1;
+	if(offset_a->file != offset_b->file) return (offset_a->file < offset_b->file)?-1:1;
+
+	return 0;
+}
+
+static char *djvupureDirReadString(djvupure_arena_t *arena, uint8_t **data, uint8_t *data_end)
+{
+	uint8_t *string_end;
+	char *string;
+
+	string_end = memchr(*data, 0, data_end-*data);
+	if(!string_end) return 0;
+
+	string = ArenaAlloc(arena, string_end-*data+1);
+	if(!string) return 0;
+
+	memcpy(string, *data, string_end-*data+1);
+	*data = string_end+1;
+
+	return string;
+}
+
+static uint8_t djvupureDirFileFlags(djvupure_dir_aux_t *dir_aux, uint8_t flags)
+{
+	uint8_t new_flags;
+
+	if(dir_aux->flags & DJVUPURE_DIR_VERSION_MASK) return flags;
+
+	// Old format flags
+	new_flags = (flags & DJVUPURE_DIR_FILE_FLAG_IS_PAGE_0)?DJVUPURE_DIR_FILE_TYPE_PAGE:DJVUPURE_DIR_FILE_TYPE_SHARED;
+	if(flags & DJVUPURE_DIR_FILE_FLAG_HAS_NAME_0) new_flags |= DJVUPURE_DIR_FILE_FLAG_HAS_NAME;
+	if(flags & DJVUPURE_DIR_FILE_FLAG_HAS_TITLE_0) new_flags |= DJVUPURE_DIR_FILE_FLAG_HAS_TITLE;
+
+	return new_flags;
+}
+
+// Returns true if file types, ids, names and titles were decoded
+static bool djvupureDirDecodeBZ(djvupure_dir_aux_t *dir_aux, uint8_t *bz_data, size_t bz_data_len)
+{
+	djvupure_dir_aux_file_t *files;
+	uint8_t *data, *flags, *strings, *data_end;
+	size_t data_len, nof_files;
+	bool result = false;
+
+	nof_files = dir_aux->nof_files;
+	files = dir_aux->files;
+
+	if(!bz_data_len) return false;
+	if(!BZZDecode(ArenaGetAllocator(dir_aux->arena), bz_data, bz_data_len, &data, &data_len)) return false;
+
+	// Sizes (3 bytes each), flags (1 byte each) and then zero terminated strings
+	if(data_len/4 < nof_files) goto FINAL;
+
+	flags = data+nof_files*3;
+	strings = flags+nof_files;
+	data_end = data+data_len;
+
+	for(size_t i = 0; i < nof_files; i++) {
+		uint8_t file_flags;
+
+		file_flags = djvupureDirFileFlags(dir_aux, flags[i]);
+
+		files[i].type = file_flags & DJVUPURE_DIR_FILE_TYPE_MASK;
+		if(files[i].type > DJVUPURE_DIR_FILE_TYPE_SHARED_ANNO) goto FINAL;
+
+		files[i].id = djvupureDirReadString(dir_aux->arena, &strings, data_end);
+		if(!files[i].id) goto FINAL;
+
+		if(file_flags & DJVUPURE_DIR_FILE_FLAG_HAS_NAME) {
+			files[i].name = djvupureDirReadString(dir_aux->arena, &strings, data_end);
+			if(!files[i].name) goto FINAL;
+		}
+
+		if(file_flags & DJVUPURE_DIR_FILE_FLAG_HAS_TITLE) {
+			files[i].title = djvupureDirReadString(dir_aux->arena, &strings, data_end);
+			if(!files[i].title) goto FINAL;
+		}
+	}
+
+	result = true;
+
+FINAL:
+	if(!result) {
+		for(size_t i = 0; i < nof_files; i++) {
+			if(files[i].id) ArenaFree(dir_aux->arena, files[i].id);
+			if(files[i].name) ArenaFree(dir_aux->arena, files[i].name);
+			if(files[i].title) ArenaFree(dir_aux->arena, files[i].title);
+			files[i].id = files[i].name = files[i].title = 0;
+			files[i].type = DJVUPURE_DIR_FILE_TYPE_SHARED;
+		}
+	}
+
+	AllocatorFree(ArenaGetAllocator(dir_aux->arena), data);
+
+	return result;
+}
+
+// Decodes dir data, for bundled documents offsets are sorted
+static djvupure_dir_aux_t *djvupureDirDecode(djvupure_chunk_t *dir, djvupure_dir_offset_t **offsets, bool *has_types)
 {
 	djvupure_dir_aux_t *dir_aux;
-	void *dir_data;
-	size_t dir_data_len, nof_files;
+	djvupure_arena_t *arena;
+	uint8_t *dir_data;
+	size_t dir_data_len, nof_files, raw_len;
 
-	djvupureRawChunkGetDataPointer(dir, &dir_data, &dir_data_len);
+	*offsets = 0;
+	*has_types = false;
 
-	if(!dir_data || !dir_data_len) return false;
+	djvupureRawChunkGetDataPointer(dir, (void **)&dir_data, &dir_data_len);
 
-	dir_aux = malloc(sizeof(djvupure_dir_aux_t));
-	if(!dir_aux) return false;
+	if(!dir_data || dir_data_len < 3) return 0;
+
+	// Dir from arena keeps its aux in the same arena
+	arena = RawChunkGetArena(dir);
+
+	dir_aux = ArenaAlloc(arena, sizeof(djvupure_dir_aux_t));
+	if(!dir_aux) return 0;
 
 	memset(dir_aux, 0, sizeof(djvupure_dir_aux_t));
+	dir_aux->arena = arena;
 
 	// Decode RAW part
 
-	dir_aux->flags = *((uint8_t *)dir_data);
-	nof_files = (*((uint8_t *)dir_data+1))*256+*((uint8_t *)dir_data+2);
+	dir_aux->flags = dir_data[0];
+	nof_files = dir_data[1]*256+dir_data[2];
 	dir_aux->nof_files = nof_files;
-	dir_aux->files = (djvupure_dir_aux_file_t *)malloc(nof_files *sizeof(djvupure_dir_aux_file_t));
-	if(!dir_aux->files) {
-		free(dir_aux);
+	raw_len = 3;
+	if(dir_aux->flags & DJVUPURE_DIR_FLAG_BUNDLED) raw_len += nof_files*4;
+	if(dir_data_len < raw_len) goto FAILURE;
 
-		return false;
-	}
-	memset(dir_aux->files, 0, nof_files *sizeof(djvupure_dir_aux_file_t));
+	dir_aux->files = (djvupure_dir_aux_file_t *)ArenaAlloc(arena, nof_files*sizeof(djvupure_dir_aux_file_t)+1);
+	if(!dir_aux->files) goto FAILURE;
+	memset(dir_aux->files, 0, nof_files*sizeof(djvupure_dir_aux_file_t));
 
 	if(dir_aux->flags & DJVUPURE_DIR_FLAG_BUNDLED) {
 		uint8_t *offset;
-		size_t *offsets, nof_subchunks, document_offset = 16;
-
-		offsets = (size_t *)malloc(nof_files*sizeof(size_t));
-		if(!offsets) {
-			free(dir_aux->files);
-			free(dir_aux);
 
-			return false;
-		}
+		*offsets = (djvupure_dir_offset_t *)AllocatorAlloc(ArenaGetAllocator(arena), nof_files*sizeof(djvupure_dir_offset_t)+1);
+		if(!*offsets) goto FAILURE;
 
-		offset = (uint8_t*)dir_data+3;
+		offset = dir_data+3;
 
 		for(size_t i = 0; i < nof_files; i++) {
-			offsets[i] = offset[0]*16777216+offset[1]*65536+offset[2]*256+offset[3];
+			(*offsets)[i].offset = ((size_t)offset[0]<<24)+(offset[1]<<16)+(offset[2]<<8)+offset[3];
+			(*offsets)[i].file = i;
 			offset += 4;
 		}
 
+		qsort(*offsets, nof_files, sizeof(djvupure_dir_offset_t), djvupureDirOffsetCompare);
+	}
+
+	// Decode BZ part
+	*has_types = djvupureDirDecodeBZ(dir_aux, dir_data+raw_len, dir_data_len-raw_len);
+
+	return dir_aux;
+
+FAILURE:
+	AllocatorFree(ArenaGetAllocator(arena), *offsets);
+	*offsets = 0;
+	djvupureDirCallbackFreeAux(dir_aux);
+
+	return 0;
+}
+
+static djvupure_dir_aux_page_map_entry_t *djvupureDirPageMapFind(djvupure_dir_aux_t *dir_aux, djvupure_chunk_t *chunk)
+{
+	size_t mask, i;
+
+	mask = dir_aux->nof_allocpagemap-1;
+	i = (((uintptr_t)chunk)/sizeof(void *)*2654435761u)&mask;
+
+	while(dir_aux->page_map[i].chunk && dir_aux->page_map[i].chunk != chunk) // There is always at least one unused entry
+		i = (i+1)&mask;
+
+	return dir_aux->page_map+i;
+}
+
+static bool djvupureDirAttachAux(djvupure_chunk_t *dir, djvupure_dir_aux_t *dir_aux, bool has_types)
+{
+	size_t nof_pages = 0;
+
+	for(size_t i = 0; i < dir_aux->nof_files; i++) {
+		djvupure_dir_aux_file_t *file;
+
+		file = dir_aux->files+i;
+
+		if(file->chunk == 0) continue;
+
+		// Without BZ part try to fullfill some fields manually
+		if(!has_types && djvupurePageIs(file->chunk))
+			file->type = DJVUPURE_DIR_FILE_TYPE_PAGE;
+
+		if(file->type == DJVUPURE_DIR_FILE_TYPE_PAGE && djvupurePageIs(file->chunk))
+			nof_pages++;
+	}
+
+	// Build page index and reverse map
+	dir_aux->pages = ArenaAlloc(dir_aux->arena, nof_pages*sizeof(size_t)+1);
+	if(!dir_aux->pages) return false;
+
+	dir_aux->nof_allocpagemap = 16;
+	while(dir_aux->nof_allocpagemap <= nof_pages*2) {
+		if(SIZE_MAX/2/sizeof(djvupure_dir_aux_page_map_entry_t) < dir_aux->nof_allocpagemap) return false;
+
+		dir_aux->nof_allocpagemap *= 2;
+	}
+
+	dir_aux->page_map = ArenaAlloc(dir_aux->arena, dir_aux->nof_allocpagemap*sizeof(djvupure_dir_aux_page_map_entry_t));
+	if(!dir_aux->page_map) return false;
+	memset(dir_aux->page_map, 0, dir_aux->nof_allocpagemap*sizeof(djvupure_dir_aux_page_map_entry_t));
+
+	for(size_t i = 0; i < dir_aux->nof_files; i++) {
+		djvupure_dir_aux_file_t *file;
+		djvupure_dir_aux_page_map_entry_t *entry;
+
+		file = dir_aux->files+i;
+
+		if(file->type != DJVUPURE_DIR_FILE_TYPE_PAGE || !file->chunk || !djvupurePageIs(file->chunk)) continue;
+
+		entry = djvupureDirPageMapFind(dir_aux, file->chunk);
+		if(!entry->chunk) {
+			entry->chunk = file->chunk;
+			entry->page = dir_aux->nof_pages;
+		}
+
+		dir_aux->pages[dir_aux->nof_pages++] = i;
+	}
+
+	dir->aux = (void *)dir_aux;
+	dir->callback_free_aux = djvupureDirCallbackFreeAux;
+
+	return true;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirInit(djvupure_chunk_t *dir, djvupure_chunk_t *document)
+{
+	djvupure_dir_aux_t *dir_aux;
+	djvupure_dir_offset_t *offsets;
+	bool has_types;
+
+	dir_aux = djvupureDirDecode(dir, &offsets, &has_types);
+	if(!dir_aux) return false;
+
+	if(offsets) {
+		size_t nof_files, nof_subchunks, document_offset = 16, j = 0;
+
+		nof_files = dir_aux->nof_files;
 		nof_subchunks = djvupureContainerSize(document);
 
-		for(size_t index = 0; index < nof_subchunks; index++) {
+		// Both subchunks and offsets are sorted, so match them in one pass
+		for(size_t index = 0; index < nof_subchunks && j < nof_files; index++) {
 			djvupure_chunk_t *subchunk;
 
 			if(document_offset%2) document_offset++;
 
 			subchunk = djvupureContainerGetSubchunk(document, index);
 			if(!subchunk) continue;
-			
-			for(size_t i = 0; i < nof_files; i++) {
-				if(offsets[i] == document_offset) {
-					dir_aux->files[i].chunk = subchunk;
 
-					break;
-				}
+			while(j < nof_files && offsets[j].offset < document_offset) j++;
+
+			if(j < nof_files && offsets[j].offset == document_offset) {
+				dir_aux->files[offsets[j].file].chunk = subchunk;
+				j++;
 			}
 
 			document_offset += djvupureChunkSize(subchunk);
 		}
 
-		free(offsets);
+		AllocatorFree(ArenaGetAllocator(dir_aux->arena), offsets);
 	}
 
-	// Decode BZ part
-	// Here must be BZ decoder but for now we try to fullfill some fields manually
-	for(size_t i = 0; i < nof_files; i++) {
-		djvupure_dir_aux_file_t *file;
+	if(!djvupureDirAttachAux(dir, dir_aux, has_types)) {
+		djvupureDirCallbackFreeAux(dir_aux);
 
-		file = dir_aux->files+i;
+		return false;
+	}
 
-		if(file->chunk == 0) continue;
+	return true;
+}
 
-		if(djvupurePageIs(file->chunk)) {
-			file->type = DJVUPURE_DIR_FILE_TYPE_PAGE;
-			dir_aux->nof_pages++;
+bool DJVUPURE_APIENTRY DirInitLazy(djvupure_chunk_t *dir, djvupure_chunk_t *document, djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, int64_t chunk_end)
+{
+	djvupure_dir_aux_t *dir_aux;
+	djvupure_dir_offset_t *offsets;
+	djvupure_chunk_t *last = 0;
+	size_t nof_files, last_size;
+	int64_t pos;
+	bool has_types;
+
+	dir_aux = djvupureDirDecode(dir, &offsets, &has_types);
+	if(!dir_aux) return false;
+
+	// File types are needed to create stubs without reading
+	if(!offsets || !has_types || dir_aux->nof_files == 0) goto FAILURE;
+
+	nof_files = dir_aux->nof_files;
+
+	pos = io->callback_tell(fctx);
+	if(pos < 0 || (uint64_t)pos > offsets[0].offset) goto FAILURE;
+	if((uint64_t)chunk_end <= offsets[nof_files-1].offset) goto FAILURE;
+	for(size_t j = 0; j < nof_files; j++) {
+		if(offsets[j].offset%2) goto FAILURE;
+		if(j > 0 && offsets[j].offset == offsets[j-1].offset) goto FAILURE;
+	}
+
+	// Read chunks between dir and first file, like NAVM
+	if(!ContainerReadSubchunksEx(document, io, fctx, raw_read, true, offsets[0].offset)) goto FAILURE;
+	if((uint64_t)io->callback_tell(fctx) > offsets[0].offset) goto FAILURE;
+
+	// Only files listed in dir are expected between first and last file
+	for(size_t j = 0; j < nof_files; j++) {
+		const uint8_t *subsign;
+
+		switch(dir_aux->files[offsets[j].file].type) {
+			case DJVUPURE_DIR_FILE_TYPE_PAGE:
+				subsign = djvupure_page_sign;
+				break;
+			case DJVUPURE_DIR_FILE_TYPE_THUMB:
+				subsign = djvupure_thum_sign;
+				break;
+			default:
+				subsign = djvupure_djvi_sign;
+		}
+
+		last = ContainerCreateStub(io, fctx, raw_read, dir_aux->arena, subsign, offsets[j].offset);
+		if(!last) goto FAILURE;
+
+		if(!djvupureContainerInsertChunk(document, last, djvupureContainerSize(document))) {
+			if(!dir_aux->arena) djvupureChunkFree(last);
+
+			goto FAILURE;
 		}
+
+		dir_aux->files[offsets[j].file].chunk = last;
 	}
 
-	dir->aux = (void *)dir_aux;
-	dir->callback_free_aux = djvupureDirCallbackFreeAux;
+	// Read chunks after last file
+	last_size = djvupureChunkSize(last);
+	if(last_size <= 8) goto FAILURE;
+	if(io->callback_seek(fctx, offsets[nof_files-1].offset+last_size, DJVUPURE_IO_SEEK_SET)) goto FAILURE;
+	if(!ContainerReadSubchunksEx(document, io, fctx, raw_read, true, chunk_end)) goto FAILURE;
+
+	AllocatorFree(ArenaGetAllocator(dir_aux->arena), offsets);
+	offsets = 0;
+
+	if(!djvupureDirAttachAux(dir, dir_aux, has_types)) goto FAILURE;
 
 	return true;
+
+FAILURE:
+	AllocatorFree(ArenaGetAllocator(dir_aux->arena), offsets);
+	djvupureDirCallbackFreeAux(dir_aux);
+
+	return false;
 }
 
 DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureDirCountPages(djvupure_chunk_t *dir)
@@ -204,8 +525,6 @@ DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureDirCountPages(djvupure_chun
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDirGetPage(djvupure_chunk_t *dir, size_t index, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close)
 {
 	djvupure_dir_aux_t *dir_aux;
-	djvupure_dir_aux_file_t *files;
-	size_t nof_files, count = 0;
 
 	(void)openu8;
 	(void)close;
@@ -217,24 +536,25 @@ DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDirGetPage(djvu
 
 	if(index >= dir_aux->nof_pages) return 0;
 
-	nof_files = dir_aux->nof_files;
-	files = dir_aux->files;
+	return dir_aux->files[dir_aux->pages[index]].chunk;
+}
 
-	for(size_t i = 0; i < nof_files; i++) {
-		if(files[i].type == DJVUPURE_DIR_FILE_TYPE_PAGE) {
-			if(index != count) {
-				count++;
+DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureDirFindPage(djvupure_chunk_t *dir, djvupure_chunk_t *page)
+{
+	djvupure_dir_aux_t *dir_aux;
+	djvupure_dir_aux_page_map_entry_t *entry;
 
-				continue;
-			}
+	if(!djvupureDirIs(dir)) return 0;
+	if(dir->aux == 0) return 0;
 
-			if(!djvupurePageIs(files[i].chunk)) return 0;
+	dir_aux = (djvupure_dir_aux_t *)(dir->aux);
 
-			return files[i].chunk;
-		}
-	}
+	if(!page) return dir_aux->nof_pages;
 
-	return 0;
+	entry = djvupureDirPageMapFind(dir_aux, page);
+	if(!entry->chunk) return dir_aux->nof_pages;
+
+	return entry->page;
 }
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirPutPage(djvupure_chunk_t *dir, djvupure_chunk_t *page, bool changed, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close)
@@ -260,3 +580,53 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDirPutPage(djvupure_chunk_t *
 
 	return true;
 }
+
+
+djvupure_jb2_dict_t * DJVUPURE_APIENTRY DirGetDict(djvupure_chunk_t *dir, const char *id, unsigned int depth)
+{
+	djvupure_dir_aux_t *dir_aux;
+	djvupure_dir_aux_dict_t *dicts;
+	djvupure_jb2_dict_t *dict;
+	djvupure_chunk_t *file = 0;
+	char *dict_id;
+	size_t id_len;
+
+	if(!djvupureDirIs(dir)) return 0;
+	if(dir->aux == 0) return 0;
+
+	dir_aux = (djvupure_dir_aux_t *)(dir->aux);
+
+	for(size_t i = 0; i < dir_aux->nof_dicts; i++)
+		if(!strcmp(dir_aux->dicts[i].id, id)) return dir_aux->dicts[i].dict;
+
+	for(size_t i = 0; i < dir_aux->nof_files; i++)
+		if(dir_aux->files[i].id && !strcmp(dir_aux->files[i].id, id)) {
+			file = dir_aux->files[i].chunk;
+			break;
+		}
+
+	if(!file) return 0;
+	if(!djvupureContainerIs(file, djvupure_djvi_sign)) return 0;
+	if(djvupureContainerFindSubchunkBySign(file, djvupure_djbz_sign, 0, 0) == djvupureContainerSize(file)) return 0;
+
+	// Dictionary lives as long as dir, so it's allocated the same way
+	if(!JB2GetDict(dir_aux->arena, file, dir, depth, &dict)) return 0;
+
+	id_len = strlen(id);
+	dict_id = ArenaAlloc(dir_aux->arena, id_len+1);
+	dicts = ArenaRealloc(dir_aux->arena, dir_aux->dicts, dir_aux->nof_dicts*sizeof(djvupure_dir_aux_dict_t), (dir_aux->nof_dicts+1)*sizeof(djvupure_dir_aux_dict_t));
+	if(dicts) dir_aux->dicts = dicts;
+	if(!dict_id || !dicts) {
+		if(dict_id) ArenaFree(dir_aux->arena, dict_id);
+		JB2DictFree(dir_aux->arena, dict);
+
+		return 0;
+	}
+
+	memcpy(dict_id, id, id_len+1);
+	dir_aux->dicts[dir_aux->nof_dicts].id = dict_id;
+	dir_aux->dicts[dir_aux->nof_dicts].dict = dict;
+	dir_aux->nof_dicts++;
+
+	return dict;
+}
\ No newline at end of file
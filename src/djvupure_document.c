@@ -27,6 +27,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../include/djvupure.h"
 #include "djvupure_sign.h"
+#include "djvupure_read.h"
 
 #include <string.h>
 
@@ -39,14 +40,103 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentIs(djvupure_chunk_t *
 }
 
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentRead(djvupure_io_callback_t *io, void *fctx)
+{
+	return djvupureDocumentReadWithFlags(io, fctx, 0);
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentReadLazy(djvupure_io_callback_t *io, void *fctx)
+{
+	return djvupureDocumentReadWithFlags(io, fctx, DJVUPURE_DOCUMENT_FLAG_LAZY);
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentReadWithFlags(djvupure_io_callback_t *io, void *fctx, uint32_t flags)
+{
+	return DocumentReadEx(io, fctx, (flags & DJVUPURE_DOCUMENT_FLAG_LAZY)?RawChunkReadLazy:RawChunkReadEx, flags, 0);
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentReadWithAllocator(djvupure_io_callback_t *io, void *fctx, uint32_t flags, djvupure_allocator_t *allocator)
+{
+	return DocumentReadEx(io, fctx, (flags & DJVUPURE_DOCUMENT_FLAG_LAZY)?RawChunkReadLazy:RawChunkReadEx, flags, allocator);
+}
+
+// If arena is requested, each read attempt gets its own arena owned by document
+static bool djvupureDocumentCreateArena(uint32_t flags, djvupure_allocator_t *allocator, djvupure_arena_t **arena)
+{
+	*arena = 0;
+
+	if(!(flags & DJVUPURE_DOCUMENT_FLAG_ARENA) && !allocator) return true;
+
+	*arena = ArenaCreate(allocator);
+
+	return *arena != 0;
+}
+
+// Bundled document is read using dir offsets, so only header and dir are read here
+static djvupure_chunk_t *djvupureDocumentReadBundleLazy(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, djvupure_arena_t *arena)
+{
+	djvupure_chunk_t *document, *dir;
+	int64_t chunk_end;
+
+	document = ContainerReadHeaderEx(io, fctx, arena, arena != 0, &chunk_end);
+	if(!document) return 0;
+
+	if(!djvupureContainerIs(document, djvupure_document_sign)) goto FAILURE;
+
+	dir = raw_read(io, fctx, arena);
+	if(!dir) goto FAILURE;
+
+	if(!djvupureContainerInsertChunk(document, dir, 0)) {
+		if(!arena) djvupureChunkFree(dir);
+
+		goto FAILURE;
+	}
+
+	if(!djvupureDirIs(dir)) goto FAILURE;
+
+	if(!DirInitLazy(dir, document, io, fctx, raw_read, chunk_end)) goto FAILURE;
+
+	return document;
+
+FAILURE:
+	djvupureChunkFree(document);
+
+	return 0;
+}
+
+djvupure_chunk_t * DJVUPURE_APIENTRY DocumentReadEx(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, uint32_t flags, djvupure_allocator_t *allocator)
 {
 	uint8_t sign[4];
 	djvupure_chunk_t *document;
+	djvupure_arena_t *arena;
+	bool lazy;
+
+	lazy = (flags & DJVUPURE_DOCUMENT_FLAG_LAZY) != 0;
+
+	if(allocator)
+		if(allocator->hash != djvupureAllocatorGetStructHash()) return 0;
 	
 	if(io->callback_read(fctx, sign, 4) != 4) return 0;
 	if(memcmp(sign, djvupure_atnt_sign, 4)) return 0;
+
+	if(lazy) {
+		int64_t pos;
+
+		pos = io->callback_tell(fctx);
+		if(pos < 0) return 0;
+
+		if(!djvupureDocumentCreateArena(flags, allocator, &arena)) return 0;
+
+		document = djvupureDocumentReadBundleLazy(io, fctx, raw_read, arena);
+		if(document) return document;
+
+		// Fall back to reading all top level chunks
+		if(io->callback_seek(fctx, pos, DJVUPURE_IO_SEEK_SET)) return 0;
+	}
+
+	if(!djvupureDocumentCreateArena(flags, allocator, &arena)) return 0;
 	
-	document = djvupureContainerRead(io, fctx);
+	// Arena is destroyed with document
+	document = ContainerReadEx(io, fctx, raw_read, lazy, arena, arena != 0);
 	if(!document) return 0;
 
 	if(djvupureContainerIs(document, djvupure_document_sign)) {
@@ -112,6 +202,21 @@ DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentGetPage
 	return djvupureDirGetPage(dir, index, openu8, close);
 }
 
+DJVUPURE_API size_t DJVUPURE_APIENTRY_EXPORT djvupureDocumentFindPage(djvupure_chunk_t *document, djvupure_chunk_t *page)
+{
+	djvupure_chunk_t *dir;
+
+	if(!djvupureDocumentIs(document)) return 0;
+	if(djvupureContainerIs(document, djvupure_page_sign)) return (document == page)?0:1;
+
+	dir = djvupureContainerGetSubchunk(document, 0);
+	if(!dir) return 0;
+
+	if(!djvupureDirIs(dir)) return 0;
+
+	return djvupureDirFindPage(dir, page);
+}
+
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureDocumentPutPage(djvupure_chunk_t *document, djvupure_chunk_t *page, bool changed, djvupure_io_callback_openu8_t openu8, djvupure_io_callback_close_t close)
 {
 	djvupure_chunk_t *dir;
@@ -55,5 +55,21 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpGetInfo(djvupure_chunk_t
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpDecode(djvupure_chunk_t *fgjp, uint16_t width, uint16_t height, void *buf)
 {
-	return JpegDecode(fgjp, width, height, buf);
+	return JpegDecode(0, fgjp, width, height, buf);
 }
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpGetReducedInfo(djvupure_chunk_t *fgjp, uint8_t factor, uint16_t *width, uint16_t *height)
+{
+	if(!djvupureFGjpIs(fgjp)) return false;
+
+	return JpegGetReducedInfo(fgjp, factor, width, height);
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureFGjpDecodeReduced(djvupure_chunk_t *fgjp, uint8_t factor, void *buf)
+{
+	uint16_t width, height;
+
+	if(!djvupureFGjpGetReducedInfo(fgjp, factor, &width, &height)) return false;
+
+	return JpegDecode(0, fgjp, width, height, buf);
+}
\ No newline at end of file
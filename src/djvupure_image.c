@@ -26,14 +26,47 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "../include/djvupure.h"
+#include "djvupure_image.h"
+#include "djvupure_allocator.h"
 
+// Allocator is passed as stb allocation context
+#define STBIR_MALLOC(size,c) AllocatorAlloc((djvupure_allocator_t *)(c), size)
+#define STBIR_FREE(ptr,c) AllocatorFree((djvupure_allocator_t *)(c), ptr)
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "third_party/stb_image_resize.h"
 
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DJVUPURE_IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define DJVUPURE_IMAGE_TILE 16
+
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageRotate(uint16_t old_width, uint16_t old_height, uint16_t new_width, uint16_t new_height, uint8_t channels, uint8_t rot, uint8_t *buffer)
+{
+	return ImageRotateEx(0, old_width, old_height, new_width, new_height, channels, rot, buffer);
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageRotateCopy(uint16_t width, uint16_t height, const uint8_t *src, uint8_t *dst, uint8_t channels, uint8_t rot)
+{
+	size_t src_stride, dst_stride;
+
+	if(!width || !height || !channels || !src || !dst) return false;
+	if(SIZE_MAX/width < channels) return false;
+	if(SIZE_MAX/height < (size_t)width*(size_t)channels) return false;
+
+	src_stride = (size_t)width*(size_t)channels;
+	dst_stride = (rot == 5 || rot == 6)?(size_t)height*(size_t)channels:src_stride;
+
+	ImageRotateCopy(width, height, src, src_stride, dst, dst_stride, channels, rot);
+
+	return true;
+}
+
+bool DJVUPURE_APIENTRY ImageRotateEx(djvupure_allocator_t *allocator, uint16_t old_width, uint16_t old_height, uint16_t new_width, uint16_t new_height, uint8_t channels, uint8_t rot, uint8_t *buffer)
 {
 	uint8_t *new_buffer = 0;
 
@@ -45,7 +78,7 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageRotate(uint16_t old_widt
 		case 5: // 90deg
 		case 6: // 270deg
 			if(old_width != new_height || old_height != new_width) return false;
-			new_buffer = malloc((size_t)new_width*(size_t)new_height*(size_t)channels);
+			new_buffer = AllocatorAlloc(allocator, (size_t)new_width*(size_t)new_height*(size_t)channels);
 			if(!new_buffer) return false;
 			break;
 		case 1: // 0deg
@@ -92,59 +125,626 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageRotate(uint16_t old_widt
 		}
 	}
 
-	if(rot == 5) {
-		uint8_t *p1;
+	if(new_buffer) {
+		ImageRotateCopy(old_width, old_height, buffer, (size_t)old_width*(size_t)channels, new_buffer, (size_t)new_width*(size_t)channels, channels, rot);
+		memcpy(buffer, new_buffer, (size_t)new_width*(size_t)new_height*(size_t)channels);
+		AllocatorFree(allocator, new_buffer);
+	}
 
-		p1 = buffer;
+	return true;
+}
 
-		for(size_t y = 0; y < (size_t)old_height; y++) {
-			for(size_t x = 0; x < old_width; x++) {
-				uint8_t *p2;
+// Copies tile of tile_width x tile_height pixels starting at x, y of src to its place in rotated dst
+static void ImageRotateTile(uint16_t width, uint16_t height, const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, uint8_t channels, uint8_t rot, size_t x, size_t y, size_t tile_width, size_t tile_height)
+{
+	for(size_t tx = x; tx < x+tile_width; tx++) {
+		const uint8_t *p1;
+		uint8_t *p2;
+		ptrdiff_t step;
+
+		p1 = src+y*src_stride+tx*channels;
+		if(rot == 5) { // Column of src is row of dst from right to left
+			p2 = dst+tx*dst_stride+((size_t)height-y-1)*channels;
+			step = -(ptrdiff_t)channels;
+		} else { // Column of src is row of dst from left to right
+			p2 = dst+((size_t)width-tx-1)*dst_stride+y*channels;
+			step = channels;
+		}
 
-				p2 = new_buffer+(size_t)channels*((size_t)new_width*x+((size_t)new_width-y-1));
+		if(channels == 1) {
+			for(size_t ty = 0; ty < tile_height; ty++, p1 += src_stride, p2 += step)
+				*p2 = *p1;
+		} else if(channels == 3) {
+			for(size_t ty = 0; ty < tile_height; ty++, p1 += src_stride, p2 += step) {
+				p2[0] = p1[0];
+				p2[1] = p1[1];
+				p2[2] = p1[2];
+			}
+		} else {
+			for(size_t ty = 0; ty < tile_height; ty++, p1 += src_stride, p2 += step)
+				memcpy(p2, p1, channels);
+		}
+	}
+}
 
-				for(size_t c = 0; c < channels; c++) {
-					*(p2++) = *(p1++);
+#if defined(DJVUPURE_IMAGE_SSE2)
+// Same as ImageRotateTile for full 16x16 tile of 1 channel image
+// Transposition is done by 4 rounds of unpacks, after them column c is in vector with bit reversed index
+static void ImageRotateTile16SSE2(uint16_t width, uint16_t height, const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, uint8_t rot, size_t x, size_t y)
+{
+	static const uint8_t reversed[16] = {0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+	__m128i a[16], b[16];
+	unsigned int i;
+
+	// For 90 degrees rows are loaded from bottom, so columns are already reversed
+	for(i = 0; i < 16; i++)
+		a[i] = _mm_loadu_si128((const __m128i *)(src+(y+(rot == 5?15-i:i))*src_stride+x));
+
+	for(i = 0; i < 8; i++) {
+		b[i] = _mm_unpacklo_epi8(a[2*i], a[2*i+1]);
+		b[i+8] = _mm_unpackhi_epi8(a[2*i], a[2*i+1]);
+	}
+	for(i = 0; i < 8; i++) {
+		a[i] = _mm_unpacklo_epi16(b[2*i], b[2*i+1]);
+		a[i+8] = _mm_unpackhi_epi16(b[2*i], b[2*i+1]);
+	}
+	for(i = 0; i < 8; i++) {
+		b[i] = _mm_unpacklo_epi32(a[2*i], a[2*i+1]);
+		b[i+8] = _mm_unpackhi_epi32(a[2*i], a[2*i+1]);
+	}
+	for(i = 0; i < 8; i++) {
+		a[i] = _mm_unpacklo_epi64(b[2*i], b[2*i+1]);
+		a[i+8] = _mm_unpackhi_epi64(b[2*i], b[2*i+1]);
+	}
+
+	for(i = 0; i < 16; i++) {
+		uint8_t *p;
+
+		if(rot == 5)
+			p = dst+(x+i)*dst_stride+((size_t)height-y-16);
+		else
+			p = dst+((size_t)width-x-i-1)*dst_stride+y;
+
+		_mm_storeu_si128((__m128i *)p, a[reversed[i]]);
+	}
+}
+#endif
+
+void DJVUPURE_APIENTRY ImageRotateCopy(uint16_t width, uint16_t height, const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, uint8_t channels, uint8_t rot)
+{
+	size_t row_size;
+
+	row_size = (size_t)width*(size_t)channels;
+
+	if(rot == 5 || rot == 6) {
+		for(size_t y = 0; y < height; y += DJVUPURE_IMAGE_TILE) {
+			size_t tile_height;
+
+			tile_height = height-y < DJVUPURE_IMAGE_TILE ? height-y : DJVUPURE_IMAGE_TILE;
+
+			for(size_t x = 0; x < width; x += DJVUPURE_IMAGE_TILE) {
+				size_t tile_width;
+
+				tile_width = width-x < DJVUPURE_IMAGE_TILE ? width-x : DJVUPURE_IMAGE_TILE;
+
+#if defined(DJVUPURE_IMAGE_SSE2)
+				if(channels == 1 && tile_width == 16 && tile_height == 16) {
+					ImageRotateTile16SSE2(width, height, src, src_stride, dst, dst_stride, rot, x, y);
+
+					continue;
 				}
+#endif
+
+				ImageRotateTile(width, height, src, src_stride, dst, dst_stride, channels, rot, x, y, tile_width, tile_height);
 			}
 		}
+	} else if(rot == 2) { // 180deg, rows are reversed from bottom to top
+		for(size_t y = 0; y < height; y++) {
+			const uint8_t *p1;
+			uint8_t *p2;
+
+			p1 = src+y*src_stride;
+			p2 = dst+((size_t)height-y-1)*dst_stride+row_size-channels;
+
+			for(size_t x = 0; x < width; x++, p1 += channels, p2 -= channels)
+				memcpy(p2, p1, channels);
+		}
+	} else {
+		for(size_t y = 0; y < height; y++)
+			memcpy(dst+y*dst_stride, src+y*src_stride, row_size);
 	}
+}
 
-	if(rot == 6) {
-		uint8_t *p1;
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageResizeFine(uint16_t old_width, uint16_t old_height, const uint8_t *old_buffer, uint16_t new_width, uint16_t new_height, uint8_t *new_buffer, uint8_t channels)
+{
+	return ImageResizeFineEx(0, old_width, old_height, old_buffer, new_width, new_height, new_buffer, channels);
+}
 
-		p1 = buffer;
+bool DJVUPURE_APIENTRY ImageResizeFineEx(djvupure_allocator_t *allocator, uint16_t old_width, uint16_t old_height, const uint8_t *old_buffer, uint16_t new_width, uint16_t new_height, uint8_t *new_buffer, uint8_t channels)
+{
+	return ImageResizeRegionEx(allocator, old_width, old_height, old_buffer, new_width, new_height, 0, 0, new_width, new_height, new_buffer, channels);
+}
 
-		for(size_t y = 0; y < (size_t)old_height; y++) {
-			for(size_t x = 0; x < old_width; x++) {
-				uint8_t *p2;
+// Downscales by integer factors kx, ky, every pixel is an average of kx*ky pixels
+static bool ImageResizeBox(djvupure_allocator_t *allocator, uint16_t old_width, const uint8_t *old_buffer, uint32_t kx, uint32_t ky, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *region_buffer, uint8_t channels)
+{
+	uint32_t *sums, area;
+	size_t row_size;
+
+	row_size = (size_t)region_width*channels;
+	area = kx*ky;
+
+	sums = AllocatorAlloc(allocator, row_size*sizeof(uint32_t));
+	if(!sums) return false;
+
+	for(size_t row = 0; row < region_height; row++) {
+		memset(sums, 0, row_size*sizeof(uint32_t));
+
+		for(size_t old_row = ((size_t)y+row)*ky; old_row < ((size_t)y+row+1)*ky; old_row++) {
+			const uint8_t *p;
+			uint32_t *s;
+
+			p = old_buffer+(old_row*old_width+(size_t)x*kx)*channels;
+			s = sums;
+
+			for(size_t col = 0; col < region_width; col++, s += channels)
+				for(uint32_t k = 0; k < kx; k++)
+					for(size_t c = 0; c < channels; c++)
+						s[c] += *(p++);
+		}
+
+		for(size_t i = 0; i < row_size; i++)
+			*(region_buffer++) = (uint8_t)((sums[i]+area/2)/area);
+	}
+
+	AllocatorFree(allocator, sums);
+
+	return true;
+}
+
+#define DJVUPURE_IMAGE_AREA_BITS 14
+
+typedef struct {
+	uint32_t first; // First covered pixel
+	uint32_t count;
+	size_t weights; // Index of first weight
+} djvupure_image_contrib_t;
+
+// Finds pixels of old_size line covered by pixels first..first+count-1 of new_size line and their shares in them
+// Weights are fixed point with DJVUPURE_IMAGE_AREA_BITS bits, weights of every pixel sum to one
+static bool ImageAreaContributors(djvupure_allocator_t *allocator, uint16_t old_size, uint16_t new_size, uint16_t first, uint16_t count, djvupure_image_contrib_t **contribs, uint16_t **weights)
+{
+	size_t max_count, pos = 0;
+
+	max_count = (size_t)old_size/new_size+2;
+
+	*contribs = AllocatorAlloc(allocator, (size_t)count*sizeof(djvupure_image_contrib_t));
+	*weights = AllocatorAlloc(allocator, (size_t)count*max_count*sizeof(uint16_t));
+	if(!(*contribs) || !(*weights)) {
+		AllocatorFree(allocator, *contribs);
+		AllocatorFree(allocator, *weights);
+		*contribs = 0;
+		*weights = 0;
+
+		return false;
+	}
+
+	for(uint32_t i = 0; i < count; i++) {
+		uint64_t start, end;
+		uint32_t sum = 0;
+		size_t max_pos;
+
+		// Pixel j of old line is [j*new_size, (j+1)*new_size), pixel i of new line is [i*old_size, (i+1)*old_size)
+		start = (uint64_t)(first+i)*old_size;
+		end = start+old_size;
+
+		(*contribs)[i].first = (uint32_t)(start/new_size);
+		(*contribs)[i].count = (uint32_t)((end-1)/new_size)-(*contribs)[i].first+1;
+		(*contribs)[i].weights = pos;
+
+		max_pos = pos;
+		for(uint32_t j = (*contribs)[i].first; j < (*contribs)[i].first+(*contribs)[i].count; j++) {
+			uint64_t from, to;
+			uint16_t weight;
+
+			from = (uint64_t)j*new_size;
+			to = from+new_size;
+			if(from < start) from = start;
+			if(to > end) to = end;
+
+			weight = (uint16_t)(((to-from)<<DJVUPURE_IMAGE_AREA_BITS)/old_size);
+			if(pos == (*contribs)[i].weights || weight > (*weights)[max_pos]) max_pos = pos;
+			(*weights)[pos++] = weight;
+			sum += weight;
+		}
+
+		// Rounding error goes to the largest share
+		(*weights)[max_pos] += (uint16_t)((1 << DJVUPURE_IMAGE_AREA_BITS)-sum);
+	}
+
+	return true;
+}
+
+// Adds row multiplied by weight to sums
+static void ImageAreaAccumulate(uint32_t *sums, const uint16_t *row, uint16_t weight, size_t size)
+{
+	size_t i = 0;
+
+#if defined(DJVUPURE_IMAGE_SSE2)
+	__m128i w;
+
+	w = _mm_set1_epi16((short)weight);
+
+	for(; i+8 <= size; i += 8) {
+		__m128i v, lo, hi;
+
+		v = _mm_loadu_si128((const __m128i *)(row+i));
+		lo = _mm_mullo_epi16(v, w);
+		hi = _mm_mulhi_epu16(v, w);
+		_mm_storeu_si128((__m128i *)(sums+i), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sums+i)), _mm_unpacklo_epi16(lo, hi)));
+		_mm_storeu_si128((__m128i *)(sums+i+4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(sums+i+4)), _mm_unpackhi_epi16(lo, hi)));
+	}
+#endif
+
+	for(; i < size; i++)
+		sums[i] += (uint32_t)row[i]*weight;
+}
+
+// Downscales with area averaging for any ratio, columns are filtered first into 8.8 fixed point row, then rows are summed
+static bool ImageResizeArea(djvupure_allocator_t *allocator, uint16_t old_width, uint16_t old_height, const uint8_t *old_buffer, uint16_t new_width, uint16_t new_height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *region_buffer, uint8_t channels)
+{
+	djvupure_image_contrib_t *col_contribs = 0, *row_contribs = 0;
+	uint16_t *col_weights = 0, *row_weights = 0, *row = 0;
+	uint32_t *sums = 0;
+	size_t row_size;
+	bool result = false;
+
+	row_size = (size_t)region_width*channels;
+
+	if(!ImageAreaContributors(allocator, old_width, new_width, x, region_width, &col_contribs, &col_weights)) goto FINAL;
+	if(!ImageAreaContributors(allocator, old_height, new_height, y, region_height, &row_contribs, &row_weights)) goto FINAL;
+
+	row = AllocatorAlloc(allocator, row_size*sizeof(uint16_t));
+	sums = AllocatorAlloc(allocator, row_size*sizeof(uint32_t));
+	if(!row || !sums) goto FINAL;
+
+	for(size_t i = 0; i < region_height; i++) {
+		memset(sums, 0, row_size*sizeof(uint32_t));
 
-				p2 = new_buffer+(size_t)channels*((size_t)new_width*(new_height-x-1)+y);
+		for(uint32_t j = 0; j < row_contribs[i].count; j++) {
+			const uint8_t *p;
+			uint16_t *r;
+
+			p = old_buffer+(size_t)(row_contribs[i].first+j)*old_width*channels;
+			r = row;
+
+			for(size_t col = 0; col < region_width; col++) {
+				const uint8_t *pc;
+				const uint16_t *w;
+
+				pc = p+(size_t)col_contribs[col].first*channels;
+				w = col_weights+col_contribs[col].weights;
 
 				for(size_t c = 0; c < channels; c++) {
-					*(p2++) = *(p1++);
+					uint32_t s = 0;
+
+					for(uint32_t k = 0; k < col_contribs[col].count; k++)
+						s += (uint32_t)pc[k*channels+c]*w[k];
+
+					*(r++) = (uint16_t)((s+(1 << (DJVUPURE_IMAGE_AREA_BITS-9))) >> (DJVUPURE_IMAGE_AREA_BITS-8));
 				}
 			}
+
+			ImageAreaAccumulate(sums, row, row_weights[row_contribs[i].weights+j], row_size);
 		}
-	}
 
-	if(new_buffer) {
-		memcpy(buffer, new_buffer, (size_t)new_width*(size_t)new_height*(size_t)channels);
-		free(new_buffer);
+		for(size_t k = 0; k < row_size; k++)
+			*(region_buffer++) = (uint8_t)((sums[k]+(1 << (DJVUPURE_IMAGE_AREA_BITS+7))) >> (DJVUPURE_IMAGE_AREA_BITS+8));
 	}
 
-	return true;
+	result = true;
+
+FINAL:
+	AllocatorFree(allocator, col_contribs);
+	AllocatorFree(allocator, col_weights);
+	AllocatorFree(allocator, row_contribs);
+	AllocatorFree(allocator, row_weights);
+	AllocatorFree(allocator, row);
+	AllocatorFree(allocator, sums);
+
+	return result;
 }
 
-DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureImageResizeFine(uint16_t old_width, uint16_t old_height, const uint8_t *old_buffer, uint16_t new_width, uint16_t new_height, uint8_t *new_buffer, uint8_t channels)
+bool DJVUPURE_APIENTRY ImageResizeRegionEx(djvupure_allocator_t *allocator, uint16_t old_width, uint16_t old_height, const uint8_t *old_buffer, uint16_t new_width, uint16_t new_height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *region_buffer, uint8_t channels)
 {
 	int ret;
 
-	ret = stbir_resize_uint8(
+	if(!new_width || !new_height || !region_width || !region_height) return false;
+	if(x > new_width-region_width || y > new_height-region_height) return false;
+
+	if(old_width == new_width && old_height == new_height) {
+		for(size_t row = 0; row < region_height; row++)
+			memcpy(region_buffer+row*region_width*channels, old_buffer+((size_t)(y+row)*old_width+x)*channels, (size_t)region_width*channels);
+
+		return true;
+	}
+
+	// Downscales are area averaged, stb_image_resize is used for upscales
+	if(old_width >= new_width && old_height >= new_height) {
+		// Sums of box must fit into 32 bits
+		if(old_width%new_width == 0 && old_height%new_height == 0 && (uint32_t)(old_width/new_width)*(old_height/new_height) <= 65536)
+			return ImageResizeBox(allocator, old_width, old_buffer, old_width/new_width, old_height/new_height, x, y, region_width, region_height, region_buffer, channels);
+		else
+			return ImageResizeArea(allocator, old_width, old_height, old_buffer, new_width, new_height, x, y, region_width, region_height, region_buffer, channels);
+	}
+
+	// Same parameters as stbir_resize_uint8, region is given in input texture coordinates
+	ret = stbir_resize_region(
 		old_buffer, old_width, old_height, 0,
-		new_buffer, new_width, new_height, 0,
-		channels);
+		region_buffer, region_width, region_height, 0,
+		STBIR_TYPE_UINT8, channels, STBIR_ALPHA_CHANNEL_NONE, 0,
+		STBIR_EDGE_CLAMP, STBIR_EDGE_CLAMP, STBIR_FILTER_DEFAULT, STBIR_FILTER_DEFAULT, STBIR_COLORSPACE_LINEAR,
+		allocator,
+		(float)x/new_width, (float)y/new_height, (float)(x+region_width)/new_width, (float)(y+region_height)/new_height);
 
 	return ret?true:false;
 }
 
+
+
+// Numbers of set bits in bytes
+#define DJVUPURE_IMAGE_BITS2(n) n, n+1, n+1, n+2
+#define DJVUPURE_IMAGE_BITS4(n) DJVUPURE_IMAGE_BITS2(n), DJVUPURE_IMAGE_BITS2(n+1), DJVUPURE_IMAGE_BITS2(n+1), DJVUPURE_IMAGE_BITS2(n+2)
+#define DJVUPURE_IMAGE_BITS6(n) DJVUPURE_IMAGE_BITS4(n), DJVUPURE_IMAGE_BITS4(n+1), DJVUPURE_IMAGE_BITS4(n+1), DJVUPURE_IMAGE_BITS4(n+2)
+static const uint8_t image_bits_count[256] = {DJVUPURE_IMAGE_BITS6(0), DJVUPURE_IMAGE_BITS6(1), DJVUPURE_IMAGE_BITS6(1), DJVUPURE_IMAGE_BITS6(2)};
+
+// Counts set bits from start to end (not including) of packed row
+static uint32_t ImageCountBits(const uint8_t *p, uint32_t start, uint32_t end)
+{
+	uint32_t count, first, last;
+	uint8_t first_mask, last_mask;
+
+	if(start >= end) return 0;
+
+	first = start >> 3;
+	last = (end-1) >> 3;
+	first_mask = (uint8_t)(0xFF >> (start & 7));
+	last_mask = (uint8_t)(0xFF << (7-((end-1) & 7)));
+
+	if(first == last) return image_bits_count[p[first] & first_mask & last_mask];
+
+	count = image_bits_count[p[first] & first_mask];
+	for(uint32_t i = first+1; i < last; i++)
+		count += image_bits_count[p[i]];
+	count += image_bits_count[p[last] & last_mask];
+
+	return count;
+}
+
+// Bytes with reversed order of bits
+#define DJVUPURE_IMAGE_REV2(n) n, n+128, n+64, n+192
+#define DJVUPURE_IMAGE_REV4(n) DJVUPURE_IMAGE_REV2(n), DJVUPURE_IMAGE_REV2(n+32), DJVUPURE_IMAGE_REV2(n+16), DJVUPURE_IMAGE_REV2(n+48)
+#define DJVUPURE_IMAGE_REV6(n) DJVUPURE_IMAGE_REV4(n), DJVUPURE_IMAGE_REV4(n+8), DJVUPURE_IMAGE_REV4(n+4), DJVUPURE_IMAGE_REV4(n+12)
+static const uint8_t image_bits_reversed[256] = {DJVUPURE_IMAGE_REV6(0), DJVUPURE_IMAGE_REV6(2), DJVUPURE_IMAGE_REV6(1), DJVUPURE_IMAGE_REV6(3)};
+
+// Copies nof_bits of packed row starting at src_bit to start of dst, unused bits of last byte are cleared. dst may be equal to src
+static void ImageCopyBits(const uint8_t *src, size_t src_bit, uint8_t *dst, size_t nof_bits)
+{
+	size_t nof_bytes, src_bytes;
+	unsigned int shift;
+
+	if(!nof_bits) return;
+
+	src += src_bit >> 3;
+	shift = (unsigned int)(src_bit & 7);
+	nof_bytes = (nof_bits+7)/8;
+
+	if(!shift)
+		memmove(dst, src, nof_bytes);
+	else {
+		// Byte after the last covered one isn't read
+		src_bytes = (shift+nof_bits+7)/8;
+
+		for(size_t i = 0; i < nof_bytes; i++)
+			dst[i] = (uint8_t)((src[i] << shift)|(i+1 < src_bytes?src[i+1] >> (8-shift):0));
+	}
+
+	if(nof_bits & 7) dst[nof_bytes-1] &= (uint8_t)(0xFF << (8-(nof_bits & 7)));
+}
+
+// Writes region as mask or as packed bitmap, rows of region are buf_stride bytes apart
+static bool ImageMaskFromBitsCore(djvupure_allocator_t *allocator, const uint8_t *bits, size_t stride, uint32_t bits_x, uint32_t bits_y, uint16_t bits_width, uint16_t bits_height, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *buf, size_t buf_stride, bool is_packed)
+{
+	uint32_t *sums;
+	uint16_t *col_starts;
+	uint32_t first_col, first_row;
+
+	if(!width || !height || width > bits_width || height > bits_height) return false;
+	if(x > width || region_width > width-x || y > height || region_height > height-y) return false;
+
+	// Bitmap must start before first pixel covered by region
+	first_col = (uint32_t)x*bits_width/width;
+	first_row = (uint32_t)y*bits_height/height;
+	if(first_col < bits_x || first_row < bits_y) return false;
+
+	if(width == bits_width && height == bits_height) {
+		for(size_t row = 0; row < region_height; row++) {
+			const uint8_t *p;
+			uint8_t *dst;
+
+			p = bits+(y-bits_y+row)*stride;
+			dst = buf+row*buf_stride;
+
+			if(is_packed) {
+				ImageCopyBits(p, x-bits_x, dst, region_width);
+
+				continue;
+			}
+
+			for(size_t col = x-bits_x; col < x-bits_x+region_width; col++)
+				*(dst++) = ((p[col>>3]>>(7-(col&7)))&1)?0:255;
+		}
+
+		return true;
+	}
+
+	sums = AllocatorAlloc(allocator, (size_t)region_width*sizeof(uint32_t)+1);
+	col_starts = AllocatorAlloc(allocator, ((size_t)region_width+1)*sizeof(uint16_t));
+	if(!sums || !col_starts) {
+		AllocatorFree(allocator, sums);
+		AllocatorFree(allocator, col_starts);
+
+		return false;
+	}
+
+	for(size_t col = 0; col <= region_width; col++)
+		col_starts[col] = (uint16_t)(((uint32_t)x+col)*bits_width/width-bits_x);
+
+	for(size_t row = 0; row < region_height; row++) {
+		uint32_t row_start, row_end, nof_rows;
+		uint8_t *dst;
+
+		row_start = ((uint32_t)y+row)*bits_height/height-bits_y;
+		row_end = ((uint32_t)y+row+1)*bits_height/height-bits_y;
+		nof_rows = row_end-row_start;
+
+		memset(sums, 0, (size_t)region_width*sizeof(uint32_t));
+
+		for(uint32_t bits_row = row_start; bits_row < row_end; bits_row++) {
+			const uint8_t *p;
+
+			p = bits+bits_row*stride;
+
+			for(size_t col = 0; col < region_width; col++)
+				sums[col] += ImageCountBits(p, col_starts[col], col_starts[col+1]);
+		}
+
+		dst = buf+row*buf_stride;
+		if(is_packed) memset(dst, 0, ((size_t)region_width+7)/8);
+
+		// Each pixel is a share of white pixels in covered area
+		for(size_t col = 0; col < region_width; col++) {
+			uint32_t count;
+			uint8_t value;
+
+			count = (uint32_t)(col_starts[col+1]-col_starts[col])*nof_rows;
+			value = (uint8_t)(((count-sums[col])*255+count/2)/count);
+
+			if(!is_packed)
+				dst[col] = value;
+			else if(value < 128)
+				dst[col>>3] |= (uint8_t)(0x80 >> (col&7));
+		}
+	}
+
+	AllocatorFree(allocator, sums);
+	AllocatorFree(allocator, col_starts);
+
+	return true;
+}
+
+bool DJVUPURE_APIENTRY ImageMaskFromBitsRegion(djvupure_allocator_t *allocator, const uint8_t *bits, size_t stride, uint32_t bits_x, uint32_t bits_y, uint16_t bits_width, uint16_t bits_height, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *buf)
+{
+	return ImageMaskFromBitsCore(allocator, bits, stride, bits_x, bits_y, bits_width, bits_height, width, height, x, y, region_width, region_height, buf, region_width, false);
+}
+
+bool DJVUPURE_APIENTRY ImageBitsFromBitsRegion(djvupure_allocator_t *allocator, const uint8_t *bits, size_t stride, uint32_t bits_x, uint32_t bits_y, uint16_t bits_width, uint16_t bits_height, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *region_bits, size_t region_stride)
+{
+	return ImageMaskFromBitsCore(allocator, bits, stride, bits_x, bits_y, bits_width, bits_height, width, height, x, y, region_width, region_height, region_bits, region_stride, true);
+}
+
+// Transposes 8x8 block of bits, byte 7 is the first row and its msb is the first column
+static uint64_t ImageTransposeBits8(uint64_t x)
+{
+	uint64_t t;
+
+	t = (x^(x >> 7))&0x00AA00AA00AA00AAULL;
+	x = x^t^(t << 7);
+	t = (x^(x >> 14))&0x0000CCCC0000CCCCULL;
+	x = x^t^(t << 14);
+	t = (x^(x >> 28))&0x00000000F0F0F0F0ULL;
+	x = x^t^(t << 28);
+
+	return x;
+}
+
+void DJVUPURE_APIENTRY ImageRotateBitsCopy(uint16_t width, uint16_t height, const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, uint8_t rot)
+{
+	size_t row_size;
+
+	row_size = ((size_t)width+7)/8;
+
+	switch(rot) {
+		case 5: // 90deg
+		case 6: // 270deg
+			// Byte column g of dst is made of 8 rows of src, each of their bytes gives 8 rows of dst
+			for(size_t g = 0; g < ((size_t)height+7)/8; g++) {
+				const uint8_t *rows[8];
+
+				for(size_t k = 0; k < 8; k++) {
+					size_t src_row;
+
+					src_row = 8*g+k;
+					if(src_row >= height) rows[k] = 0;
+					else if(rot == 5) rows[k] = src+((size_t)height-src_row-1)*src_stride;
+					else rows[k] = src+src_row*src_stride;
+				}
+
+				for(size_t b = 0; b < row_size; b++) {
+					uint64_t block = 0;
+
+					for(size_t k = 0; k < 8; k++)
+						block = (block << 8)|(rows[k]?rows[k][b]:0);
+
+					block = ImageTransposeBits8(block);
+
+					for(size_t j = 0; j < 8 && 8*b+j < width; j++) {
+						uint8_t *p;
+
+						if(rot == 5)
+							p = dst+(8*b+j)*dst_stride+g;
+						else
+							p = dst+((size_t)width-8*b-j-1)*dst_stride+g;
+
+						*p = (uint8_t)(block >> (56-8*j));
+					}
+				}
+			}
+			break;
+		case 2: // 180deg
+			// Bytes are reversed in place of dst row, then bits after the end of src row are shifted out
+			for(size_t y = 0; y < height; y++) {
+				const uint8_t *p1;
+				uint8_t *p2;
+
+				p1 = src+((size_t)height-y-1)*src_stride;
+				p2 = dst+y*dst_stride;
+
+				for(size_t i = 0; i < row_size; i++)
+					p2[i] = image_bits_reversed[p1[row_size-i-1]];
+
+				ImageCopyBits(p2, row_size*8-width, p2, width);
+			}
+			break;
+		case 1: // 0deg
+		default:
+			for(size_t y = 0; y < height; y++)
+				ImageCopyBits(src+y*src_stride, 0, dst+y*dst_stride, width);
+	}
+}
+
+bool DJVUPURE_APIENTRY ImageBitmapAlloc(djvupure_allocator_t *allocator, djvupure_bitmap_t *bitmap, uint16_t width, uint16_t height)
+{
+	bitmap->stride = ((size_t)width+7)/8;
+	bitmap->width = width;
+	bitmap->height = height;
+	bitmap->bits = AllocatorAlloc(allocator, bitmap->stride*height);
+
+	return bitmap->bits != 0;
+}
+
+void DJVUPURE_APIENTRY ImageBitmapFree(djvupure_allocator_t *allocator, djvupure_bitmap_t *bitmap)
+{
+	if(bitmap->bits) AllocatorFree(allocator, bitmap->bits);
+	bitmap->bits = 0;
+}
\ No newline at end of file
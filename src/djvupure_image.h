@@ -0,0 +1,71 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*Internal module for image processing*/
+
+#ifndef DJVUPURE_IMAGE_H
+#define DJVUPURE_IMAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+
+// Packed 1-bpp bitmap, 1 is black, most significant bit is left pixel. Rows are stride bytes apart
+typedef struct {
+	uint8_t *bits;
+	size_t stride;
+	uint16_t width;
+	uint16_t height;
+} djvupure_bitmap_t;
+
+// Allocates bitmap with rows of (width+7)/8 bytes, bits aren't cleared
+bool DJVUPURE_APIENTRY ImageBitmapAlloc(djvupure_allocator_t *allocator, djvupure_bitmap_t *bitmap, uint16_t width, uint16_t height);
+void DJVUPURE_APIENTRY ImageBitmapFree(djvupure_allocator_t *allocator, djvupure_bitmap_t *bitmap);
+
+// Same as djvupureImageRotate and djvupureImageResizeFine, temporary buffers are allocated with allocator (0 means malloc)
+bool DJVUPURE_APIENTRY ImageRotateEx(djvupure_allocator_t *allocator, uint16_t old_width, uint16_t old_height, uint16_t new_width, uint16_t new_height, uint8_t channels, uint8_t rot, uint8_t *buffer);
+// Rotates width x height image from src to dst (rot is same as in djvupureImageRotate), buffers must not overlap
+// Rows of images are stride bytes apart. 90 and 270 degrees are transposed by cache sized tiles
+void DJVUPURE_APIENTRY ImageRotateCopy(uint16_t width, uint16_t height, const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, uint8_t channels, uint8_t rot);
+bool DJVUPURE_APIENTRY ImageResizeFineEx(djvupure_allocator_t *allocator, uint16_t old_width, uint16_t old_height, const uint8_t *old_buffer, uint16_t new_width, uint16_t new_height, uint8_t *new_buffer, uint8_t channels);
+// Resizes image to new_width x new_height, but writes only region starting at x, y
+bool DJVUPURE_APIENTRY ImageResizeRegionEx(djvupure_allocator_t *allocator, uint16_t old_width, uint16_t old_height, const uint8_t *old_buffer, uint16_t new_width, uint16_t new_height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *region_buffer, uint8_t channels);
+// Converts packed bitmap (1 is black, msb is left pixel) of bits_width*bits_height pixels to mask (0 is black) reduced to width*height with area averaging
+// Only region is written. First pixel of bits is at bits_x, bits_y of bitmap, bits must cover x*bits_width/width to (x+region_width)*bits_width/width and same for rows
+bool DJVUPURE_APIENTRY ImageMaskFromBitsRegion(djvupure_allocator_t *allocator, const uint8_t *bits, size_t stride, uint32_t bits_x, uint32_t bits_y, uint16_t bits_width, uint16_t bits_height, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *buf);
+// Same as ImageMaskFromBitsRegion, but region is written as packed bitmap with rows region_stride bytes apart. Pixel is black if its mask value would be less than 128
+bool DJVUPURE_APIENTRY ImageBitsFromBitsRegion(djvupure_allocator_t *allocator, const uint8_t *bits, size_t stride, uint32_t bits_x, uint32_t bits_y, uint16_t bits_width, uint16_t bits_height, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *region_bits, size_t region_stride);
+// Same as ImageRotateCopy for packed bitmaps, 90 and 270 degrees are transposed by 8x8 blocks of bits. Unused bits at ends of dst rows are cleared
+void DJVUPURE_APIENTRY ImageRotateBitsCopy(uint16_t width, uint16_t height, const uint8_t *src, size_t src_stride, uint8_t *dst, size_t dst_stride, uint8_t rot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -77,15 +77,16 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureInfoIs(djvupure_chunk_t *info
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureInfoGet(djvupure_chunk_t *info_chunk, djvupure_page_info_t *info_struct)
 {
-	uintptr_t uctx;
+	void *data;
+	size_t data_len;
 	uint8_t *chunk_data;
 
 	if(!djvupureInfoIs(info_chunk)) return false;
 	if(!info_chunk->ctx) return false;
 	
-	uctx = (uintptr_t)(info_chunk->ctx);
-	if(*((size_t*)(info_chunk->ctx)) != djvupure_info_len) return false;
-	chunk_data = (uint8_t *)(uctx+sizeof(size_t));
+	djvupureRawChunkGetDataPointer(info_chunk, &data, &data_len);
+	if(!data || data_len != djvupure_info_len) return false;
+	chunk_data = (uint8_t *)data;
 
 	info_struct->width = (uint16_t)(chunk_data[0])*256+chunk_data[1];
 	info_struct->height = (uint16_t)(chunk_data[2])*256+chunk_data[3];
@@ -98,15 +99,16 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureInfoGet(djvupure_chunk_t *inf
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureInfoPut(djvupure_chunk_t *info_chunk, djvupure_page_info_t *info_struct)
 {
-	uintptr_t uctx;
+	void *data;
+	size_t data_len;
 	uint8_t *chunk_data;
 
 	if(!djvupureInfoIs(info_chunk)) return false;
 	if(!info_chunk->ctx) return false;
 	
-	uctx = (uintptr_t)(info_chunk->ctx);
-	if(*((size_t*)(info_chunk->ctx)) != djvupure_info_len) return false;
-	chunk_data = (uint8_t *)(uctx+sizeof(size_t));
+	djvupureRawChunkGetDataPointer(info_chunk, &data, &data_len);
+	if(!data || data_len != djvupure_info_len) return false;
+	chunk_data = (uint8_t *)data;
 
 	chunk_data[0] = info_struct->width/256;
 	chunk_data[1] = info_struct->width%256;
@@ -0,0 +1,837 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "djvupure_iw44.h"
+#include "djvupure_zp.h"
+#include "djvupure_image.h"
+#include "djvupure_allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// SSE2 path is enabled with DJVUPURE_IW44_SSE2, it's defined when compiler targets SSE2
+// unless DJVUPURE_IW44_NO_SSE2 is defined
+#if !defined(DJVUPURE_IW44_SSE2) && !defined(DJVUPURE_IW44_NO_SSE2) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DJVUPURE_IW44_SSE2
+#endif
+
+#ifdef DJVUPURE_IW44_SSE2
+#include <emmintrin.h>
+#endif
+
+#define IW44_MAJOR 1
+#define IW44_MINOR 2
+#define IW44_MAJOR_GRAY 0x80
+#define IW44_CRCB_FULL 0x80
+
+#define IW44_BLOCK_SIZE 32
+#define IW44_BLOCK_LEN 1024
+#define IW44_NOF_BANDS 10
+#define IW44_SHIFT 6
+#define IW44_MAX_SCALE 16
+
+// Coefficient and bucket states
+#define IW44_ZERO 1
+#define IW44_ACTIVE 2
+#define IW44_NEW 4
+#define IW44_UNK 8
+
+// First bucket and number of buckets in each band
+static const struct {
+	uint8_t start;
+	uint8_t size;
+} iw44_bands[IW44_NOF_BANDS] = {
+	{ 0, 1 },
+	{ 1, 1 }, { 2, 1 }, { 3, 1 },
+	{ 4, 4 }, { 8, 4 }, { 12, 4 },
+	{ 16, 16 }, { 32, 16 }, { 48, 16 }
+};
+
+static const int32_t iw44_quant[16] = {
+	0x004000,
+	0x008000, 0x008000, 0x010000,
+	0x010000, 0x010000, 0x020000,
+	0x020000, 0x020000, 0x040000,
+	0x040000, 0x040000, 0x080000,
+	0x040000, 0x040000, 0x080000
+};
+
+typedef struct {
+	uint8_t serial;
+	uint8_t slices;
+	uint8_t major;
+	uint8_t minor;
+	uint16_t width;
+	uint16_t height;
+	uint8_t crcb_delay;
+	size_t data_start;
+} djvupure_iw44_header_t;
+
+// Coefficients of one color component and state of its decoder
+typedef struct {
+	uint16_t width;
+	uint16_t height;
+	size_t block_width; // Width and height padded to block size
+	size_t block_height;
+	size_t nof_blocks;
+	int16_t *coeffs; // Blocks of 64 buckets with 16 coefficients
+	int32_t quant_lo[16];
+	int32_t quant_hi[IW44_NOF_BANDS];
+	int band;
+	int bit;
+	uint8_t coeff_state[256];
+	uint8_t bucket_state[16];
+	djvupure_zp_context_t ctx_start[32];
+	djvupure_zp_context_t ctx_bucket[IW44_NOF_BANDS][8];
+	djvupure_zp_context_t ctx_mant;
+	djvupure_zp_context_t ctx_root;
+} djvupure_iw44_map_t;
+
+typedef struct {
+	djvupure_iw44_map_t y;
+	djvupure_iw44_map_t cb;
+	djvupure_iw44_map_t cr;
+	bool is_color;
+	bool is_crcb_half;
+	int crcb_delay;
+	int serial;
+	int slice;
+} djvupure_iw44_t;
+
+static bool IW44ParseHeader(const uint8_t *data, size_t data_len, djvupure_iw44_header_t *header)
+{
+	if(data_len < 2) return false;
+
+	header->serial = data[0];
+	header->slices = data[1];
+	header->data_start = 2;
+
+	if(header->serial) return true;
+
+	if(data_len < 8) return false;
+
+	header->major = data[2];
+	header->minor = data[3];
+	header->width = (uint16_t)((data[4]<<8)|data[5]);
+	header->height = (uint16_t)((data[6]<<8)|data[7]);
+	header->crcb_delay = 0;
+	header->data_start = 8;
+
+	if((header->major&0x7f) != IW44_MAJOR || header->minor > IW44_MINOR) return false;
+	if(!header->width || !header->height) return false;
+
+	if(header->minor >= 2) {
+		if(data_len < 9) return false;
+
+		header->crcb_delay = data[8];
+		header->data_start = 9;
+	}
+
+	return true;
+}
+
+bool DJVUPURE_APIENTRY IW44GetInfo(djvupure_chunk_t *iw44, uint16_t *width, uint16_t *height)
+{
+	djvupure_iw44_header_t header;
+	void *chunk_data = 0;
+	size_t chunk_data_len = 0;
+
+	djvupureRawChunkGetDataPointer(iw44, &chunk_data, &chunk_data_len);
+	if(!chunk_data || !chunk_data_len) return false;
+
+	if(!IW44ParseHeader((const uint8_t *)chunk_data, chunk_data_len, &header)) return false;
+	if(header.serial) return false;
+
+	*width = header.width;
+	*height = header.height;
+
+	return true;
+}
+
+static bool IW44MapInit(djvupure_allocator_t *allocator, djvupure_iw44_map_t *map, uint16_t width, uint16_t height)
+{
+	size_t i, j;
+
+	map->width = width;
+	map->height = height;
+	map->block_width = ((size_t)width+IW44_BLOCK_SIZE-1)&~(size_t)(IW44_BLOCK_SIZE-1);
+	map->block_height = ((size_t)height+IW44_BLOCK_SIZE-1)&~(size_t)(IW44_BLOCK_SIZE-1);
+	map->nof_blocks = (map->block_width/IW44_BLOCK_SIZE)*(map->block_height/IW44_BLOCK_SIZE);
+
+	if(SIZE_MAX/sizeof(int16_t)/IW44_BLOCK_LEN < map->nof_blocks) return false;
+	map->coeffs = AllocatorAlloc(allocator, map->nof_blocks*IW44_BLOCK_LEN*sizeof(int16_t));
+	if(!map->coeffs) return false;
+	memset(map->coeffs, 0, map->nof_blocks*IW44_BLOCK_LEN*sizeof(int16_t));
+
+	// Low band has own threshold for each coefficient
+	for(i = 0; i < 4; i++)
+		map->quant_lo[i] = iw44_quant[i];
+	for(j = 0; j < 3; j++)
+		for(i = 0; i < 4; i++)
+			map->quant_lo[4+j*4+i] = iw44_quant[4+j];
+	map->quant_hi[0] = 0;
+	for(i = 1; i < IW44_NOF_BANDS; i++)
+		map->quant_hi[i] = iw44_quant[i+6];
+
+	map->band = 0;
+	map->bit = 1;
+
+	memset(map->ctx_start, 0, sizeof(map->ctx_start));
+	memset(map->ctx_bucket, 0, sizeof(map->ctx_bucket));
+	map->ctx_mant = 0;
+	map->ctx_root = 0;
+
+	return true;
+}
+
+static void IW44MapFree(djvupure_allocator_t *allocator, djvupure_iw44_map_t *map)
+{
+	if(map->coeffs) AllocatorFree(allocator, map->coeffs);
+	map->coeffs = 0;
+}
+
+static bool IW44MapIsNullSlice(djvupure_iw44_map_t *map)
+{
+	if(map->band == 0) {
+		bool is_null = true;
+
+		for(int i = 0; i < 16; i++) {
+			map->coeff_state[i] = IW44_ZERO;
+			if(map->quant_lo[i] > 0 && map->quant_lo[i] < 0x8000) {
+				map->coeff_state[i] = IW44_UNK;
+				is_null = false;
+			}
+		}
+
+		return is_null;
+	} else
+		return !(map->quant_hi[map->band] > 0 && map->quant_hi[map->band] < 0x8000);
+}
+
+static void IW44DecodeBuckets(djvupure_zp_t *zp, djvupure_iw44_map_t *map, int16_t *block, int band, int fbucket, int nbucket)
+{
+	uint8_t *cstate;
+	int bbstate = 0, thres, buckno, i;
+
+	// Prepare states of coefficients
+	cstate = map->coeff_state;
+	if(fbucket) {
+		for(buckno = 0; buckno < nbucket; buckno++, cstate += 16) {
+			const int16_t *pcoeff;
+			int bstate = 0;
+
+			pcoeff = block+(fbucket+buckno)*16;
+			for(i = 0; i < 16; i++) {
+				cstate[i] = pcoeff[i]?IW44_ACTIVE:IW44_UNK;
+				bstate |= cstate[i];
+			}
+
+			map->bucket_state[buckno] = (uint8_t)bstate;
+			bbstate |= bstate;
+		}
+	} else {
+		for(i = 0; i < 16; i++) {
+			if(cstate[i] != IW44_ZERO)
+				cstate[i] = block[i]?IW44_ACTIVE:IW44_UNK;
+			bbstate |= cstate[i];
+		}
+
+		map->bucket_state[0] = (uint8_t)bbstate;
+	}
+
+	// Root bit
+	if(nbucket < 16 || (bbstate&IW44_ACTIVE))
+		bbstate |= IW44_NEW;
+	else if(bbstate&IW44_UNK) {
+		if(ZPDecode(zp, &(map->ctx_root))) bbstate |= IW44_NEW;
+	}
+
+	if(!(bbstate&IW44_NEW) && !(bbstate&IW44_ACTIVE)) return;
+
+	// Bucket bits, context depends on coefficients of parent band
+	if(bbstate&IW44_NEW) {
+		for(buckno = 0; buckno < nbucket; buckno++) {
+			int ctx = 0;
+
+			if(!(map->bucket_state[buckno]&IW44_UNK)) continue;
+
+			if(band > 0) {
+				const int16_t *b;
+
+				b = block+(fbucket+buckno)*4;
+				if(b[0]) ctx++;
+				if(b[1]) ctx++;
+				if(b[2]) ctx++;
+				if(ctx < 3 && b[3]) ctx++;
+			}
+			if(bbstate&IW44_ACTIVE) ctx |= 4;
+
+			if(ZPDecode(zp, &(map->ctx_bucket[band][ctx]))) map->bucket_state[buckno] |= IW44_NEW;
+		}
+	}
+
+	// New coefficients and their signs
+	if(bbstate&IW44_NEW) {
+		thres = map->quant_hi[band];
+		cstate = map->coeff_state;
+		for(buckno = 0; buckno < nbucket; buckno++, cstate += 16) {
+			int16_t *pcoeff;
+			int gotcha = 0;
+
+			if(!(map->bucket_state[buckno]&IW44_NEW)) continue;
+
+			pcoeff = block+(fbucket+buckno)*16;
+
+			for(i = 0; i < 16; i++)
+				if(cstate[i]&IW44_UNK) gotcha++;
+
+			for(i = 0; i < 16; i++) {
+				int ctx;
+
+				if(!(cstate[i]&IW44_UNK)) continue;
+
+				if(band == 0) thres = map->quant_lo[i];
+
+				ctx = (gotcha >= 7)?7:gotcha;
+				if(map->bucket_state[buckno]&IW44_ACTIVE) ctx |= 8;
+
+				if(ZPDecode(zp, &(map->ctx_start[ctx]))) {
+					int halfthres, coeff;
+
+					halfthres = thres>>1;
+					coeff = thres+halfthres-(halfthres>>2);
+
+					cstate[i] |= IW44_NEW;
+					pcoeff[i] = (int16_t)(ZPDecodePassthroughIW(zp)?-coeff:coeff);
+					gotcha = 0;
+				} else if(gotcha > 0)
+					gotcha--;
+			}
+		}
+	}
+
+	// Mantissa bits of active coefficients
+	if(bbstate&IW44_ACTIVE) {
+		thres = map->quant_hi[band];
+		cstate = map->coeff_state;
+		for(buckno = 0; buckno < nbucket; buckno++, cstate += 16) {
+			int16_t *pcoeff;
+
+			if(!(map->bucket_state[buckno]&IW44_ACTIVE)) continue;
+
+			pcoeff = block+(fbucket+buckno)*16;
+
+			for(i = 0; i < 16; i++) {
+				int coeff;
+
+				if(!(cstate[i]&IW44_ACTIVE)) continue;
+
+				coeff = (pcoeff[i] < 0)?-pcoeff[i]:pcoeff[i];
+				if(band == 0) thres = map->quant_lo[i];
+
+				if(coeff <= 3*thres) {
+					coeff += thres>>2;
+					if(ZPDecode(zp, &(map->ctx_mant))) coeff += thres>>1;
+					else coeff = coeff-thres+(thres>>1);
+				} else {
+					if(ZPDecodePassthroughIW(zp)) coeff += thres>>1;
+					else coeff = coeff-thres+(thres>>1);
+				}
+
+				pcoeff[i] = (int16_t)((pcoeff[i] > 0)?coeff:-coeff);
+			}
+		}
+	}
+}
+
+// Decodes next slice, returns false if all slices are decoded
+static int IW44MapDecodeSlice(djvupure_zp_t *zp, djvupure_iw44_map_t *map)
+{
+	if(map->bit < 0) return 0;
+
+	if(!IW44MapIsNullSlice(map)) {
+		for(size_t i = 0; i < map->nof_blocks; i++)
+			IW44DecodeBuckets(zp, map, map->coeffs+i*IW44_BLOCK_LEN, map->band, iw44_bands[map->band].start, iw44_bands[map->band].size);
+	}
+
+	map->quant_hi[map->band] >>= 1;
+	if(map->band == 0)
+		for(int i = 0; i < 16; i++)
+			map->quant_lo[i] >>= 1;
+
+	if(++map->band >= IW44_NOF_BANDS) {
+		map->band = 0;
+		map->bit++;
+		if(map->quant_hi[IW44_NOF_BANDS-1] == 0) {
+			map->bit = -1;
+
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static bool IW44DecodeChunk(djvupure_allocator_t *allocator, djvupure_iw44_t *iw44, const uint8_t *data, size_t data_len)
+{
+	djvupure_iw44_header_t header;
+	djvupure_zp_t zp;
+	int nof_slices, flag = 1;
+
+	if(!IW44ParseHeader(data, data_len, &header)) return false;
+	if(header.serial != iw44->serial) return false;
+
+	if(iw44->serial == 0) {
+		iw44->is_color = !(header.major&IW44_MAJOR_GRAY);
+		iw44->crcb_delay = 0;
+		iw44->is_crcb_half = false;
+		if(header.minor >= 2) {
+			iw44->crcb_delay = header.crcb_delay&0x7f;
+			iw44->is_crcb_half = !(header.crcb_delay&IW44_CRCB_FULL);
+		}
+
+		if(!IW44MapInit(allocator, &(iw44->y), header.width, header.height)) return false;
+		if(iw44->is_color) {
+			if(!IW44MapInit(allocator, &(iw44->cb), header.width, header.height)) return false;
+			if(!IW44MapInit(allocator, &(iw44->cr), header.width, header.height)) return false;
+		}
+	}
+
+	nof_slices = iw44->slice+header.slices;
+
+	ZPInit(&zp, data+header.data_start, data_len-header.data_start);
+
+	while(flag && iw44->slice < nof_slices) {
+		flag = IW44MapDecodeSlice(&zp, &(iw44->y));
+		if(iw44->is_color && iw44->crcb_delay <= iw44->slice) {
+			flag |= IW44MapDecodeSlice(&zp, &(iw44->cb));
+			flag |= IW44MapDecodeSlice(&zp, &(iw44->cr));
+		}
+		iw44->slice++;
+
+		// Truncated chunk, image stays at current quality
+		if(zp.is_overrun) break;
+	}
+
+	iw44->serial++;
+
+	return true;
+}
+
+// q[i] -= (9*(m1[i]+p1[i])-(m3[i]+p3[i])+16)>>5 for every scale'th of n elements
+static void IW44LiftRow(int16_t *q, const int16_t *m1, const int16_t *p1, const int16_t *m3, const int16_t *p3, size_t n, size_t scale)
+{
+	size_t i = 0;
+
+#ifdef DJVUPURE_IW44_SSE2
+	if(scale == 1) {
+		const __m128i round = _mm_set1_epi32(16);
+
+		for(; i+8 <= n; i += 8) {
+			__m128i vq, vm1, vp1, vm3, vp3, a, b, t_lo, t_hi;
+
+			vq = _mm_loadu_si128((const __m128i *)(q+i));
+			vm1 = _mm_loadu_si128((const __m128i *)(m1+i));
+			vp1 = _mm_loadu_si128((const __m128i *)(p1+i));
+			vm3 = _mm_loadu_si128((const __m128i *)(m3+i));
+			vp3 = _mm_loadu_si128((const __m128i *)(p3+i));
+
+			// Sums don't fit in 16 bits, so they are computed in 32 bits
+			a = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(vm1, vm1), 16), _mm_srai_epi32(_mm_unpacklo_epi16(vp1, vp1), 16));
+			b = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(vm3, vm3), 16), _mm_srai_epi32(_mm_unpacklo_epi16(vp3, vp3), 16));
+			t_lo = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_add_epi32(_mm_slli_epi32(a, 3), a), b), round), 5);
+			a = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(vm1, vm1), 16), _mm_srai_epi32(_mm_unpackhi_epi16(vp1, vp1), 16));
+			b = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(vm3, vm3), 16), _mm_srai_epi32(_mm_unpackhi_epi16(vp3, vp3), 16));
+			t_hi = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_add_epi32(_mm_slli_epi32(a, 3), a), b), round), 5);
+
+			// Low 16 bits are packed without saturation, same as scalar code
+			t_lo = _mm_srai_epi32(_mm_slli_epi32(t_lo, 16), 16);
+			t_hi = _mm_srai_epi32(_mm_slli_epi32(t_hi, 16), 16);
+			vq = _mm_sub_epi16(vq, _mm_packs_epi32(t_lo, t_hi));
+
+			_mm_storeu_si128((__m128i *)(q+i), vq);
+		}
+	}
+#endif
+
+	for(; i < n; i++) {
+		int a, b;
+
+		a = (int)m1[i*scale]+(int)p1[i*scale];
+		b = (int)m3[i*scale]+(int)p3[i*scale];
+		q[i*scale] = (int16_t)(q[i*scale]-((a*9-b+16)>>5));
+	}
+}
+
+// q[i] += (9*(m1[i]+p1[i])-(m3[i]+p3[i])+8)>>4 for every scale'th of n elements
+static void IW44PredictRow(int16_t *q, const int16_t *m1, const int16_t *p1, const int16_t *m3, const int16_t *p3, size_t n, size_t scale)
+{
+	size_t i = 0;
+
+#ifdef DJVUPURE_IW44_SSE2
+	if(scale == 1) {
+		const __m128i round = _mm_set1_epi32(8);
+
+		for(; i+8 <= n; i += 8) {
+			__m128i vq, vm1, vp1, vm3, vp3, a, b, t_lo, t_hi;
+
+			vq = _mm_loadu_si128((const __m128i *)(q+i));
+			vm1 = _mm_loadu_si128((const __m128i *)(m1+i));
+			vp1 = _mm_loadu_si128((const __m128i *)(p1+i));
+			vm3 = _mm_loadu_si128((const __m128i *)(m3+i));
+			vp3 = _mm_loadu_si128((const __m128i *)(p3+i));
+
+			a = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(vm1, vm1), 16), _mm_srai_epi32(_mm_unpacklo_epi16(vp1, vp1), 16));
+			b = _mm_add_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(vm3, vm3), 16), _mm_srai_epi32(_mm_unpacklo_epi16(vp3, vp3), 16));
+			t_lo = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_add_epi32(_mm_slli_epi32(a, 3), a), b), round), 4);
+			a = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(vm1, vm1), 16), _mm_srai_epi32(_mm_unpackhi_epi16(vp1, vp1), 16));
+			b = _mm_add_epi32(_mm_srai_epi32(_mm_unpackhi_epi16(vm3, vm3), 16), _mm_srai_epi32(_mm_unpackhi_epi16(vp3, vp3), 16));
+			t_hi = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_add_epi32(_mm_slli_epi32(a, 3), a), b), round), 4);
+
+			t_lo = _mm_srai_epi32(_mm_slli_epi32(t_lo, 16), 16);
+			t_hi = _mm_srai_epi32(_mm_slli_epi32(t_hi, 16), 16);
+			vq = _mm_add_epi16(vq, _mm_packs_epi32(t_lo, t_hi));
+
+			_mm_storeu_si128((__m128i *)(q+i), vq);
+		}
+	}
+#endif
+
+	for(; i < n; i++) {
+		int a, b;
+
+		a = (int)m1[i*scale]+(int)p1[i*scale];
+		b = (int)m3[i*scale]+(int)p3[i*scale];
+		q[i*scale] = (int16_t)(q[i*scale]+((a*9-b+8)>>4));
+	}
+}
+
+// Inverse vertical lifting for rows and columns which are multiple of scale
+static void IW44FilterV(int16_t *p, size_t width, size_t height, size_t rowsize, size_t scale)
+{
+	size_t s, s3, n;
+	ptrdiff_t y;
+	ptrdiff_t h;
+
+	s = scale*rowsize;
+	s3 = s*3;
+	h = (ptrdiff_t)((height-1)/scale+1);
+	n = (width-1)/scale+1;
+
+	for(y = 0; y-3 < h; y += 2) {
+		// Even rows are lifted with odd rows
+		if(y < h) {
+			int16_t *row;
+
+			row = p+(size_t)y*s;
+			if(y >= 3 && y+3 < h)
+				IW44LiftRow(row, row-s, row+s, row-s3, row+s3, n, scale);
+			else {
+				for(size_t i = 0; i < n; i++) {
+					int16_t *q;
+					int a, b;
+
+					q = row+i*scale;
+					a = (y >= 1)?q[-(ptrdiff_t)s]:0;
+					if(y+1 < h) a += q[s];
+					b = (y >= 3)?q[-(ptrdiff_t)s3]:0;
+					if(y+3 < h) b += q[s3];
+
+					*q = (int16_t)(*q-((a*9-b+16)>>5));
+				}
+			}
+		}
+
+		// Odd row y-3 is predicted from even rows
+		if(y >= 3) {
+			int16_t *row;
+
+			row = p+(size_t)(y-3)*s;
+			if(y >= 6 && y < h)
+				IW44PredictRow(row, row-s, row+s, row-s3, row+s3, n, scale);
+			else {
+				for(size_t i = 0; i < n; i++) {
+					int16_t *q;
+					int a;
+
+					q = row+i*scale;
+					a = q[-(ptrdiff_t)s]+((y-2 < h)?q[s]:q[-(ptrdiff_t)s]);
+
+					*q = (int16_t)(*q+((a+1)>>1));
+				}
+			}
+		}
+	}
+}
+
+// Inverse horizontal lifting for rows and columns which are multiple of scale
+static void IW44FilterH(int16_t *p, size_t width, size_t height, size_t rowsize, size_t scale)
+{
+	ptrdiff_t s, s3, w;
+
+	s = (ptrdiff_t)scale;
+	s3 = s*3;
+	w = (ptrdiff_t)width;
+
+	for(size_t y = 0; y < height; y += scale, p += rowsize*scale) {
+		int a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+		int b0 = 0, b1 = 0, b2 = 0, b3 = 0;
+		ptrdiff_t x = 0;
+
+		// Even samples are lifted with odd samples, odd sample x-3 is predicted after even sample x
+		if(x < w) {
+			if(x+s < w) a2 = p[x+s];
+			if(x+s3 < w) a3 = p[x+s3];
+			b2 = b3 = p[x]-(((a1+a2)*9-a0-a3+16)>>5);
+			p[x] = (int16_t)b3;
+			x += s*2;
+		}
+		if(x < w) {
+			a0 = a1;
+			a1 = a2;
+			a2 = a3;
+			a3 = (x+s3 < w)?p[x+s3]:0;
+			b3 = p[x]-(((a1+a2)*9-a0-a3+16)>>5);
+			p[x] = (int16_t)b3;
+			x += s*2;
+		}
+		if(x < w) {
+			b1 = b2;
+			b2 = b3;
+			a0 = a1;
+			a1 = a2;
+			a2 = a3;
+			a3 = (x+s3 < w)?p[x+s3]:0;
+			b3 = p[x]-(((a1+a2)*9-a0-a3+16)>>5);
+			p[x] = (int16_t)b3;
+			p[x-s3] = (int16_t)(p[x-s3]+((b1+b2+1)>>1));
+			x += s*2;
+		}
+		for(; x < w; x += s*2) {
+			a0 = a1;
+			a1 = a2;
+			a2 = a3;
+			a3 = (x+s3 < w)?p[x+s3]:0;
+			b0 = b1;
+			b1 = b2;
+			b2 = b3;
+			b3 = p[x]-(((a1+a2)*9-a0-a3+16)>>5);
+			p[x] = (int16_t)b3;
+			p[x-s3] = (int16_t)(p[x-s3]+(((b1+b2)*9-b0-b3+8)>>4));
+		}
+		for(; x-s3 < w; x += s*2) {
+			b1 = b2;
+			b2 = b3;
+			if(x-s3 >= 0) p[x-s3] = (int16_t)(p[x-s3]+((b1+b2+1)>>1));
+		}
+	}
+}
+
+// Inverse wavelet transform down to scale end, samples which are multiple of end hold image reduced by end
+static void IW44Backward(int16_t *p, size_t width, size_t height, size_t rowsize, size_t end)
+{
+	for(size_t scale = IW44_MAX_SCALE; scale >= end; scale >>= 1) {
+		IW44FilterV(p, width, height, rowsize, scale);
+		IW44FilterH(p, width, height, rowsize, scale);
+	}
+}
+
+// Coefficient n of block is placed by interleaving its bits into column and row
+static uint16_t IW44ZigzagLoc(size_t n)
+{
+	size_t row = 0, col = 0;
+
+	for(int bit = 0; bit < 5; bit++) {
+		col |= ((n>>(bit*2))&1)<<(4-bit);
+		row |= ((n>>(bit*2+1))&1)<<(4-bit);
+	}
+
+	return (uint16_t)(row*IW44_BLOCK_SIZE+col);
+}
+
+// Reconstructs map reduced by scale into signed bytes with pixsep step, plane_scale is scale of last decoded level
+static void IW44MapReconstruct(djvupure_iw44_map_t *map, int16_t *data16, size_t scale, size_t plane_scale, uint8_t *buf, size_t pixsep)
+{
+	uint16_t zigzag[IW44_BLOCK_LEN];
+	size_t i, j, blocks_in_row, reduced_width, reduced_height;
+	const int16_t *block;
+
+	for(i = 0; i < IW44_BLOCK_LEN; i++)
+		zigzag[i] = IW44ZigzagLoc(i);
+
+	block = map->coeffs;
+	blocks_in_row = map->block_width/IW44_BLOCK_SIZE;
+	for(i = 0; i < map->nof_blocks; i++, block += IW44_BLOCK_LEN) {
+		int16_t *p;
+
+		p = data16+(i/blocks_in_row)*IW44_BLOCK_SIZE*map->block_width+(i%blocks_in_row)*IW44_BLOCK_SIZE;
+		for(j = 0; j < IW44_BLOCK_LEN; j++)
+			p[(zigzag[j]/IW44_BLOCK_SIZE)*map->block_width+zigzag[j]%IW44_BLOCK_SIZE] = block[j];
+	}
+
+	IW44Backward(data16, map->width, map->height, map->block_width, plane_scale);
+
+	reduced_width = (map->width+scale-1)/scale;
+	reduced_height = (map->height+scale-1)/scale;
+	for(i = 0; i < reduced_height; i++) {
+		const int16_t *row;
+
+		row = data16+((i*scale)&~(plane_scale-1))*map->block_width;
+		for(j = 0; j < reduced_width; j++) {
+			int v;
+
+			v = (row[(j*scale)&~(plane_scale-1)]+(1<<(IW44_SHIFT-1)))>>IW44_SHIFT;
+			if(v < -128) v = -128;
+			else if(v > 127) v = 127;
+
+			buf[(i*reduced_width+j)*pixsep] = (uint8_t)(int8_t)v;
+		}
+	}
+}
+
+static void IW44YCbCrToRGB(uint8_t *buf, size_t nof_pixels)
+{
+	for(size_t i = 0; i < nof_pixels; i++, buf += 3) {
+		int y, b, r, t1, t2, t3, tr, tg, tb;
+
+		y = (int8_t)buf[0];
+		b = (int8_t)buf[1];
+		r = (int8_t)buf[2];
+
+		t1 = b>>2;
+		t2 = r+(r>>1);
+		t3 = y+128-t1;
+		tr = y+128+t2;
+		tg = t3-(t2>>1);
+		tb = t3+b*2;
+
+		buf[0] = (uint8_t)((tr < 0)?0:((tr > 255)?255:tr));
+		buf[1] = (uint8_t)((tg < 0)?0:((tg > 255)?255:tg));
+		buf[2] = (uint8_t)((tb < 0)?0:((tb > 255)?255:tb));
+	}
+}
+
+static void IW44GrayToRGB(uint8_t *buf, size_t nof_pixels)
+{
+	for(size_t i = 0; i < nof_pixels; i++, buf += 3)
+		buf[0] = buf[1] = buf[2] = (uint8_t)(127-(int8_t)buf[0]);
+}
+
+bool DJVUPURE_APIENTRY IW44DecodeImage(djvupure_allocator_t *allocator, djvupure_chunk_t *page, const uint8_t sign[4], uint16_t width, uint16_t height, uint8_t **image, uint16_t *image_width, uint16_t *image_height)
+{
+	djvupure_iw44_t iw44;
+	int16_t *data16 = 0;
+	uint8_t *img_buf = 0;
+	size_t nof_chunks, scale, reduced_width, reduced_height;
+	bool result = false;
+
+	if(!width || !height) return false;
+
+	memset(&iw44, 0, sizeof(djvupure_iw44_t));
+
+	nof_chunks = djvupureContainerCountSubchunksBySign(page, sign, 0);
+	if(!nof_chunks) return false;
+
+	for(size_t i = 0; i < nof_chunks; i++) {
+		djvupure_chunk_t *chunk;
+		void *chunk_data = 0;
+		size_t chunk_data_len = 0;
+
+		chunk = djvupureContainerGetSubchunkBySign(page, sign, 0, i);
+		if(!chunk) goto FINAL;
+
+		djvupureRawChunkGetDataPointer(chunk, &chunk_data, &chunk_data_len);
+		if(!chunk_data || !chunk_data_len) goto FINAL;
+
+		// Later chunks only refine image, so broken one ends decoding
+		if(!IW44DecodeChunk(allocator, &iw44, (const uint8_t *)chunk_data, chunk_data_len)) {
+			if(i == 0) goto FINAL;
+			break;
+		}
+	}
+
+	// Image is reduced by skipping last levels of wavelet transform
+	scale = 1;
+	while(scale < IW44_MAX_SCALE && (iw44.y.width+scale*2-1)/(scale*2) >= width && (iw44.y.height+scale*2-1)/(scale*2) >= height)
+		scale *= 2;
+	reduced_width = (iw44.y.width+scale-1)/scale;
+	reduced_height = (iw44.y.height+scale-1)/scale;
+
+	if(SIZE_MAX/sizeof(int16_t)/iw44.y.block_width < iw44.y.block_height) goto FINAL;
+	data16 = AllocatorAlloc(allocator, iw44.y.block_width*iw44.y.block_height*sizeof(int16_t));
+	if(!data16) goto FINAL;
+
+	if((SIZE_MAX/3)/reduced_width < reduced_height) goto FINAL;
+	img_buf = AllocatorAlloc(allocator, reduced_width*reduced_height*3);
+	if(!img_buf) goto FINAL;
+
+	IW44MapReconstruct(&(iw44.y), data16, scale, scale, img_buf, 3);
+	if(iw44.is_color) {
+		size_t crcb_scale;
+
+		// Chroma without last level is reconstructed at half resolution
+		crcb_scale = (iw44.is_crcb_half && scale < 2)?2:scale;
+		IW44MapReconstruct(&(iw44.cb), data16, scale, crcb_scale, img_buf+1, 3);
+		IW44MapReconstruct(&(iw44.cr), data16, scale, crcb_scale, img_buf+2, 3);
+		IW44YCbCrToRGB(img_buf, reduced_width*reduced_height);
+	} else
+		IW44GrayToRGB(img_buf, reduced_width*reduced_height);
+
+	*image = img_buf;
+	*image_width = (uint16_t)reduced_width;
+	*image_height = (uint16_t)reduced_height;
+	img_buf = 0;
+
+	result = true;
+
+FINAL:
+	if(img_buf) AllocatorFree(allocator, img_buf);
+	if(data16) AllocatorFree(allocator, data16);
+	IW44MapFree(allocator, &(iw44.y));
+	IW44MapFree(allocator, &(iw44.cb));
+	IW44MapFree(allocator, &(iw44.cr));
+
+	return result;
+}
+
+bool DJVUPURE_APIENTRY IW44DecodeRegion(djvupure_allocator_t *allocator, djvupure_chunk_t *page, const uint8_t sign[4], uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, void *buf)
+{
+	uint8_t *image;
+	uint16_t image_width, image_height;
+	bool result;
+
+	if(!width || !height || !region_width || !region_height) return false;
+	if(x > width-region_width || y > height-region_height) return false;
+
+	if(!IW44DecodeImage(allocator, page, sign, width, height, &image, &image_width, &image_height)) return false;
+
+	result = ImageResizeRegionEx(allocator, image_width, image_height, image, width, height, x, y, region_width, region_height, buf, 3);
+
+	AllocatorFree(allocator, image);
+
+	return result;
+}
\ No newline at end of file
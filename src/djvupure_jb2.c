@@ -0,0 +1,1101 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "../include/djvupure.h"
+#include "djvupure_sign.h"
+#include "djvupure_allocator.h"
+#include "djvupure_image.h"
+#include "djvupure_jb2.h"
+#include "djvupure_zp.h"
+
+#include <string.h>
+
+enum {
+	JB2_START_OF_DATA = 0,
+	JB2_NEW_MARK = 1,
+	JB2_NEW_MARK_LIBRARY_ONLY = 2,
+	JB2_NEW_MARK_IMAGE_ONLY = 3,
+	JB2_MATCHED_REFINE = 4,
+	JB2_MATCHED_REFINE_LIBRARY_ONLY = 5,
+	JB2_MATCHED_REFINE_IMAGE_ONLY = 6,
+	JB2_MATCHED_COPY = 7,
+	JB2_NON_MARK_DATA = 8,
+	JB2_REQUIRED_DICT_OR_RESET = 9,
+	JB2_PRESERVED_COMMENT = 10,
+	JB2_END_OF_DATA = 11
+};
+
+enum {
+	JB2_BIGPOSITIVE = 262142,
+	JB2_BIGNEGATIVE = -262143,
+	JB2_MAX_CELLS = 1<<24, // Encoder resets numerical coder much earlier
+	JB2_MAX_DICT_DEPTH = 8,
+	JB2_BORDER = 3 // Coding contexts look up to 3 pixels to the right
+};
+
+typedef struct {
+	uint8_t *bits; // Packed rows from top to bottom, msb is left pixel, 1 is black
+	size_t stride;
+	uint16_t width;
+	uint16_t height;
+	// Bounding box of black pixels, rows are counted from bottom like in JB2 coordinates
+	int32_t left;
+	int32_t right;
+	int32_t bottom;
+	int32_t top;
+} djvupure_jb2_shape_t;
+
+struct djvupure_jb2_dict_t {
+	djvupure_jb2_shape_t *shapes;
+	size_t nof_shapes;
+	size_t nof_inherited; // First shapes are borrowed from inherited dictionary
+};
+
+typedef struct {
+	djvupure_zp_t zp;
+	djvupure_allocator_t *allocator;
+	djvupure_arena_t *arena; // Library shapes are allocated from arena
+	bool is_dict;
+	bool is_started;
+	// Numerical coder, contexts are indexes of cells
+	uint8_t *bit_cells;
+	uint32_t *left_cells;
+	uint32_t *right_cells;
+	uint32_t nof_cells;
+	uint32_t nof_alloc_cells;
+	uint32_t dist_comment_byte;
+	uint32_t dist_comment_length;
+	uint32_t dist_record_type;
+	uint32_t dist_match_index;
+	uint32_t abs_loc_x;
+	uint32_t abs_loc_y;
+	uint32_t abs_size_x;
+	uint32_t abs_size_y;
+	uint32_t image_size_dist;
+	uint32_t inherited_shape_count_dist;
+	uint32_t rel_loc_x_current;
+	uint32_t rel_loc_x_last;
+	uint32_t rel_loc_y_current;
+	uint32_t rel_loc_y_last;
+	uint32_t rel_size_x;
+	uint32_t rel_size_y;
+	djvupure_zp_context_t dist_refinement_flag;
+	djvupure_zp_context_t offset_type_dist;
+	djvupure_zp_context_t bit_dist[1024];
+	djvupure_zp_context_t cbit_dist[2048];
+	// Location prediction
+	int32_t last_left;
+	int32_t last_right;
+	int32_t last_bottom;
+	int32_t last_row_left;
+	int32_t last_row_bottom;
+	int32_t short_list[3];
+	int short_list_pos;
+	int32_t image_width;
+	int32_t image_height;
+	// Shapes which can be matched later
+	djvupure_jb2_dict_t *dict;
+	djvupure_jb2_shape_t *library;
+	size_t nof_library;
+	size_t nof_alloc_library;
+	size_t nof_inherited;
+	// Bitmap coding buffers, grow only
+	uint8_t *scratch;
+	size_t scratch_size;
+	uint8_t *ref_scratch;
+	size_t ref_scratch_size;
+	uint8_t *pack_scratch;
+	size_t pack_scratch_size;
+	// Requested part of mask, only for images
+	uint16_t width;
+	uint16_t height;
+	djvupure_rect_t rect;
+	uint8_t *target;
+	size_t target_stride;
+	int32_t target_x;
+	int32_t target_y;
+	int32_t target_width;
+	int32_t target_height;
+} djvupure_jb2_decoder_t;
+
+static void JB2DecoderInit(djvupure_jb2_decoder_t *dec, djvupure_allocator_t *allocator, djvupure_arena_t *arena, const void *data, size_t data_len, bool is_dict)
+{
+	memset(dec, 0, sizeof(djvupure_jb2_decoder_t));
+
+	dec->allocator = allocator;
+	dec->arena = arena;
+	dec->is_dict = is_dict;
+	dec->nof_cells = 1; // Cell 0 means context isn't allocated yet
+
+	ZPInit(&(dec->zp), data, data_len);
+}
+
+static void JB2DecoderFree(djvupure_jb2_decoder_t *dec)
+{
+	AllocatorFree(dec->allocator, dec->bit_cells);
+	AllocatorFree(dec->allocator, dec->left_cells);
+	AllocatorFree(dec->allocator, dec->right_cells);
+	AllocatorFree(dec->allocator, dec->scratch);
+	AllocatorFree(dec->allocator, dec->ref_scratch);
+	AllocatorFree(dec->allocator, dec->pack_scratch);
+	AllocatorFree(dec->allocator, dec->target);
+}
+
+static void JB2ResetNumCoder(djvupure_jb2_decoder_t *dec)
+{
+	dec->dist_comment_byte = dec->dist_comment_length = 0;
+	dec->dist_record_type = dec->dist_match_index = 0;
+	dec->abs_loc_x = dec->abs_loc_y = 0;
+	dec->abs_size_x = dec->abs_size_y = 0;
+	dec->image_size_dist = dec->inherited_shape_count_dist = 0;
+	dec->rel_loc_x_current = dec->rel_loc_x_last = 0;
+	dec->rel_loc_y_current = dec->rel_loc_y_last = 0;
+	dec->rel_size_x = dec->rel_size_y = 0;
+	dec->nof_cells = 1;
+}
+
+// Arrays of cells may be moved, so pointers into them aren't valid after call
+static bool JB2AllocCell(djvupure_jb2_decoder_t *dec, uint32_t *cell)
+{
+	if(dec->nof_cells >= dec->nof_alloc_cells) {
+		uint8_t *bit_cells;
+		uint32_t *left_cells, *right_cells;
+		uint32_t nof_alloc_cells;
+
+		if(dec->nof_alloc_cells >= JB2_MAX_CELLS) return false;
+
+		nof_alloc_cells = dec->nof_alloc_cells?dec->nof_alloc_cells*2:4096;
+
+		bit_cells = AllocatorRealloc(dec->allocator, dec->bit_cells, nof_alloc_cells);
+		if(!bit_cells) return false;
+		dec->bit_cells = bit_cells;
+
+		left_cells = AllocatorRealloc(dec->allocator, dec->left_cells, nof_alloc_cells*sizeof(uint32_t));
+		if(!left_cells) return false;
+		dec->left_cells = left_cells;
+
+		right_cells = AllocatorRealloc(dec->allocator, dec->right_cells, nof_alloc_cells*sizeof(uint32_t));
+		if(!right_cells) return false;
+		dec->right_cells = right_cells;
+
+		dec->nof_alloc_cells = nof_alloc_cells;
+	}
+
+	*cell = dec->nof_cells++;
+	dec->bit_cells[*cell] = 0;
+	dec->left_cells[*cell] = dec->right_cells[*cell] = 0;
+
+	return true;
+}
+
+// Decodes number from low to high, contexts form binary tree which is built while decoding
+static bool JB2DecodeNum(djvupure_jb2_decoder_t *dec, int32_t low, int32_t high, uint32_t *ctx, int32_t *value)
+{
+	int32_t cutoff = 0, range = -1;
+	uint32_t parent = 0; // 0 means ctx is root of tree
+	int phase = 1;
+	bool negative = false, is_right = false;
+
+	while(range != 1) {
+		uint32_t cell;
+		bool decision;
+
+		if(parent)
+			cell = is_right?dec->right_cells[parent]:dec->left_cells[parent];
+		else
+			cell = *ctx;
+
+		// Child is linked after cell is allocated
+		if(!cell) {
+			if(!JB2AllocCell(dec, &cell)) return false;
+
+			if(!parent)
+				*ctx = cell;
+			else if(is_right)
+				dec->right_cells[parent] = cell;
+			else
+				dec->left_cells[parent] = cell;
+		}
+
+		decision = (low >= cutoff) || ((high >= cutoff) && ZPDecode(&(dec->zp), dec->bit_cells+cell));
+
+		parent = cell;
+		is_right = decision;
+
+		switch(phase) {
+			case 1: // Sign
+				negative = !decision;
+				if(negative) {
+					int32_t temp;
+
+					temp = -low-1;
+					low = -high-1;
+					high = temp;
+				}
+				phase = 2;
+				cutoff = 1;
+				break;
+			case 2: // Number of bits
+				if(!decision) {
+					phase = 3;
+					range = (cutoff+1)/2;
+					if(range == 1)
+						cutoff = 0;
+					else
+						cutoff -= range/2;
+				} else
+					cutoff += cutoff+1;
+				break;
+			case 3: // Bits
+				range /= 2;
+				if(range != 1) {
+					if(!decision)
+						cutoff -= range/2;
+					else
+						cutoff += range/2;
+				} else if(!decision)
+					cutoff--;
+				break;
+		}
+
+		if(dec->zp.is_overrun) return false;
+	}
+
+	*value = negative?(-cutoff-1):cutoff;
+
+	return true;
+}
+
+static void JB2FillShortList(djvupure_jb2_decoder_t *dec, int32_t v)
+{
+	dec->short_list[0] = dec->short_list[1] = dec->short_list[2] = v;
+	dec->short_list_pos = 0;
+}
+
+// Returns median of last three values
+static int32_t JB2UpdateShortList(djvupure_jb2_decoder_t *dec, int32_t v)
+{
+	int32_t *s;
+
+	if(++(dec->short_list_pos) == 3) dec->short_list_pos = 0;
+	s = dec->short_list;
+	s[dec->short_list_pos] = v;
+
+	if(s[0] >= s[1])
+		return (s[0] > s[2])?((s[1] >= s[2])?s[1]:s[2]):s[0];
+	else
+		return (s[0] < s[2])?((s[1] >= s[2])?s[2]:s[1]):s[0];
+}
+
+// Scratch has JB2_BORDER zero pixels around each row and two zero rows above bitmap
+static bool JB2PrepareScratch(djvupure_allocator_t *allocator, uint8_t **scratch, size_t *scratch_size, uint16_t width, uint16_t height, size_t *stride)
+{
+	size_t size;
+
+	*stride = (size_t)width+2*JB2_BORDER;
+	if(SIZE_MAX / *stride <= (size_t)height+3) return false;
+	size = *stride*((size_t)height+3);
+
+	if(size > *scratch_size) {
+		uint8_t *_scratch;
+
+		_scratch = AllocatorRealloc(allocator, *scratch, size);
+		if(!_scratch) return false;
+
+		*scratch = _scratch;
+		*scratch_size = size;
+	}
+
+	memset(*scratch, 0, size);
+
+	return true;
+}
+
+static uint8_t *JB2ScratchRow(uint8_t *scratch, size_t stride, int32_t row)
+{
+	return scratch+(size_t)(row+2)*stride+JB2_BORDER;
+}
+
+static bool JB2DecodeBitmapDirectly(djvupure_jb2_decoder_t *dec, uint16_t width, uint16_t height, size_t *stride)
+{
+	if(!JB2PrepareScratch(dec->allocator, &(dec->scratch), &(dec->scratch_size), width, height, stride)) return false;
+
+	for(int32_t row = 0; row < height; row++) {
+		uint8_t *up2, *up1, *up0;
+		int context;
+
+		up2 = JB2ScratchRow(dec->scratch, *stride, row-2);
+		up1 = JB2ScratchRow(dec->scratch, *stride, row-1);
+		up0 = JB2ScratchRow(dec->scratch, *stride, row);
+
+		context = (up2[-1]<<9)|(up2[0]<<8)|(up2[1]<<7)|(up1[-2]<<6)|(up1[-1]<<5)|(up1[0]<<4)|(up1[1]<<3)|(up1[2]<<2)|(up0[-2]<<1)|up0[-1];
+
+		for(int32_t col = 0; col < width;) {
+			int n;
+
+			n = ZPDecode(&(dec->zp), dec->bit_dist+context);
+			up0[col++] = (uint8_t)n;
+
+			context = ((context<<1)&0x37a)|(up1[col+2]<<2)|(up2[col+1]<<7)|n;
+		}
+
+		if(dec->zp.is_overrun) return false;
+	}
+
+	return true;
+}
+
+// Refines bitmap using matched shape, which is aligned by centers of bounding boxes
+static bool JB2DecodeBitmapByCrossCoding(djvupure_jb2_decoder_t *dec, uint16_t width, uint16_t height, const djvupure_jb2_shape_t *match, size_t *stride)
+{
+	int32_t xd2c, yd2c, match_row_shift;
+	size_t ref_stride;
+
+	if(!JB2PrepareScratch(dec->allocator, &(dec->scratch), &(dec->scratch_size), width, height, stride)) return false;
+	if(!JB2PrepareScratch(dec->allocator, &(dec->ref_scratch), &(dec->ref_scratch_size), width, height, &ref_stride)) return false;
+
+	xd2c = (width/2-width+1)-((match->right-match->left+1)/2-match->right);
+	yd2c = (height/2-height+1)-((match->top-match->bottom+1)/2-match->top);
+
+	// Reference row r is row r+match_row_shift of matched shape, rows from -1 to height are needed
+	match_row_shift = (int32_t)match->height-(int32_t)height-yd2c;
+	for(int32_t row = -1; row <= height; row++) {
+		int32_t match_row;
+		uint8_t *p;
+
+		match_row = row+match_row_shift;
+		if(match_row < 0 || match_row >= match->height) continue;
+
+		p = JB2ScratchRow(dec->ref_scratch, ref_stride, row);
+
+		for(int32_t col = -JB2_BORDER; col < width+JB2_BORDER; col++) {
+			int32_t match_col;
+
+			match_col = col+xd2c;
+			if(match_col < 0 || match_col >= match->width) continue;
+
+			p[col] = (match->bits[(size_t)match_row*match->stride+(match_col>>3)]>>(7-(match_col&7)))&1;
+		}
+	}
+
+	for(int32_t row = 0; row < height; row++) {
+		uint8_t *up1, *up0, *xup1, *xup0, *xdn1;
+		int context;
+
+		up1 = JB2ScratchRow(dec->scratch, *stride, row-1);
+		up0 = JB2ScratchRow(dec->scratch, *stride, row);
+		xup1 = JB2ScratchRow(dec->ref_scratch, ref_stride, row-1);
+		xup0 = JB2ScratchRow(dec->ref_scratch, ref_stride, row);
+		xdn1 = JB2ScratchRow(dec->ref_scratch, ref_stride, row+1);
+
+		context = (up1[-1]<<10)|(up1[0]<<9)|(up1[1]<<8)|(up0[-1]<<7)|(xup1[0]<<6)|(xup0[-1]<<5)|(xup0[0]<<4)|(xup0[1]<<3)|(xdn1[-1]<<2)|(xdn1[0]<<1)|xdn1[1];
+
+		for(int32_t col = 0; col < width;) {
+			int n;
+
+			n = ZPDecode(&(dec->zp), dec->cbit_dist+context);
+			up0[col++] = (uint8_t)n;
+
+			context = ((context<<1)&0x636)|(up1[col+1]<<8)|(xup1[col]<<6)|(xup0[col+1]<<3)|xdn1[col+1]|(n<<7);
+		}
+
+		if(dec->zp.is_overrun) return false;
+	}
+
+	return true;
+}
+
+// Packs decoded scratch into shape and finds its bounding box. Library shapes are kept in arena, others are reused
+static bool JB2PackShape(djvupure_jb2_decoder_t *dec, uint16_t width, uint16_t height, size_t scratch_stride, bool is_library, djvupure_jb2_shape_t *shape)
+{
+	int32_t first_row = -1, last_row = -1, first_col = width, last_col = -1;
+	size_t size;
+
+	shape->width = width;
+	shape->height = height;
+	shape->stride = ((size_t)width+7)/8;
+	shape->bits = 0;
+
+	size = shape->stride*height;
+	if(size) {
+		if(is_library)
+			shape->bits = ArenaAlloc(dec->arena, size);
+		else {
+			if(size > dec->pack_scratch_size) {
+				uint8_t *pack_scratch;
+
+				pack_scratch = AllocatorRealloc(dec->allocator, dec->pack_scratch, size);
+				if(!pack_scratch) return false;
+
+				dec->pack_scratch = pack_scratch;
+				dec->pack_scratch_size = size;
+			}
+			shape->bits = dec->pack_scratch;
+		}
+		if(!shape->bits) return false;
+
+		memset(shape->bits, 0, size);
+	}
+
+	for(int32_t row = 0; row < height; row++) {
+		const uint8_t *p;
+		uint8_t *q;
+		bool is_empty = true;
+
+		p = JB2ScratchRow(dec->scratch, scratch_stride, row);
+		q = shape->bits+(size_t)row*shape->stride;
+
+		for(int32_t col = 0; col < width; col++)
+			if(p[col]) {
+				q[col>>3] |= 0x80>>(col&7);
+				if(col < first_col) first_col = col;
+				if(col > last_col) last_col = col;
+				is_empty = false;
+			}
+
+		if(!is_empty) {
+			if(first_row < 0) first_row = row;
+			last_row = row;
+		}
+	}
+
+	// Same values as for empty bitmap in reference decoder
+	if(last_col < 0) {
+		shape->left = shape->bottom = 0;
+		shape->right = shape->top = -1;
+	} else {
+		shape->left = first_col;
+		shape->right = last_col;
+		shape->bottom = height-1-last_row;
+		shape->top = height-1-first_row;
+	}
+
+	return true;
+}
+
+static bool JB2AddToLibrary(djvupure_jb2_decoder_t *dec, const djvupure_jb2_shape_t *shape)
+{
+	if(dec->nof_library >= dec->nof_alloc_library) {
+		djvupure_jb2_shape_t *library;
+		size_t nof_alloc_library;
+
+		nof_alloc_library = dec->nof_alloc_library?dec->nof_alloc_library*2:256;
+		if(SIZE_MAX/sizeof(djvupure_jb2_shape_t) < nof_alloc_library) return false;
+
+		library = ArenaRealloc(dec->arena, dec->library, dec->nof_alloc_library*sizeof(djvupure_jb2_shape_t), nof_alloc_library*sizeof(djvupure_jb2_shape_t));
+		if(!library) return false;
+
+		dec->library = library;
+		dec->nof_alloc_library = nof_alloc_library;
+	}
+
+	dec->library[dec->nof_library++] = *shape;
+
+	return true;
+}
+
+// Draws shape to requested part of mask, left and bottom are JB2 coordinates of lower left corner
+static void JB2Blit(djvupure_jb2_decoder_t *dec, const djvupure_jb2_shape_t *shape, int32_t left, int32_t bottom)
+{
+	int32_t top, x, first_row, end_row;
+
+	if(!dec->target || !shape->bits) return;
+
+	top = dec->image_height-bottom-shape->height-dec->target_y;
+	x = left-dec->target_x;
+
+	if(x >= dec->target_width || x+shape->width <= 0) return;
+
+	first_row = (top < 0)?-top:0;
+	end_row = shape->height;
+	if(top+end_row > dec->target_height) end_row = dec->target_height-top;
+
+	for(int32_t row = first_row; row < end_row; row++) {
+		const uint8_t *src;
+		uint8_t *dst;
+
+		src = shape->bits+(size_t)row*shape->stride;
+		dst = dec->target+(size_t)(top+row)*dec->target_stride;
+
+		// Bits right to target width are written to padding and never read
+		for(size_t i = 0; i < shape->stride; i++) {
+			int32_t col;
+			uint8_t b;
+
+			b = src[i];
+			if(!b) continue;
+
+			col = x+(int32_t)i*8;
+			if(col >= dec->target_width) break;
+			if(col <= -8) continue;
+
+			if(col < 0)
+				dst[0] |= (uint8_t)(b<<(-col));
+			else {
+				size_t index;
+				int shift;
+
+				index = col>>3;
+				shift = col&7;
+
+				dst[index] |= b>>shift;
+				if(shift && index+1 < dec->target_stride) dst[index+1] |= (uint8_t)(b<<(8-shift));
+			}
+		}
+	}
+}
+
+// Allocates packed part of full size mask which covers requested region
+static bool JB2PrepareTarget(djvupure_jb2_decoder_t *dec)
+{
+	uint32_t x_end, y_end;
+	size_t size;
+
+	if(dec->image_width < dec->width || dec->image_height < dec->height) return false;
+
+	dec->target_x = (int32_t)((uint32_t)dec->rect.x*dec->image_width/dec->width);
+	dec->target_y = (int32_t)((uint32_t)dec->rect.y*dec->image_height/dec->height);
+	x_end = ((uint32_t)dec->rect.x+dec->rect.width)*dec->image_width/dec->width;
+	y_end = ((uint32_t)dec->rect.y+dec->rect.height)*dec->image_height/dec->height;
+	dec->target_width = (int32_t)x_end-dec->target_x;
+	dec->target_height = (int32_t)y_end-dec->target_y;
+
+	// One more byte for shifted writes of last byte
+	dec->target_stride = ((size_t)dec->target_width+7)/8+1;
+	if(SIZE_MAX/dec->target_stride < (size_t)dec->target_height) return false;
+	size = dec->target_stride*dec->target_height;
+
+	dec->target = AllocatorAlloc(dec->allocator, size+1);
+	if(!dec->target) return false;
+
+	memset(dec->target, 0, size);
+
+	return true;
+}
+
+static bool JB2DecodeStart(djvupure_jb2_decoder_t *dec)
+{
+	int32_t width, height;
+	djvupure_zp_context_t refinement_flag;
+
+	if(dec->is_started) return false;
+
+	if(!JB2DecodeNum(dec, 0, JB2_BIGPOSITIVE, &(dec->image_size_dist), &width)) return false;
+	if(!JB2DecodeNum(dec, 0, JB2_BIGPOSITIVE, &(dec->image_size_dist), &height)) return false;
+
+	if(dec->is_dict) {
+		if(width || height) return false;
+	} else {
+		if(!width || !height || width > UINT16_MAX || height > UINT16_MAX) return false;
+	}
+
+	dec->image_width = width;
+	dec->image_height = height;
+	dec->last_left = dec->is_dict?1:1+width;
+	dec->last_row_left = 0;
+	dec->last_row_bottom = dec->is_dict?0:height;
+	dec->last_right = 0;
+	JB2FillShortList(dec, dec->last_row_bottom);
+	dec->is_started = true;
+
+	// Lossless refinement flag isn't needed for decoding
+	refinement_flag = ZPDecode(&(dec->zp), &(dec->dist_refinement_flag));
+	(void)refinement_flag;
+
+	if(!dec->is_dict && dec->width)
+		if(!JB2PrepareTarget(dec)) return false;
+
+	return true;
+}
+
+static bool JB2DecodeInheritedShapeCount(djvupure_jb2_decoder_t *dec)
+{
+	int32_t count;
+
+	if(!JB2DecodeNum(dec, 0, JB2_BIGPOSITIVE, &(dec->inherited_shape_count_dist), &count)) return false;
+
+	if(!count) return true;
+
+	if(!dec->dict || dec->dict->nof_shapes != (size_t)count || dec->nof_library) return false;
+
+	// Inherited shapes are borrowed, their bitmaps belong to dictionary
+	for(size_t i = 0; i < dec->dict->nof_shapes; i++)
+		if(!JB2AddToLibrary(dec, dec->dict->shapes+i)) return false;
+
+	dec->nof_inherited = dec->nof_library;
+
+	return true;
+}
+
+static bool JB2DecodeAbsoluteSize(djvupure_jb2_decoder_t *dec, uint16_t *width, uint16_t *height)
+{
+	int32_t xsize, ysize;
+
+	if(!JB2DecodeNum(dec, 0, JB2_BIGPOSITIVE, &(dec->abs_size_x), &xsize)) return false;
+	if(!JB2DecodeNum(dec, 0, JB2_BIGPOSITIVE, &(dec->abs_size_y), &ysize)) return false;
+
+	if(xsize > UINT16_MAX || ysize > UINT16_MAX) return false;
+
+	*width = (uint16_t)xsize;
+	*height = (uint16_t)ysize;
+
+	return true;
+}
+
+static bool JB2DecodeRelativeSize(djvupure_jb2_decoder_t *dec, const djvupure_jb2_shape_t *match, uint16_t *width, uint16_t *height)
+{
+	int32_t xdiff, ydiff, xsize, ysize;
+
+	if(!JB2DecodeNum(dec, JB2_BIGNEGATIVE, JB2_BIGPOSITIVE, &(dec->rel_size_x), &xdiff)) return false;
+	if(!JB2DecodeNum(dec, JB2_BIGNEGATIVE, JB2_BIGPOSITIVE, &(dec->rel_size_y), &ydiff)) return false;
+
+	xsize = match->right-match->left+1+xdiff;
+	ysize = match->top-match->bottom+1+ydiff;
+
+	if(xsize < 0 || ysize < 0 || xsize > UINT16_MAX || ysize > UINT16_MAX) return false;
+
+	*width = (uint16_t)xsize;
+	*height = (uint16_t)ysize;
+
+	return true;
+}
+
+// Location is predicted from previous shape on the same line or from first shape of previous line
+static bool JB2DecodeRelativeLocation(djvupure_jb2_decoder_t *dec, int32_t rows, int32_t columns, int32_t *left, int32_t *bottom)
+{
+	int32_t x_diff, y_diff, new_left, new_bottom, top, right;
+
+	if(!dec->is_started) return false;
+
+	if(ZPDecode(&(dec->zp), &(dec->offset_type_dist))) { // New line
+		if(!JB2DecodeNum(dec, JB2_BIGNEGATIVE, JB2_BIGPOSITIVE, &(dec->rel_loc_x_last), &x_diff)) return false;
+		if(!JB2DecodeNum(dec, JB2_BIGNEGATIVE, JB2_BIGPOSITIVE, &(dec->rel_loc_y_last), &y_diff)) return false;
+
+		new_left = dec->last_row_left+x_diff;
+		top = dec->last_row_bottom+y_diff;
+		right = new_left+columns-1;
+		new_bottom = top-rows+1;
+
+		dec->last_left = dec->last_row_left = new_left;
+		dec->last_right = right;
+		dec->last_bottom = dec->last_row_bottom = new_bottom;
+		JB2FillShortList(dec, new_bottom);
+	} else { // Same line
+		if(!JB2DecodeNum(dec, JB2_BIGNEGATIVE, JB2_BIGPOSITIVE, &(dec->rel_loc_x_current), &x_diff)) return false;
+		if(!JB2DecodeNum(dec, JB2_BIGNEGATIVE, JB2_BIGPOSITIVE, &(dec->rel_loc_y_current), &y_diff)) return false;
+
+		new_left = dec->last_right+x_diff;
+		new_bottom = dec->last_bottom+y_diff;
+		right = new_left+columns-1;
+
+		dec->last_left = new_left;
+		dec->last_right = right;
+		dec->last_bottom = JB2UpdateShortList(dec, new_bottom);
+	}
+
+	*left = new_left-1;
+	*bottom = new_bottom-1;
+
+	return true;
+}
+
+static bool JB2DecodeAbsoluteLocation(djvupure_jb2_decoder_t *dec, int32_t rows, int32_t *left, int32_t *bottom)
+{
+	int32_t x, y;
+
+	if(!dec->is_started) return false;
+
+	if(!JB2DecodeNum(dec, 1, dec->image_width, &(dec->abs_loc_x), &x)) return false;
+	if(!JB2DecodeNum(dec, 1, dec->image_height, &(dec->abs_loc_y), &y)) return false;
+
+	*left = x-1;
+	*bottom = y-rows;
+
+	return true;
+}
+
+static bool JB2DecodeMatchIndex(djvupure_jb2_decoder_t *dec, size_t *index)
+{
+	int32_t match;
+
+	if(!dec->nof_library || dec->nof_library-1 > INT32_MAX) return false;
+
+	if(!JB2DecodeNum(dec, 0, (int32_t)(dec->nof_library-1), &(dec->dist_match_index), &match)) return false;
+
+	*index = (size_t)match;
+
+	return true;
+}
+
+static bool JB2DecodeComment(djvupure_jb2_decoder_t *dec)
+{
+	int32_t length, byte;
+
+	if(!JB2DecodeNum(dec, 0, JB2_BIGPOSITIVE, &(dec->dist_comment_length), &length)) return false;
+
+	for(int32_t i = 0; i < length; i++)
+		if(!JB2DecodeNum(dec, 0, 255, &(dec->dist_comment_byte), &byte)) return false;
+
+	return true;
+}
+
+static bool JB2DecodeRecord(djvupure_jb2_decoder_t *dec, int32_t rectype)
+{
+	djvupure_jb2_shape_t shape;
+	uint16_t width, height;
+	size_t stride, index;
+	int32_t left, bottom;
+	bool is_library, is_image;
+
+	// Dictionaries have only library shapes
+	if(dec->is_dict)
+		switch(rectype) {
+			case JB2_NEW_MARK:
+			case JB2_NEW_MARK_IMAGE_ONLY:
+			case JB2_MATCHED_REFINE:
+			case JB2_MATCHED_REFINE_IMAGE_ONLY:
+			case JB2_MATCHED_COPY:
+			case JB2_NON_MARK_DATA:
+				return false;
+		}
+
+	if(!dec->is_started && rectype != JB2_START_OF_DATA && rectype != JB2_REQUIRED_DICT_OR_RESET && rectype != JB2_PRESERVED_COMMENT) return false;
+
+	is_library = rectype == JB2_NEW_MARK || rectype == JB2_NEW_MARK_LIBRARY_ONLY || rectype == JB2_MATCHED_REFINE || rectype == JB2_MATCHED_REFINE_LIBRARY_ONLY;
+	is_image = rectype != JB2_NEW_MARK_LIBRARY_ONLY && rectype != JB2_MATCHED_REFINE_LIBRARY_ONLY;
+
+	switch(rectype) {
+		case JB2_START_OF_DATA:
+			return JB2DecodeStart(dec);
+		case JB2_NEW_MARK:
+		case JB2_NEW_MARK_LIBRARY_ONLY:
+		case JB2_NEW_MARK_IMAGE_ONLY:
+		case JB2_NON_MARK_DATA:
+			if(!JB2DecodeAbsoluteSize(dec, &width, &height)) return false;
+			if(!JB2DecodeBitmapDirectly(dec, width, height, &stride)) return false;
+			if(!JB2PackShape(dec, width, height, stride, is_library, &shape)) return false;
+			break;
+		case JB2_MATCHED_REFINE:
+		case JB2_MATCHED_REFINE_LIBRARY_ONLY:
+		case JB2_MATCHED_REFINE_IMAGE_ONLY:
+			if(!JB2DecodeMatchIndex(dec, &index)) return false;
+			if(!JB2DecodeRelativeSize(dec, dec->library+index, &width, &height)) return false;
+			if(!JB2DecodeBitmapByCrossCoding(dec, width, height, dec->library+index, &stride)) return false;
+			if(!JB2PackShape(dec, width, height, stride, is_library, &shape)) return false;
+			break;
+		case JB2_MATCHED_COPY:
+			{
+				const djvupure_jb2_shape_t *match;
+
+				if(!JB2DecodeMatchIndex(dec, &index)) return false;
+
+				// Location is predicted for bounding box of matched shape
+				match = dec->library+index;
+				if(!JB2DecodeRelativeLocation(dec, match->top-match->bottom+1, match->right-match->left+1, &left, &bottom)) return false;
+
+				JB2Blit(dec, match, left-match->left, bottom-match->bottom);
+			}
+			return true;
+		case JB2_PRESERVED_COMMENT:
+			return JB2DecodeComment(dec);
+		case JB2_REQUIRED_DICT_OR_RESET:
+			if(!dec->is_started)
+				return JB2DecodeInheritedShapeCount(dec);
+
+			JB2ResetNumCoder(dec);
+			return true;
+		case JB2_END_OF_DATA:
+			return true;
+		default:
+			return false;
+	}
+
+	if(is_image) {
+		if(rectype == JB2_NON_MARK_DATA) {
+			if(!JB2DecodeAbsoluteLocation(dec, height, &left, &bottom)) return false;
+		} else {
+			if(!JB2DecodeRelativeLocation(dec, height, width, &left, &bottom)) return false;
+		}
+
+		JB2Blit(dec, &shape, left, bottom);
+	}
+
+	if(is_library)
+		if(!JB2AddToLibrary(dec, &shape)) return false;
+
+	return true;
+}
+
+static bool JB2Decode(djvupure_jb2_decoder_t *dec)
+{
+	while(1) {
+		int32_t rectype;
+
+		if(!JB2DecodeNum(dec, JB2_START_OF_DATA, JB2_END_OF_DATA, &(dec->dist_record_type), &rectype)) return false;
+
+		if(!JB2DecodeRecord(dec, rectype)) return false;
+
+		if(rectype == JB2_END_OF_DATA) break;
+	}
+
+	return dec->is_started;
+}
+
+bool DJVUPURE_APIENTRY JB2GetInfo(djvupure_chunk_t *sjbz, uint16_t *width, uint16_t *height)
+{
+	djvupure_jb2_decoder_t dec;
+	void *chunk_data = 0;
+	size_t chunk_data_len = 0;
+	bool result = false;
+
+	djvupureRawChunkGetDataPointer(sjbz, &chunk_data, &chunk_data_len);
+	if(!chunk_data || !chunk_data_len) return false;
+
+	JB2DecoderInit(&dec, 0, 0, chunk_data, chunk_data_len, false);
+
+	// Start record can follow dictionary request and comments
+	while(!dec.is_started) {
+		int32_t rectype, count;
+
+		if(!JB2DecodeNum(&dec, JB2_START_OF_DATA, JB2_END_OF_DATA, &(dec.dist_record_type), &rectype)) goto FINAL;
+
+		if(rectype == JB2_REQUIRED_DICT_OR_RESET) {
+			if(!JB2DecodeNum(&dec, 0, JB2_BIGPOSITIVE, &(dec.inherited_shape_count_dist), &count)) goto FINAL;
+		} else if(rectype == JB2_PRESERVED_COMMENT) {
+			if(!JB2DecodeComment(&dec)) goto FINAL;
+		} else if(rectype == JB2_START_OF_DATA) {
+			if(!JB2DecodeStart(&dec)) goto FINAL;
+		} else
+			goto FINAL;
+	}
+
+	*width = (uint16_t)dec.image_width;
+	*height = (uint16_t)dec.image_height;
+
+	result = true;
+
+FINAL:
+	JB2DecoderFree(&dec);
+
+	return result;
+}
+
+djvupure_jb2_dict_t * DJVUPURE_APIENTRY JB2DictDecode(djvupure_arena_t *arena, djvupure_chunk_t *djbz, djvupure_jb2_dict_t *inherited)
+{
+	djvupure_jb2_decoder_t dec;
+	djvupure_jb2_dict_t *dict = 0;
+	void *chunk_data = 0;
+	size_t chunk_data_len = 0;
+
+	djvupureRawChunkGetDataPointer(djbz, &chunk_data, &chunk_data_len);
+	if(!chunk_data || !chunk_data_len) return 0;
+
+	JB2DecoderInit(&dec, ArenaGetAllocator(arena), arena, chunk_data, chunk_data_len, true);
+	dec.dict = inherited;
+
+	if(!JB2Decode(&dec)) goto FAILURE;
+
+	dict = ArenaAlloc(arena, sizeof(djvupure_jb2_dict_t));
+	if(!dict) goto FAILURE;
+
+	dict->shapes = dec.library;
+	dict->nof_shapes = dec.nof_library;
+	dict->nof_inherited = dec.nof_inherited;
+
+	JB2DecoderFree(&dec);
+
+	return dict;
+
+FAILURE:
+	for(size_t i = dec.nof_inherited; i < dec.nof_library; i++)
+		ArenaFree(arena, dec.library[i].bits);
+	ArenaFree(arena, dec.library);
+	JB2DecoderFree(&dec);
+
+	return 0;
+}
+
+void DJVUPURE_APIENTRY JB2DictFree(djvupure_arena_t *arena, djvupure_jb2_dict_t *dict)
+{
+	if(!dict) return;
+
+	for(size_t i = dict->nof_inherited; i < dict->nof_shapes; i++)
+		ArenaFree(arena, dict->shapes[i].bits);
+
+	ArenaFree(arena, dict->shapes);
+	ArenaFree(arena, dict);
+}
+
+bool DJVUPURE_APIENTRY JB2GetDict(djvupure_arena_t *arena, djvupure_chunk_t *component, djvupure_chunk_t *dir, unsigned int depth, djvupure_jb2_dict_t **dict)
+{
+	djvupure_jb2_dict_t *inherited = 0;
+	djvupure_chunk_t *djbz;
+	size_t nof_incl;
+
+	*dict = 0;
+
+	// Protects from cycles of included files
+	if(depth > JB2_MAX_DICT_DEPTH) return false;
+
+	// Dictionary is included from the first shared file which has it
+	nof_incl = dir?djvupureContainerCountSubchunksBySign(component, djvupure_incl_sign, 0):0;
+	for(size_t i = 0; i < nof_incl && !inherited; i++) {
+		djvupure_chunk_t *incl;
+		void *incl_data = 0;
+		size_t incl_data_len = 0;
+		char id[256];
+
+		incl = djvupureContainerGetSubchunkBySign(component, djvupure_incl_sign, 0, i);
+		if(!incl) continue;
+
+		djvupureRawChunkGetDataPointer(incl, &incl_data, &incl_data_len);
+		if(!incl_data || !incl_data_len || incl_data_len >= sizeof(id)) continue;
+
+		memcpy(id, incl_data, incl_data_len);
+		id[incl_data_len] = 0;
+
+		inherited = DirGetDict(dir, id, depth+1);
+	}
+
+	djbz = djvupureContainerGetSubchunkBySign(component, djvupure_djbz_sign, 0, 0);
+	if(!djbz) {
+		*dict = inherited;
+
+		return true;
+	}
+
+	*dict = JB2DictDecode(arena, djbz, inherited);
+
+	return *dict != 0;
+}
+
+bool DJVUPURE_APIENTRY JB2GetPageDict(djvupure_arena_t *arena, djvupure_chunk_t *page, djvupure_chunk_t *document, djvupure_jb2_dict_t **dict)
+{
+	djvupure_chunk_t *dir = 0;
+
+	// Only bundled and indirect documents have shared files
+	if(document && djvupureContainerIs(document, djvupure_document_sign)) {
+		dir = djvupureContainerGetSubchunk(document, 0);
+		if(dir && !djvupureDirIs(dir)) dir = 0;
+	}
+
+	return JB2GetDict(arena, page, dir, 0, dict);
+}
+
+// Decodes region as mask or as packed bitmap with rows stride bytes apart
+static bool JB2DecodeRegionTo(djvupure_allocator_t *allocator, djvupure_chunk_t *sjbz, djvupure_jb2_dict_t *dict, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *buf, size_t stride, bool is_packed)
+{
+	djvupure_jb2_decoder_t dec;
+	djvupure_arena_t *arena;
+	void *chunk_data = 0;
+	size_t chunk_data_len = 0;
+	bool result = false;
+
+	if(!width || !height) return false;
+	if(x > width || region_width > width-x || y > height || region_height > height-y) return false;
+
+	djvupureRawChunkGetDataPointer(sjbz, &chunk_data, &chunk_data_len);
+	if(!chunk_data || !chunk_data_len) return false;
+
+	// Page shapes are freed at once
+	arena = ArenaCreate(allocator);
+	if(!arena) return false;
+
+	JB2DecoderInit(&dec, allocator, arena, chunk_data, chunk_data_len, false);
+	dec.dict = dict;
+	dec.width = width;
+	dec.height = height;
+	dec.rect.x = x;
+	dec.rect.y = y;
+	dec.rect.width = region_width;
+	dec.rect.height = region_height;
+
+	if(!JB2Decode(&dec)) goto FINAL;
+
+	if(region_width && region_height && is_packed)
+		result = ImageBitsFromBitsRegion(allocator, dec.target, dec.target_stride, (uint32_t)dec.target_x, (uint32_t)dec.target_y, (uint16_t)dec.image_width, (uint16_t)dec.image_height, width, height, x, y, region_width, region_height, buf, stride);
+	else if(region_width && region_height)
+		result = ImageMaskFromBitsRegion(allocator, dec.target, dec.target_stride, (uint32_t)dec.target_x, (uint32_t)dec.target_y, (uint16_t)dec.image_width, (uint16_t)dec.image_height, width, height, x, y, region_width, region_height, buf);
+	else
+		result = true;
+
+FINAL:
+	JB2DecoderFree(&dec);
+	ArenaDestroy(arena);
+
+	return result;
+}
+
+bool DJVUPURE_APIENTRY JB2DecodeRegion(djvupure_allocator_t *allocator, djvupure_chunk_t *sjbz, djvupure_jb2_dict_t *dict, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, void *buf)
+{
+	return JB2DecodeRegionTo(allocator, sjbz, dict, width, height, x, y, region_width, region_height, (uint8_t *)buf, region_width, false);
+}
+
+bool DJVUPURE_APIENTRY JB2DecodeRegionBits(djvupure_allocator_t *allocator, djvupure_chunk_t *sjbz, djvupure_jb2_dict_t *dict, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *bits, size_t stride)
+{
+	return JB2DecodeRegionTo(allocator, sjbz, dict, width, height, x, y, region_width, region_height, bits, stride, true);
+}
+
+bool DJVUPURE_APIENTRY JB2DecodeBits(djvupure_allocator_t *allocator, djvupure_chunk_t *sjbz, djvupure_jb2_dict_t *dict, djvupure_bitmap_t *bitmap)
+{
+	djvupure_jb2_decoder_t dec;
+	djvupure_arena_t *arena;
+	void *chunk_data = 0;
+	size_t chunk_data_len = 0;
+	bool result = false;
+
+	if(!JB2GetInfo(sjbz, &(bitmap->width), &(bitmap->height))) return false;
+
+	djvupureRawChunkGetDataPointer(sjbz, &chunk_data, &chunk_data_len);
+	if(!chunk_data || !chunk_data_len) return false;
+
+	arena = ArenaCreate(allocator);
+	if(!arena) return false;
+
+	JB2DecoderInit(&dec, allocator, arena, chunk_data, chunk_data_len, false);
+	dec.dict = dict;
+	dec.width = bitmap->width;
+	dec.height = bitmap->height;
+	dec.rect.x = 0;
+	dec.rect.y = 0;
+	dec.rect.width = bitmap->width;
+	dec.rect.height = bitmap->height;
+
+	if(!JB2Decode(&dec)) goto FINAL;
+
+	// Target of whole image is taken from decoder
+	bitmap->bits = dec.target;
+	bitmap->stride = dec.target_stride;
+	dec.target = 0;
+
+	result = true;
+
+FINAL:
+	JB2DecoderFree(&dec);
+	ArenaDestroy(arena);
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*Internal module for JB2 decoding*/
+
+#ifndef DJVUPURE_JB2_H
+#define DJVUPURE_JB2_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+#include "djvupure_arena.h"
+#include "djvupure_image.h"
+
+typedef struct djvupure_jb2_dict_t djvupure_jb2_dict_t;
+
+// Reads image size from start record of Sjbz chunk
+bool DJVUPURE_APIENTRY JB2GetInfo(djvupure_chunk_t *sjbz, uint16_t *width, uint16_t *height);
+// Decodes shapes of Djbz chunk, dictionary is allocated from arena (0 means malloc). inherited is 0 if Djbz doesn't include other dictionary
+djvupure_jb2_dict_t * DJVUPURE_APIENTRY JB2DictDecode(djvupure_arena_t *arena, djvupure_chunk_t *djbz, djvupure_jb2_dict_t *inherited);
+void DJVUPURE_APIENTRY JB2DictFree(djvupure_arena_t *arena, djvupure_jb2_dict_t *dict);
+// Finds dictionary of page or shared component. Own Djbz is decoded into arena, included dictionaries are taken from dir cache (dir may be 0). dict is 0 if there is no dictionary
+bool DJVUPURE_APIENTRY JB2GetDict(djvupure_arena_t *arena, djvupure_chunk_t *component, djvupure_chunk_t *dir, unsigned int depth, djvupure_jb2_dict_t **dict);
+// Same as JB2GetDict for page of document (document may be 0)
+bool DJVUPURE_APIENTRY JB2GetPageDict(djvupure_arena_t *arena, djvupure_chunk_t *page, djvupure_chunk_t *document, djvupure_jb2_dict_t **dict);
+// Decodes mask reduced to width*height, buf holds region_width*region_height pixels (0 is black)
+bool DJVUPURE_APIENTRY JB2DecodeRegion(djvupure_allocator_t *allocator, djvupure_chunk_t *sjbz, djvupure_jb2_dict_t *dict, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, void *buf);
+// Same as JB2DecodeRegion, but region is written as packed bitmap with rows stride bytes apart
+bool DJVUPURE_APIENTRY JB2DecodeRegionBits(djvupure_allocator_t *allocator, djvupure_chunk_t *sjbz, djvupure_jb2_dict_t *dict, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *bits, size_t stride);
+// Decodes whole mask at full resolution, bits of bitmap are freed with allocator
+bool DJVUPURE_APIENTRY JB2DecodeBits(djvupure_allocator_t *allocator, djvupure_chunk_t *sjbz, djvupure_jb2_dict_t *dict, djvupure_bitmap_t *bitmap);
+
+// Implemented in dir module. Returns dictionary of shared component with id, it's decoded on first request and kept until document is freed
+djvupure_jb2_dict_t * DJVUPURE_APIENTRY DirGetDict(djvupure_chunk_t *dir, const char *id, unsigned int depth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
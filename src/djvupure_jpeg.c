@@ -26,61 +26,140 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "djvupure_jpeg.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "third_party/stb_image.h"
+#include "djvupure_image.h"
+#include "djvupure_allocator.h"
 
 #include <string.h>
 
-bool DJVUPURE_APIENTRY JpegGetInfo(djvupure_chunk_t *jpeg, uint16_t *width, uint16_t *height)
+static bool JpegGetData(djvupure_chunk_t *jpeg, const uint8_t **data, size_t *data_len)
 {
-	int img_x, img_y, img_comp;
 	void *chunk_data = 0;
 	size_t chunk_data_len = 0;
 
 	djvupureRawChunkGetDataPointer(jpeg, &chunk_data, &chunk_data_len);
 	if(!chunk_data || !chunk_data_len) return false;
 
-	if(chunk_data_len >= INT_MAX) return false;
+	*data = (const uint8_t *)chunk_data;
+	*data_len = chunk_data_len;
+
+	return true;
+}
 
-	if(!stbi_info_from_memory((stbi_uc*)chunk_data, (int)chunk_data_len, &img_x, &img_y, &img_comp)) return false;
+// Image is reduced by backend while it stays not smaller than target
+static uint8_t JpegGetScale(uint16_t image_width, uint16_t image_height, uint16_t width, uint16_t height)
+{
+	uint8_t scale = 1;
 
-	if(img_x > UINT16_MAX || img_y > UINT16_MAX) return false;
+	while(scale < 8 && (image_width+2*scale-1)/(2*scale) >= width && (image_height+2*scale-1)/(2*scale) >= height) scale *= 2;
+
+	return scale;
+}
+
+bool DJVUPURE_APIENTRY JpegGetInfo(djvupure_chunk_t *jpeg, uint16_t *width, uint16_t *height)
+{
+	const uint8_t *data;
+	size_t data_len;
 
-	*width = (uint16_t)img_x;
-	*height = (uint16_t)img_y;
+	if(!JpegGetData(jpeg, &data, &data_len)) return false;
+
+	return JpegBackendGetInfo(data, data_len, width, height);
+}
+
+bool DJVUPURE_APIENTRY JpegGetReducedInfo(djvupure_chunk_t *jpeg, uint8_t factor, uint16_t *width, uint16_t *height)
+{
+	uint16_t image_width, image_height;
+
+	if(factor != 1 && factor != 2 && factor != 4 && factor != 8) return false;
+	if(!JpegGetInfo(jpeg, &image_width, &image_height)) return false;
+
+	*width = (uint16_t)((image_width+factor-1)/factor);
+	*height = (uint16_t)((image_height+factor-1)/factor);
 
 	return true;
 }
 
-bool DJVUPURE_APIENTRY JpegDecode(djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, void *buf)
+bool DJVUPURE_APIENTRY JpegDecode(djvupure_allocator_t *allocator, djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, void *buf)
 {
-	int img_x, img_y, img_comp;
-	void *chunk_data = 0, *img_buf = 0;
-	size_t chunk_data_len = 0;
-	bool result = false;
+	return JpegDecodeRegion(allocator, jpeg, width, height, 0, 0, width, height, buf);
+}
 
-	if((SIZE_MAX/3)/width < height) return false;
+bool DJVUPURE_APIENTRY JpegDecodeImage(djvupure_allocator_t *allocator, djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, uint8_t **image, uint16_t *image_width, uint16_t *image_height)
+{
+	const uint8_t *data;
+	size_t data_len;
+	uint16_t reduced_width, reduced_height;
+	uint8_t scale;
 
-	djvupureRawChunkGetDataPointer(jpeg, &chunk_data, &chunk_data_len);
-	if(!chunk_data || !chunk_data_len) return false;
+	if(!JpegGetData(jpeg, &data, &data_len)) return false;
+	if(!JpegBackendGetInfo(data, data_len, &reduced_width, &reduced_height)) return false;
 
-	if(chunk_data_len >= INT_MAX) return false;
+	scale = JpegGetScale(reduced_width, reduced_height, width, height);
+	reduced_width = (uint16_t)((reduced_width+scale-1)/scale);
+	reduced_height = (uint16_t)((reduced_height+scale-1)/scale);
+	if(!reduced_width || !reduced_height || (SIZE_MAX/3)/reduced_width < reduced_height) return false;
 
-	img_buf = (void *)stbi_load_from_memory((stbi_uc *)chunk_data, (int)chunk_data_len, &img_x, &img_y, &img_comp, 3);
-	if(!img_buf) return false;
+	*image = AllocatorAlloc(allocator, (size_t)reduced_width*reduced_height*3);
+	if(!(*image)) return false;
 
-	if(img_x != width || img_y != height) {
-		if(img_x > width || img_y > height) goto FINAL;
-		if(!djvupureImageResizeFine(img_x, img_y, img_buf, width, height, buf, 3)) goto FINAL;
-	} else
-		memcpy(buf, img_buf, (size_t)width* (size_t)height * 3);
+	if(!JpegBackendDecode(allocator, data, data_len, scale, 0, 0, reduced_width, reduced_height, *image, (size_t)reduced_width*3)) {
+		AllocatorFree(allocator, *image);
+		*image = 0;
 
-	result = true;
+		return false;
+	}
 
-FINAL:
+	*image_width = reduced_width;
+	*image_height = reduced_height;
 
-	if(img_buf) free(img_buf);
+	return true;
+}
 
-	return result;
+bool DJVUPURE_APIENTRY JpegDecodeInto(djvupure_allocator_t *allocator, djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, uint8_t *buf, size_t stride)
+{
+	const uint8_t *data;
+	size_t data_len;
+	uint16_t image_width, image_height;
+
+	if(!width || !height || stride < (size_t)width*3) return false;
+
+	if(!JpegGetData(jpeg, &data, &data_len)) return false;
+	if(!JpegBackendGetInfo(data, data_len, &image_width, &image_height)) return false;
+	if(image_width != width || image_height != height) return false;
+
+	return JpegBackendDecode(allocator, data, data_len, 1, 0, 0, width, height, buf, stride);
 }
+
+bool DJVUPURE_APIENTRY JpegDecodeRegion(djvupure_allocator_t *allocator, djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, void *buf)
+{
+	const uint8_t *data;
+	size_t data_len;
+	uint8_t *image;
+	uint16_t image_width, image_height;
+	uint8_t scale;
+	bool result;
+
+	if(!width || !height || !region_width || !region_height) return false;
+	if(x > width-region_width || y > height-region_height) return false;
+	if((SIZE_MAX/3)/width < height) return false;
+
+	if(!JpegGetData(jpeg, &data, &data_len)) return false;
+	if(!JpegBackendGetInfo(data, data_len, &image_width, &image_height)) return false;
+
+	scale = JpegGetScale(image_width, image_height, width, height);
+	image_width = (uint16_t)((image_width+scale-1)/scale);
+	image_height = (uint16_t)((image_height+scale-1)/scale);
+
+	// Region of image at target size is decoded straight to buf
+	if(image_width == width && image_height == height)
+		return JpegBackendDecode(allocator, data, data_len, scale, x, y, region_width, region_height, (uint8_t *)buf, (size_t)region_width*3);
+
+	image = AllocatorAlloc(allocator, (size_t)image_width*image_height*3);
+	if(!image) return false;
+
+	result = JpegBackendDecode(allocator, data, data_len, scale, 0, 0, image_width, image_height, image, (size_t)image_width*3);
+	if(result) result = ImageResizeRegionEx(allocator, image_width, image_height, image, width, height, x, y, region_width, region_height, buf, 3);
+
+	AllocatorFree(allocator, image);
+
+	return result;
+}
\ No newline at end of file
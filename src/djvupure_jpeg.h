@@ -35,8 +35,23 @@ extern "C" {
 
 #include "../include/djvupure.h"
 
+// Backend is bundled stb_image, or libjpeg-turbo if DJVUPURE_JPEG_TURBO is defined. Both reduce image in DCT domain
+
+// Functions of backend, data is JPEG stream
+bool DJVUPURE_APIENTRY JpegBackendGetInfo(const uint8_t *data, size_t data_len, uint16_t *width, uint16_t *height);
+// Decodes region of image reduced by scale (1, 2, 4 or 8) to ceil(width/scale) x ceil(height/scale), rows of buf are stride bytes apart
+bool DJVUPURE_APIENTRY JpegBackendDecode(djvupure_allocator_t *allocator, const uint8_t *data, size_t data_len, uint8_t scale, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *buf, size_t stride);
+
 bool DJVUPURE_APIENTRY JpegGetInfo(djvupure_chunk_t *jpeg, uint16_t *width, uint16_t *height);
-bool DJVUPURE_APIENTRY JpegDecode(djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, void *buf);
+// Size of image reduced by factor (1, 2, 4 or 8) while decoding
+bool DJVUPURE_APIENTRY JpegGetReducedInfo(djvupure_chunk_t *jpeg, uint8_t factor, uint16_t *width, uint16_t *height);
+bool DJVUPURE_APIENTRY JpegDecode(djvupure_allocator_t *allocator, djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, void *buf);
+// Decodes image reduced while it stays not smaller than width*height, image is freed with allocator
+bool DJVUPURE_APIENTRY JpegDecodeImage(djvupure_allocator_t *allocator, djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, uint8_t **image, uint16_t *image_width, uint16_t *image_height);
+// Decodes image of width x height pixels straight to buf, rows are stride bytes apart, so buf may be part of larger image
+bool DJVUPURE_APIENTRY JpegDecodeInto(djvupure_allocator_t *allocator, djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, uint8_t *buf, size_t stride);
+// Decodes only region of image scaled to width x height, buf holds region_width*region_height pixels
+bool DJVUPURE_APIENTRY JpegDecodeRegion(djvupure_allocator_t *allocator, djvupure_chunk_t *jpeg, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, void *buf);
 
 #ifdef __cplusplus
 }
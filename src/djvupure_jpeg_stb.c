@@ -0,0 +1,119 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+// Bundled stb_image backend of djvupure_jpeg, used unless DJVUPURE_JPEG_TURBO is defined
+
+#ifndef DJVUPURE_JPEG_TURBO
+
+#include "djvupure_jpeg.h"
+#include "djvupure_allocator.h"
+
+#if defined(_MSC_VER)
+#define DJVUPURE_THREAD_LOCAL __declspec(thread)
+#else
+#define DJVUPURE_THREAD_LOCAL _Thread_local
+#endif
+
+// stb_image has no allocation context, so allocator of current decode is kept per thread
+static DJVUPURE_THREAD_LOCAL djvupure_allocator_t *djvupure_jpeg_allocator = 0;
+
+#define STBI_MALLOC(sz) AllocatorAlloc(djvupure_jpeg_allocator, sz)
+#define STBI_REALLOC(p,newsz) AllocatorRealloc(djvupure_jpeg_allocator, p, newsz)
+#define STBI_FREE(p) AllocatorFree(djvupure_jpeg_allocator, p)
+#define STB_IMAGE_IMPLEMENTATION
+#include "third_party/stb_image.h"
+
+#include <string.h>
+
+bool DJVUPURE_APIENTRY JpegBackendGetInfo(const uint8_t *data, size_t data_len, uint16_t *width, uint16_t *height)
+{
+	int img_x, img_y, img_comp;
+
+	if(data_len >= INT_MAX) return false;
+
+	if(!stbi_info_from_memory((stbi_uc *)data, (int)data_len, &img_x, &img_y, &img_comp)) return false;
+
+	if(img_x > UINT16_MAX || img_y > UINT16_MAX) return false;
+
+	*width = (uint16_t)img_x;
+	*height = (uint16_t)img_y;
+
+	return true;
+}
+
+// Decodes whole image reduced by 1 << scale_shift
+static bool JpegStbDecode(djvupure_allocator_t *allocator, const uint8_t *data, size_t data_len, int scale_shift, uint16_t width, uint16_t height, uint8_t *buf, size_t stride)
+{
+	int result;
+
+	djvupure_jpeg_allocator = allocator;
+	result = stbi_load_jpeg_into_from_memory((stbi_uc *)data, (int)data_len, scale_shift, width, height, buf, stride);
+	djvupure_jpeg_allocator = 0;
+
+	return result?true:false;
+}
+
+// stb_image reduces image by idct of fewer coefficients, but can't crop, so region is cut from whole image
+bool DJVUPURE_APIENTRY JpegBackendDecode(djvupure_allocator_t *allocator, const uint8_t *data, size_t data_len, uint8_t scale, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *buf, size_t stride)
+{
+	uint8_t *image;
+	uint16_t width, height;
+	int scale_shift;
+	bool result;
+
+	switch(scale) {
+		case 1: scale_shift = 0; break;
+		case 2: scale_shift = 1; break;
+		case 4: scale_shift = 2; break;
+		case 8: scale_shift = 3; break;
+		default: return false;
+	}
+	if(!JpegBackendGetInfo(data, data_len, &width, &height)) return false;
+
+	width = (uint16_t)((width+scale-1)/scale);
+	height = (uint16_t)((height+scale-1)/scale);
+	if(!region_width || !region_height || x > width-region_width || y > height-region_height) return false;
+	if(stride < (size_t)region_width*3) return false;
+
+	if(region_width == width && region_height == height)
+		return JpegStbDecode(allocator, data, data_len, scale_shift, width, height, buf, stride);
+
+	if((SIZE_MAX/3)/width < height) return false;
+
+	image = AllocatorAlloc(allocator, (size_t)width*height*3);
+	if(!image) return false;
+
+	result = JpegStbDecode(allocator, data, data_len, scale_shift, width, height, image, (size_t)width*3);
+	if(result)
+		for(size_t row = 0; row < region_height; row++)
+			memcpy(buf+row*stride, image+((size_t)(y+row)*width+x)*3, (size_t)region_width*3);
+
+	AllocatorFree(allocator, image);
+
+	return result;
+}
+
+#endif
\ No newline at end of file
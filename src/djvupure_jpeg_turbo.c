@@ -0,0 +1,165 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+// libjpeg-turbo backend of djvupure_jpeg, used if DJVUPURE_JPEG_TURBO is defined
+// Memory of decoder is allocated by libjpeg itself, only row buffer for crop uses allocator
+
+#ifdef DJVUPURE_JPEG_TURBO
+
+#include "djvupure_jpeg.h"
+#include "djvupure_allocator.h"
+
+#include <stdio.h>
+#include <setjmp.h>
+#include <limits.h>
+#include <string.h>
+#include <jpeglib.h>
+
+#if !defined(LIBJPEG_TURBO_VERSION)
+#error libjpeg-turbo is needed for jpeg_crop_scanline and jpeg_skip_scanlines
+#endif
+
+#define DJVUPURE_JPEG_TURBO_CROP_MARGIN 2
+
+typedef struct {
+	struct jpeg_error_mgr mgr;
+	jmp_buf jump;
+} djvupure_jpeg_turbo_error_t;
+
+static void JpegTurboErrorExit(j_common_ptr cinfo)
+{
+	longjmp(((djvupure_jpeg_turbo_error_t *)cinfo->err)->jump, 1);
+}
+
+static void JpegTurboOutputMessage(j_common_ptr cinfo)
+{
+	(void)cinfo; // Warnings aren't printed
+}
+
+static void JpegTurboSetErrorHandler(struct jpeg_decompress_struct *cinfo, djvupure_jpeg_turbo_error_t *error)
+{
+	cinfo->err = jpeg_std_error(&(error->mgr));
+	error->mgr.error_exit = JpegTurboErrorExit;
+	error->mgr.output_message = JpegTurboOutputMessage;
+}
+
+bool DJVUPURE_APIENTRY JpegBackendGetInfo(const uint8_t *data, size_t data_len, uint16_t *width, uint16_t *height)
+{
+	struct jpeg_decompress_struct cinfo;
+	djvupure_jpeg_turbo_error_t error;
+
+	if(data_len > ULONG_MAX) return false;
+
+	JpegTurboSetErrorHandler(&cinfo, &error);
+	jpeg_create_decompress(&cinfo);
+	if(setjmp(error.jump)) {
+		jpeg_destroy_decompress(&cinfo);
+
+		return false;
+	}
+
+	jpeg_mem_src(&cinfo, (const unsigned char *)data, (unsigned long)data_len);
+	jpeg_read_header(&cinfo, TRUE);
+
+	jpeg_destroy_decompress(&cinfo);
+
+	if(cinfo.image_width > UINT16_MAX || cinfo.image_height > UINT16_MAX) return false;
+
+	*width = (uint16_t)cinfo.image_width;
+	*height = (uint16_t)cinfo.image_height;
+
+	return true;
+}
+
+// Scaling is done by IDCT, columns are cut by iMCU and rows above region are skipped without color conversion
+bool DJVUPURE_APIENTRY JpegBackendDecode(djvupure_allocator_t *allocator, const uint8_t *data, size_t data_len, uint8_t scale, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *buf, size_t stride)
+{
+	struct jpeg_decompress_struct cinfo;
+	djvupure_jpeg_turbo_error_t error;
+	uint8_t * volatile row_buffer = 0;
+	JDIMENSION crop_x, crop_width;
+
+	if(scale != 1 && scale != 2 && scale != 4 && scale != 8) return false;
+	if(!region_width || !region_height || stride < (size_t)region_width*3) return false;
+	if(data_len > ULONG_MAX) return false;
+
+	JpegTurboSetErrorHandler(&cinfo, &error);
+	jpeg_create_decompress(&cinfo);
+	if(setjmp(error.jump)) {
+		jpeg_destroy_decompress(&cinfo);
+		AllocatorFree(allocator, row_buffer);
+
+		return false;
+	}
+
+	jpeg_mem_src(&cinfo, (const unsigned char *)data, (unsigned long)data_len);
+	jpeg_read_header(&cinfo, TRUE);
+
+	cinfo.out_color_space = JCS_RGB;
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = scale;
+
+	jpeg_start_decompress(&cinfo);
+
+	if(cinfo.output_components != 3 || x > cinfo.output_width || region_width > cinfo.output_width-x || y > cinfo.output_height || region_height > cinfo.output_height-y) {
+		jpeg_destroy_decompress(&cinfo);
+
+		return false;
+	}
+
+	// Cropped columns start at iMCU boundary, so extra columns on the left go to row buffer
+	// Chroma upsampling reads neighbour columns, so crop has margin to keep edge pixels same as in full decode
+	crop_x = x > DJVUPURE_JPEG_TURBO_CROP_MARGIN ? x-DJVUPURE_JPEG_TURBO_CROP_MARGIN : 0;
+	crop_width = x+region_width+DJVUPURE_JPEG_TURBO_CROP_MARGIN < cinfo.output_width ? x+region_width+DJVUPURE_JPEG_TURBO_CROP_MARGIN-crop_x : cinfo.output_width-crop_x;
+	if(crop_width < cinfo.output_width) jpeg_crop_scanline(&cinfo, &crop_x, &crop_width);
+	if(crop_x != x || crop_width != region_width) {
+		row_buffer = AllocatorAlloc(allocator, (size_t)crop_width*3);
+		if(!row_buffer) {
+			jpeg_destroy_decompress(&cinfo);
+
+			return false;
+		}
+	}
+
+	if(y) jpeg_skip_scanlines(&cinfo, y);
+
+	for(size_t row = 0; row < region_height; row++) {
+		JSAMPROW p;
+
+		p = row_buffer?row_buffer:buf+row*stride;
+		if(jpeg_read_scanlines(&cinfo, &p, 1) != 1) longjmp(error.jump, 1);
+		if(row_buffer) memcpy(buf+row*stride, row_buffer+(size_t)(x-crop_x)*3, (size_t)region_width*3);
+	}
+
+	// Rows below region aren't decoded
+	jpeg_abort_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	AllocatorFree(allocator, row_buffer);
+
+	return true;
+}
+
+#endif
\ No newline at end of file
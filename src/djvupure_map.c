@@ -0,0 +1,306 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#define _LARGEFILE_SOURCE
+#define _LARGEFILE64_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "extclib/wcstombsl.h"
+#endif
+
+#include "../include/djvupure.h"
+#include "djvupure_read.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+	uint8_t *data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+} djvupure_file_map_t;
+
+typedef struct {
+	djvupure_file_map_t *fmap;
+	size_t pos;
+} djvupure_map_stream_t;
+
+#ifdef _WIN32
+static void *djvupureFileMapHandle(HANDLE file)
+{
+	djvupure_file_map_t *fmap;
+	LARGE_INTEGER file_size;
+
+	if(file == INVALID_HANDLE_VALUE) return 0;
+
+	fmap = malloc(sizeof(djvupure_file_map_t));
+	if(!fmap) goto FAILURE;
+	memset(fmap, 0, sizeof(djvupure_file_map_t));
+	fmap->file = file;
+
+	if(!GetFileSizeEx(file, &file_size)) goto FAILURE;
+	if(file_size.QuadPart <= 0 || (uint64_t)file_size.QuadPart > SIZE_MAX) goto FAILURE;
+	fmap->size = (size_t)file_size.QuadPart;
+
+	// Copy-on-write mapping, so djvupureInfoPut and others can change chunk data without touching file
+	fmap->mapping = CreateFileMappingW(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if(!fmap->mapping) goto FAILURE;
+
+	fmap->data = MapViewOfFile(fmap->mapping, FILE_MAP_COPY, 0, 0, fmap->size);
+	if(!fmap->data) goto FAILURE;
+
+	return fmap;
+
+FAILURE:
+	if(fmap) {
+		if(fmap->mapping) CloseHandle(fmap->mapping);
+		free(fmap);
+	}
+	CloseHandle(file);
+
+	return 0;
+}
+#else
+static void *djvupureFileMapDescriptor(int fd)
+{
+	djvupure_file_map_t *fmap;
+	struct stat st;
+	void *data;
+
+	if(fd < 0) return 0;
+
+	if(fstat(fd, &st)) goto FAILURE;
+	if(st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX) goto FAILURE;
+
+	fmap = malloc(sizeof(djvupure_file_map_t));
+	if(!fmap) goto FAILURE;
+
+	fmap->size = (size_t)st.st_size;
+
+	// Copy-on-write mapping, so djvupureInfoPut and others can change chunk data without touching file
+	data = mmap(NULL, fmap->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if(data == MAP_FAILED) {
+		free(fmap);
+
+		goto FAILURE;
+	}
+	fmap->data = (uint8_t *)data;
+
+	close(fd);
+
+	return fmap;
+
+FAILURE:
+	close(fd);
+
+	return 0;
+}
+#endif
+
+DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupureFileMapA(char *filename)
+{
+#ifdef _WIN32
+	return djvupureFileMapHandle(CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL));
+#else
+	return djvupureFileMapDescriptor(open(filename, O_RDONLY));
+#endif
+}
+
+DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupureFileMapW(wchar_t *filename)
+{
+#ifdef _WIN32
+	return djvupureFileMapHandle(CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL));
+#else
+	char *cfilename;
+	size_t strsize;
+	void *fmap;
+
+	strsize = wcstombs(NULL, filename, 0);
+	if(strsize == (size_t)-1) return 0;
+	strsize++;
+
+	cfilename = malloc(strsize);
+	if(!cfilename) return 0;
+
+	wcstombsl(cfilename, filename, strsize);
+
+	fmap = djvupureFileMapA(cfilename);
+
+	free(cfilename);
+
+	return fmap;
+#endif
+}
+
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureFileUnmap(void *fmap)
+{
+	djvupure_file_map_t *_fmap;
+
+	if(!fmap) return;
+
+	_fmap = (djvupure_file_map_t *)fmap;
+
+#ifdef _WIN32
+	UnmapViewOfFile(_fmap->data);
+	CloseHandle(_fmap->mapping);
+	CloseHandle(_fmap->file);
+#else
+	munmap(_fmap->data, _fmap->size);
+#endif
+
+	free(_fmap);
+}
+
+static size_t DJVUPURE_APIENTRY djvupureMapStreamRead(void *fctx, void *buf, size_t size)
+{
+	djvupure_map_stream_t *stream;
+	size_t left;
+
+	stream = (djvupure_map_stream_t *)fctx;
+
+	left = stream->fmap->size-stream->pos;
+	if(size > left) size = left;
+
+	memcpy(buf, stream->fmap->data+stream->pos, size);
+	stream->pos += size;
+
+	return size;
+}
+
+static size_t DJVUPURE_APIENTRY djvupureMapStreamWrite(void *fctx, const void *buf, size_t size)
+{
+	(void)fctx;
+	(void)buf;
+	(void)size;
+
+	return 0;
+}
+
+static int DJVUPURE_APIENTRY djvupureMapStreamSeek(void *fctx, int64_t offset, int origin)
+{
+	djvupure_map_stream_t *stream;
+	int64_t base;
+
+	stream = (djvupure_map_stream_t *)fctx;
+
+	switch(origin) {
+		case DJVUPURE_IO_SEEK_CUR:
+			base = (int64_t)(stream->pos);
+			break;
+		case DJVUPURE_IO_SEEK_END:
+			base = (int64_t)(stream->fmap->size);
+			break;
+		case DJVUPURE_IO_SEEK_SET:
+			base = 0;
+			break;
+		default:
+			return -1;
+	}
+
+	if(offset < -base || offset > (int64_t)(stream->fmap->size)-base) return -1;
+
+	stream->pos = (size_t)(base+offset);
+
+	return 0;
+}
+
+static int64_t DJVUPURE_APIENTRY djvupureMapStreamTell(void *fctx)
+{
+	return (int64_t)(((djvupure_map_stream_t *)fctx)->pos);
+}
+
+static djvupure_chunk_t * DJVUPURE_APIENTRY djvupureMapRawChunkRead(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena)
+{
+	djvupure_map_stream_t *stream;
+	djvupure_chunk_t *chunk;
+	uint8_t *chunk_header;
+	size_t chunk_len;
+
+	(void)io;
+
+	stream = (djvupure_map_stream_t *)fctx;
+
+	if(stream->pos % 2) stream->pos++;
+	if(stream->pos > stream->fmap->size || stream->fmap->size-stream->pos < 8) return 0;
+
+	chunk_header = stream->fmap->data+stream->pos;
+	chunk_len = ((size_t)(chunk_header[4])<<24)+
+		((size_t)(chunk_header[5])<<16)+
+		((size_t)(chunk_header[6])<<8)+
+		chunk_header[7];
+
+	if(chunk_len > stream->fmap->size-stream->pos-8) return 0;
+
+	// Chunk data isn't copied, it points straight to the mapping
+	chunk = RawChunkCreateRef(arena, chunk_header, chunk_header+8, chunk_len);
+	if(!chunk) return 0;
+
+	stream->pos += 8+chunk_len;
+
+	return chunk;
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentMap(void *fmap)
+{
+	return djvupureDocumentMapWithFlags(fmap, 0);
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentMapWithFlags(void *fmap, uint32_t flags)
+{
+	return djvupureDocumentMapWithAllocator(fmap, flags, 0);
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureDocumentMapWithAllocator(void *fmap, uint32_t flags, djvupure_allocator_t *allocator)
+{
+	djvupure_io_callback_t io;
+	djvupure_map_stream_t stream;
+
+	if(!fmap) return 0;
+
+	io.hash = djvupureIOGetStructHash();
+	io.callback_read = djvupureMapStreamRead;
+	io.callback_write = djvupureMapStreamWrite;
+	io.callback_seek = djvupureMapStreamSeek;
+	io.callback_tell = djvupureMapStreamTell;
+
+	stream.fmap = (djvupure_file_map_t *)fmap;
+	stream.pos = 0;
+
+	// Stream lives only during this call, and mapped chunks are read without copying anyway
+	flags &= ~DJVUPURE_DOCUMENT_FLAG_LAZY;
+
+	return DocumentReadEx(&io, &stream, djvupureMapRawChunkRead, flags, allocator);
+}
\ No newline at end of file
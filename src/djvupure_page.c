@@ -27,6 +27,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../include/djvupure.h"
 #include "djvupure_sign.h"
+#include "djvupure_allocator.h"
+#include "djvupure_read.h"
+#include "djvupure_image.h"
+#include "djvupure_blend.h"
+#include "djvupure_jpeg.h"
+#include "djvupure_iw44.h"
+#include "djvupure_jb2.h"
+#include "djvupure_smmr.h"
+#include "djvupure_thread.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -52,12 +61,32 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageIs(djvupure_chunk_t *page
 	return true;
 }
 
+// Scratch buffer kept between pages, it only grows until djvupurePageImageRendererShrink
+typedef struct {
+	uint8_t *data;
+	size_t size;
+} djvupure_image_renderer_buffer_t;
+
+// Layer decoded at its own resolution
+typedef struct {
+	uint8_t *image;
+	uint16_t width;
+	uint16_t height;
+	djvupure_image_renderer_buffer_t strip; // Strips of rotated layer
+} djvupure_image_renderer_layer_t;
+
 typedef struct {
 	djvupure_chunk_t *page;
-	uint8_t *mask;
+	djvupure_bitmap_t mask; // Mask of rect, it's kept until foreground is blended
+	djvupure_jb2_dict_t *dict; // Shapes shared by pages for Sjbz
+	djvupure_arena_t *dict_arena; // Page's own dictionary
 	djvupure_page_info_t info;
 	uint16_t final_width;
 	uint16_t final_height;
+	uint16_t layer_width; // Page size after scaling, before rotation
+	uint16_t layer_height;
+	djvupure_rect_t rect; // Rendered rectangle
+	djvupure_rect_t src_rect; // Rendered rectangle before rotation
 	size_t count_bg44;
 	size_t count_bgjp;
 	size_t count_sjbz;
@@ -66,6 +95,18 @@ typedef struct {
 	size_t count_fgjp;
 	int render_status;
 	bool is_bg_read;
+	bool is_started;
+	bool is_banded; // Layers are decoded once and kept for all bands
+	djvupure_image_renderer_layer_t bg;
+	djvupure_image_renderer_layer_t fg;
+	djvupure_bitmap_t mask_bits; // Mask at full resolution
+	djvupure_image_renderer_buffer_t mask_buffer; // Bits of mask
+	djvupure_image_renderer_buffer_t mask_strip;
+	djvupure_image_renderer_buffer_t fg_buffer; // Foreground of rect before blending
+	djvupure_image_renderer_buffer_t band_buffer;
+	uint32_t flags;
+	djvupure_allocator_t allocator;
+	bool has_allocator;
 } djvupure_image_renderer_ctx_t;
 
 enum {
@@ -79,31 +120,87 @@ enum {
 	DJVUPURE_RENDER_STATUS_LAST
 };
 
+static djvupure_allocator_t *djvupurePageImageRendererGetAllocator(djvupure_image_renderer_ctx_t *ctx)
+{
+	return ctx->has_allocator?&(ctx->allocator):0;
+}
+
 DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererCreate(djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t *width, uint16_t *height, uint8_t *channels)
 {
-	djvupure_image_renderer_ctx_t *ctx;
+	return djvupurePageImageRendererCreateWithAllocator(page, document, width, height, channels, 0);
+}
+
+// Returns buffer of at least size bytes, its contents aren't kept when it grows
+static uint8_t *djvupurePageImageRendererReserve(djvupure_image_renderer_ctx_t *ctx, djvupure_image_renderer_buffer_t *buffer, size_t size)
+{
+	djvupure_allocator_t *allocator;
+
+	if(size <= buffer->size) return buffer->data;
+
+	allocator = djvupurePageImageRendererGetAllocator(ctx);
+
+	if(buffer->data) AllocatorFree(allocator, buffer->data);
+	buffer->size = 0;
+
+	buffer->data = AllocatorAlloc(allocator, size);
+	if(buffer->data) buffer->size = size;
+
+	return buffer->data;
+}
+
+static void djvupurePageImageRendererRelease(djvupure_allocator_t *allocator, djvupure_image_renderer_buffer_t *buffer)
+{
+	if(buffer->data) AllocatorFree(allocator, buffer->data);
+	buffer->data = 0;
+	buffer->size = 0;
+}
+
+// Points mask to bits of rect from mask buffer
+static bool djvupurePageImageRendererAllocMask(djvupure_image_renderer_ctx_t *ctx)
+{
+	size_t stride;
+
+	stride = ((size_t)ctx->rect.width+7)/8;
+	if(SIZE_MAX/stride < ctx->rect.height) return false;
+
+	ctx->mask.bits = djvupurePageImageRendererReserve(ctx, &(ctx->mask_buffer), stride*ctx->rect.height);
+	if(!ctx->mask.bits) return false;
+
+	ctx->mask.stride = stride;
+	ctx->mask.width = ctx->rect.width;
+	ctx->mask.height = ctx->rect.height;
+
+	return true;
+}
+
+// Prepares context for rendering of page, scratch buffers and flags are left as they are
+static bool djvupurePageImageRendererInit(djvupure_image_renderer_ctx_t *ctx, djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t *width, uint16_t *height, uint8_t *channels)
+{
 	djvupure_chunk_t *info_chunk;
 
-	if(!djvupurePageIs(page)) return 0;
+	// Context stays safe to destroy if page can't be rendered
+	ctx->page = 0;
+	ctx->mask.bits = 0;
+	ctx->mask_bits.bits = 0;
+	ctx->bg.image = ctx->fg.image = 0;
+	ctx->dict = 0;
+	ctx->dict_arena = 0;
+	ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
+	ctx->is_started = true;
 
-	if(document)
-		if(!djvupureDocumentIs(document)) return 0;
+	if(!page) return false;
 
-	if(!page) return 0;
+	if(!djvupurePageIs(page)) return false;
 
-	if(!width || !height || !channels) return 0;
+	if(document)
+		if(!djvupureDocumentIs(document)) return false;
 
-	ctx = (djvupure_image_renderer_ctx_t *)malloc(sizeof(djvupure_image_renderer_ctx_t));
-	if(!ctx) return 0;
+	if(!width || !height || !channels) return false;
 
 	ctx->page = page;
 
 	info_chunk = djvupureContainerGetSubchunk(page, 0);
-	if(!djvupureInfoIs(info_chunk)) {
-		free(ctx);
-
-		return 0;
-	}
+	if(!djvupureInfoIs(info_chunk)) return false;
 
 	djvupureInfoGet(info_chunk, &(ctx->info));
 
@@ -120,8 +217,17 @@ DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererCreate(djv
 			ctx->final_height = ctx->info.height;
 	}
 
-	ctx->mask = 0;
+	ctx->layer_width = ctx->info.width;
+	ctx->layer_height = ctx->info.height;
+	ctx->rect.x = ctx->rect.y = 0;
+	ctx->rect.width = ctx->final_width;
+	ctx->rect.height = ctx->final_height;
+	ctx->src_rect.x = ctx->src_rect.y = 0;
+	ctx->src_rect.width = ctx->layer_width;
+	ctx->src_rect.height = ctx->layer_height;
+
 	ctx->is_bg_read = false;
+	ctx->is_banded = false;
 
 	ctx->count_bg44 = djvupureContainerCountSubchunksBySign(page, djvupure_bg44_sign, 0);
 	ctx->count_bgjp = djvupureContainerCountSubchunksBySign(page, djvupure_bgjp_sign, 0);
@@ -130,15 +236,22 @@ DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererCreate(djv
 	ctx->count_fg44 = djvupureContainerCountSubchunksBySign(page, djvupure_fg44_sign, 0);
 	ctx->count_fgjp = djvupureContainerCountSubchunksBySign(page, djvupure_fgjp_sign, 0);
 
+	// Shared dictionary is found now, while document tree can be accessed
+	if(ctx->count_sjbz) {
+		if(djvupureContainerCountSubchunksBySign(page, djvupure_djbz_sign, 0)) {
+			ctx->dict_arena = ArenaCreate(djvupurePageImageRendererGetAllocator(ctx));
+			if(!ctx->dict_arena) return false;
+		}
+
+		// Without dictionary only Smmr can be rendered
+		if(!JB2GetPageDict(ctx->dict_arena, page, document, &(ctx->dict))) ctx->dict = 0;
+	}
+
 	if(ctx->count_bg44) ctx->render_status = DJVUPURE_RENDER_STATUS_BG44;
 	else if(ctx->count_bgjp) ctx->render_status = DJVUPURE_RENDER_STATUS_BGjp;
 	else if(ctx->count_sjbz) ctx->render_status = DJVUPURE_RENDER_STATUS_Sjbz;
 	else if(ctx->count_smmr) ctx->render_status = DJVUPURE_RENDER_STATUS_Smmr;
-	else {
-		free(ctx);
-
-		return 0;
-	}
+	else return false;
 
 	*width = ctx->final_width;
 	*height = ctx->final_height;
@@ -151,33 +264,310 @@ DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererCreate(djv
 			*channels = 1;
 	}
 
+	ctx->is_started = false;
+
+	return true;
+}
+
+// Frees layers kept for bands
+static void djvupurePageImageRendererFreeLayers(djvupure_image_renderer_ctx_t *ctx, djvupure_allocator_t *allocator)
+{
+	if(ctx->bg.image) AllocatorFree(allocator, ctx->bg.image);
+	if(ctx->fg.image) AllocatorFree(allocator, ctx->fg.image);
+	ImageBitmapFree(allocator, &(ctx->mask_bits));
+	ctx->bg.image = ctx->fg.image = 0;
+}
+
+// Frees everything decoded for current page
+static void djvupurePageImageRendererFreePage(djvupure_image_renderer_ctx_t *ctx, djvupure_allocator_t *allocator)
+{
+	djvupurePageImageRendererFreeLayers(ctx, allocator);
+	ctx->mask.bits = 0;
+
+	ArenaDestroy(ctx->dict_arena);
+	ctx->dict_arena = 0;
+	ctx->dict = 0;
+}
+
+// Frees scratch buffers
+static void djvupurePageImageRendererFreeBuffers(djvupure_image_renderer_ctx_t *ctx, djvupure_allocator_t *allocator)
+{
+	djvupurePageImageRendererRelease(allocator, &(ctx->bg.strip));
+	djvupurePageImageRendererRelease(allocator, &(ctx->fg.strip));
+	djvupurePageImageRendererRelease(allocator, &(ctx->mask_buffer));
+	djvupurePageImageRendererRelease(allocator, &(ctx->mask_strip));
+	djvupurePageImageRendererRelease(allocator, &(ctx->fg_buffer));
+	djvupurePageImageRendererRelease(allocator, &(ctx->band_buffer));
+}
+
+DJVUPURE_API void * DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererCreateWithAllocator(djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t *width, uint16_t *height, uint8_t *channels, djvupure_allocator_t *allocator)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+
+	if(allocator)
+		if(allocator->hash != djvupureAllocatorGetStructHash()) return 0;
+
+	ctx = (djvupure_image_renderer_ctx_t *)AllocatorAlloc(allocator, sizeof(djvupure_image_renderer_ctx_t));
+	if(!ctx) return 0;
+
+	memset(ctx, 0, sizeof(djvupure_image_renderer_ctx_t));
+	ctx->has_allocator = allocator != 0;
+	if(allocator) ctx->allocator = *allocator;
+
+	if(!djvupurePageImageRendererInit(ctx, page, document, width, height, channels)) {
+		ArenaDestroy(ctx->dict_arena);
+		AllocatorFree(allocator, ctx);
+
+		return 0;
+	}
+
 	return ctx;
 }
 
-static void djvupurePageImageRenderBackground(djvupure_image_renderer_ctx_t *ctx, void *image_buffer)
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererReset(void *image_renderer_ctx, djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t *width, uint16_t *height, uint8_t *channels)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+
+	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
+
+	djvupurePageImageRendererFreePage(ctx, djvupurePageImageRendererGetAllocator(ctx));
+
+	return djvupurePageImageRendererInit(ctx, page, document, width, height, channels);
+}
+
+DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererShrink(void *image_renderer_ctx)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+
+	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
+
+	djvupurePageImageRendererFreeBuffers(ctx, djvupurePageImageRendererGetAllocator(ctx));
+}
+
+// Pages rotated by 90 or 270 degrees are decoded by strips, so layers are kept while strips are decoded
+static bool djvupurePageImageRendererIsTransposed(djvupure_image_renderer_ctx_t *ctx)
+{
+	return ctx->info.rotation == 5 || ctx->info.rotation == 6;
+}
+
+// Decodes src_rect of IW44 or JPEG layer
+static bool djvupurePageImageRendererDecodeColor(djvupure_image_renderer_ctx_t *ctx, const djvupure_rect_t *src_rect, djvupure_image_renderer_layer_t *layer, const uint8_t sign[4], bool is_iw44, void *buf)
 {
-	if(ctx->render_status == DJVUPURE_RENDER_STATUS_BG44) {
-		// We don't have support for now
-		if(ctx->count_bgjp) ctx->render_status = DJVUPURE_RENDER_STATUS_BGjp;
+	djvupure_allocator_t *allocator;
+	djvupure_chunk_t *jpeg_chunk = 0;
+
+	allocator = djvupurePageImageRendererGetAllocator(ctx);
+
+	if(!is_iw44) {
+		jpeg_chunk = djvupureContainerGetSubchunkBySign(ctx->page, sign, 0, 0);
+		if(!jpeg_chunk) return false;
 	}
 
-	if(ctx->render_status == DJVUPURE_RENDER_STATUS_BGjp) {
-		djvupure_chunk_t *bgjp_chunk;
+	if(!ctx->is_banded && !djvupurePageImageRendererIsTransposed(ctx)) {
+		if(is_iw44)
+			return IW44DecodeRegion(allocator, ctx->page, sign, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, buf);
+		else
+			return JpegDecodeRegion(allocator, jpeg_chunk, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, buf);
+	}
 
-		bgjp_chunk = djvupureContainerGetSubchunkBySign(ctx->page, djvupure_bgjp_sign, 0, 0);
-		if(!bgjp_chunk) {
-			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
+	if(!layer->image) {
+		if(is_iw44) {
+			if(!IW44DecodeImage(allocator, ctx->page, sign, ctx->layer_width, ctx->layer_height, &(layer->image), &(layer->width), &(layer->height))) return false;
+		} else {
+			if(!JpegDecodeImage(allocator, jpeg_chunk, ctx->layer_width, ctx->layer_height, &(layer->image), &(layer->width), &(layer->height))) return false;
+		}
+	}
 
-			return;
+	return ImageResizeRegionEx(allocator, layer->width, layer->height, layer->image, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, (uint8_t *)buf, 3);
+}
+
+// Decodes src_rect of mask, Smmr is used if Sjbz can't be decoded
+// Mask is written as packed bitmap with rows stride bytes apart if is_packed is true, otherwise stride is ignored
+static bool djvupurePageImageRendererDecodeMask(djvupure_image_renderer_ctx_t *ctx, const djvupure_rect_t *src_rect, uint8_t *buf, size_t stride, bool is_packed)
+{
+	djvupure_allocator_t *allocator;
+	djvupure_chunk_t *sjbz_chunk = 0, *smmr_chunk = 0;
+	bool is_decoded = false;
+
+	allocator = djvupurePageImageRendererGetAllocator(ctx);
+
+	if(ctx->count_sjbz) sjbz_chunk = djvupureContainerGetSubchunkBySign(ctx->page, djvupure_sjbz_sign, 0, 0);
+	if(ctx->count_smmr) smmr_chunk = djvupureContainerGetSubchunkBySign(ctx->page, djvupure_smmr_sign, 0, 0);
+
+	if(!ctx->is_banded && !djvupurePageImageRendererIsTransposed(ctx)) {
+		if(sjbz_chunk) {
+			if(is_packed)
+				is_decoded = JB2DecodeRegionBits(allocator, sjbz_chunk, ctx->dict, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, buf, stride);
+			else
+				is_decoded = JB2DecodeRegion(allocator, sjbz_chunk, ctx->dict, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, buf);
 		}
 
-		if(!djvupureBGjpDecode(bgjp_chunk, ctx->info.width, ctx->info.height, image_buffer)) {
-			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
+		if(!is_decoded && smmr_chunk) {
+			if(is_packed)
+				is_decoded = SmmrDecodeRegionBits(allocator, smmr_chunk, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, buf, stride);
+			else
+				is_decoded = SmmrDecodeRegion(allocator, smmr_chunk, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, buf);
+		}
 
-			return;
+		return is_decoded;
+	}
+
+	if(!ctx->mask_bits.bits) {
+		if(sjbz_chunk)
+			is_decoded = JB2DecodeBits(allocator, sjbz_chunk, ctx->dict, &(ctx->mask_bits));
+
+		if(!is_decoded && smmr_chunk)
+			is_decoded = SmmrDecodeBits(allocator, smmr_chunk, &(ctx->mask_bits));
+
+		if(!is_decoded) return false;
+	}
+
+	if(is_packed)
+		return ImageBitsFromBitsRegion(allocator, ctx->mask_bits.bits, ctx->mask_bits.stride, 0, 0, ctx->mask_bits.width, ctx->mask_bits.height, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, buf, stride);
+
+	return ImageMaskFromBitsRegion(allocator, ctx->mask_bits.bits, ctx->mask_bits.stride, 0, 0, ctx->mask_bits.width, ctx->mask_bits.height, ctx->layer_width, ctx->layer_height, src_rect->x, src_rect->y, src_rect->width, src_rect->height, buf);
+}
+
+#define DJVUPURE_RENDER_STRIP_HEIGHT 64
+
+// Decodes rect of layer rotated by page rotation, channels is 1 for mask and 3 for IW44 or JPEG layer
+// Rotation by 90 or 270 degrees is done by strips of src_rect, so unrotated rect is never allocated whole
+static bool djvupurePageImageRendererDecodeLayer(djvupure_image_renderer_ctx_t *ctx, djvupure_image_renderer_layer_t *layer, const uint8_t sign[4], bool is_iw44, uint8_t channels, uint8_t *buf)
+{
+	djvupure_allocator_t *allocator;
+	djvupure_rect_t src_rect, strip_rect;
+	uint8_t *strip;
+	size_t dst_stride;
+	uint16_t y, strip_height;
+	bool result = false;
+
+	allocator = djvupurePageImageRendererGetAllocator(ctx);
+
+	if(!djvupurePageImageRendererIsTransposed(ctx)) {
+		if(channels == 1) {
+			if(!djvupurePageImageRendererDecodeMask(ctx, &(ctx->src_rect), buf, 0, false)) return false;
+		} else {
+			if(!djvupurePageImageRendererDecodeColor(ctx, &(ctx->src_rect), layer, sign, is_iw44, buf)) return false;
 		}
 
-		if(!djvupureImageRotate(ctx->info.width, ctx->info.height, ctx->final_width, ctx->final_height, 3, ctx->info.rotation, (uint8_t *)image_buffer)) {
+		return ImageRotateEx(allocator, ctx->src_rect.width, ctx->src_rect.height, ctx->rect.width, ctx->rect.height, channels, ctx->info.rotation, buf);
+	}
+
+	src_rect = ctx->src_rect;
+	strip_height = src_rect.height < DJVUPURE_RENDER_STRIP_HEIGHT ? src_rect.height : DJVUPURE_RENDER_STRIP_HEIGHT;
+	dst_stride = (size_t)ctx->rect.width*channels;
+
+	strip = djvupurePageImageRendererReserve(ctx, layer?&(layer->strip):&(ctx->mask_strip), (size_t)src_rect.width*strip_height*channels);
+	if(!strip) return false;
+
+	strip_rect = src_rect;
+	for(y = 0; y < src_rect.height; y += strip_height) {
+		uint8_t *dst;
+
+		strip_rect.y = src_rect.y+y;
+		strip_rect.height = src_rect.height-y < strip_height ? src_rect.height-y : strip_height;
+
+		if(channels == 1) {
+			if(!djvupurePageImageRendererDecodeMask(ctx, &strip_rect, strip, 0, false)) goto FINAL;
+		} else {
+			if(!djvupurePageImageRendererDecodeColor(ctx, &strip_rect, layer, sign, is_iw44, strip)) goto FINAL;
+		}
+
+		// Rows of strip are columns of rect
+		if(ctx->info.rotation == 5)
+			dst = buf+(size_t)(src_rect.height-y-strip_rect.height)*channels;
+		else
+			dst = buf+(size_t)y*channels;
+
+		ImageRotateCopy(src_rect.width, strip_rect.height, strip, (size_t)src_rect.width*channels, dst, dst_stride, channels, ctx->info.rotation);
+	}
+
+	result = true;
+
+FINAL:
+	// Without bands layer isn't needed after it is rotated
+	if(!ctx->is_banded) {
+		if(channels == 1) {
+			ImageBitmapFree(allocator, &(ctx->mask_bits));
+		} else {
+			AllocatorFree(allocator, layer->image);
+			layer->image = 0;
+		}
+	}
+
+	return result;
+}
+
+// Same as djvupurePageImageRendererDecodeLayer for mask written as packed bitmap with rows stride bytes apart
+// For 90 degrees the first strip is shorter, so every strip starts at byte of rotated rows
+static bool djvupurePageImageRendererDecodeMaskBits(djvupure_image_renderer_ctx_t *ctx, uint8_t *bits, size_t stride)
+{
+	djvupure_allocator_t *allocator;
+	djvupure_rect_t src_rect, strip_rect;
+	uint8_t *strip;
+	size_t strip_stride;
+	uint16_t y, strip_height;
+	bool result = false;
+
+	allocator = djvupurePageImageRendererGetAllocator(ctx);
+
+	src_rect = ctx->src_rect;
+	strip_stride = ((size_t)src_rect.width+7)/8;
+
+	if(ctx->info.rotation != 2 && !djvupurePageImageRendererIsTransposed(ctx))
+		return djvupurePageImageRendererDecodeMask(ctx, &src_rect, bits, stride, true);
+
+	// Whole rect is decoded, then it's rotated by 180 degrees
+	if(ctx->info.rotation == 2) {
+		strip = djvupurePageImageRendererReserve(ctx, &(ctx->mask_strip), strip_stride*src_rect.height);
+		if(!strip) return false;
+
+		result = djvupurePageImageRendererDecodeMask(ctx, &src_rect, strip, strip_stride, true);
+		if(result) ImageRotateBitsCopy(src_rect.width, src_rect.height, strip, strip_stride, bits, stride, 2);
+
+		return result;
+	}
+
+	strip_height = src_rect.height < DJVUPURE_RENDER_STRIP_HEIGHT ? src_rect.height : DJVUPURE_RENDER_STRIP_HEIGHT;
+
+	strip = djvupurePageImageRendererReserve(ctx, &(ctx->mask_strip), strip_stride*strip_height);
+	if(!strip) return false;
+
+	if(ctx->info.rotation == 5) strip_height = (uint16_t)((src_rect.height-1)%DJVUPURE_RENDER_STRIP_HEIGHT+1);
+
+	strip_rect = src_rect;
+	for(y = 0; y < src_rect.height; y += strip_height, strip_height = DJVUPURE_RENDER_STRIP_HEIGHT) {
+		size_t dst_x;
+
+		strip_rect.y = src_rect.y+y;
+		strip_rect.height = src_rect.height-y < strip_height ? src_rect.height-y : strip_height;
+
+		if(!djvupurePageImageRendererDecodeMask(ctx, &strip_rect, strip, strip_stride, true)) goto FINAL;
+
+		// Rows of strip are columns of rect
+		if(ctx->info.rotation == 5)
+			dst_x = (size_t)src_rect.height-y-strip_rect.height;
+		else
+			dst_x = y;
+
+		ImageRotateBitsCopy(src_rect.width, strip_rect.height, strip, strip_stride, bits+dst_x/8, stride, ctx->info.rotation);
+	}
+
+	result = true;
+
+FINAL:
+	if(!ctx->is_banded) ImageBitmapFree(allocator, &(ctx->mask_bits));
+
+	return result;
+}
+
+static void djvupurePageImageRenderBackground(djvupure_image_renderer_ctx_t *ctx, void *image_buffer)
+{
+	if(ctx->render_status == DJVUPURE_RENDER_STATUS_BG44 || ctx->render_status == DJVUPURE_RENDER_STATUS_BGjp) {
+		bool is_iw44;
+
+		is_iw44 = ctx->render_status == DJVUPURE_RENDER_STATUS_BG44;
+		if(!djvupurePageImageRendererDecodeLayer(ctx, &(ctx->bg), is_iw44?djvupure_bg44_sign:djvupure_bgjp_sign, is_iw44, 3, (uint8_t *)image_buffer)) {
 			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
 			return;
@@ -201,44 +591,24 @@ static void djvupurePageImageRenderBackground(djvupure_image_renderer_ctx_t *ctx
 
 static void djvupurePageImageRenderMask(djvupure_image_renderer_ctx_t *ctx, void *image_buffer)
 {
-	if(ctx->render_status == DJVUPURE_RENDER_STATUS_Sjbz) {
-		// We don't have support for now
-		if(ctx->count_smmr) ctx->render_status = DJVUPURE_RENDER_STATUS_Smmr;
-	}
-
-	if(ctx->render_status == DJVUPURE_RENDER_STATUS_Smmr) {
-		void *smmr_buffer;
-		djvupure_chunk_t *smmr_chunk;
+	if(ctx->render_status == DJVUPURE_RENDER_STATUS_Sjbz || ctx->render_status == DJVUPURE_RENDER_STATUS_Smmr) {
+		bool is_decoded;
 
+		// Mask for foreground is kept packed, page with mask only is rendered as bytes unless packed output is requested
 		if(ctx->is_bg_read) {
-			if(SIZE_MAX/ctx->final_width < ctx->final_height) {
+			if(!djvupurePageImageRendererAllocMask(ctx)) {
 				ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
 				return;
 			}
-			ctx->mask = malloc((size_t)ctx->final_width*(size_t)ctx->final_height);
-			if(!ctx->mask) {
-				ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
-				return;
-			}
-			smmr_buffer = ctx->mask;
-		} else smmr_buffer = image_buffer;
+			is_decoded = djvupurePageImageRendererDecodeMaskBits(ctx, ctx->mask.bits, ctx->mask.stride);
+		} else if(ctx->flags & DJVUPURE_RENDER_FLAG_PACKED_MASK)
+			is_decoded = djvupurePageImageRendererDecodeMaskBits(ctx, (uint8_t *)image_buffer, ((size_t)ctx->rect.width+7)/8);
+		else
+			is_decoded = djvupurePageImageRendererDecodeLayer(ctx, 0, 0, false, 1, (uint8_t *)image_buffer);
 
-		smmr_chunk = djvupureContainerGetSubchunkBySign(ctx->page, djvupure_smmr_sign, 0, 0);
-		if(!smmr_chunk) {
-			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
-
-			return;
-		}
-
-		if(!djvupureSmmrDecode(smmr_chunk, ctx->info.width, ctx->info.height, smmr_buffer)) {
-			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
-
-			return;
-		}
-
-		if(!djvupureImageRotate(ctx->info.width, ctx->info.height, ctx->final_width, ctx->final_height, 1, ctx->info.rotation, (uint8_t *)smmr_buffer)) {
+		if(!is_decoded) {
 			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
 			return;
@@ -250,8 +620,7 @@ static void djvupurePageImageRenderMask(djvupure_image_renderer_ctx_t *ctx, void
 
 			return;
 		} else if(ctx->is_bg_read) {
-			free(ctx->mask);
-			ctx->mask = 0;
+			ctx->mask.bits = 0;
 			ctx->is_bg_read = 0;
 			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
@@ -264,108 +633,315 @@ static void djvupurePageImageRenderMask(djvupure_image_renderer_ctx_t *ctx, void
 	}
 }
 
+// Black pixels of mask are foreground
+static void djvupurePageImageRendererBlend(djvupure_image_renderer_ctx_t *ctx, const uint8_t *fg_buffer, uint8_t *image_buffer)
+{
+	for(size_t row = 0; row < ctx->rect.height; row++) {
+		size_t offset;
+
+		offset = row*ctx->rect.width*3;
+
+		BlendBits(ctx->mask.bits+row*ctx->mask.stride, 0, fg_buffer+offset, image_buffer+offset, ctx->rect.width, 3);
+	}
+}
+
 static void djvupurePageImageRenderForeground(djvupure_image_renderer_ctx_t *ctx, void *image_buffer)
 {
 	if(ctx->render_status == DJVUPURE_RENDER_STATUS_FG44 || ctx->render_status == DJVUPURE_RENDER_STATUS_FGjp) {
 		uint8_t *fg_buffer = 0;
-		bool is_fg_read = false;
+		bool is_iw44;
 
-		if(SIZE_MAX/ctx->final_width < 3) {
+		if(SIZE_MAX/ctx->rect.width < 3) {
 			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
 			return;
 		}
-		if(SIZE_MAX/ctx->final_height*3 < (size_t)ctx->final_width*3) {
+		if(SIZE_MAX/ctx->rect.height*3 < (size_t)ctx->rect.width*3) {
 			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
 			return;
 		}
 
-		fg_buffer = malloc((size_t)ctx->final_width*(size_t)ctx->final_height*3);
+		fg_buffer = djvupurePageImageRendererReserve(ctx, &(ctx->fg_buffer), (size_t)ctx->rect.width*(size_t)ctx->rect.height*3);
 		if(!fg_buffer) {
 			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
 			return;
 		}
 
-		if(!(ctx->mask) || !(ctx->is_bg_read)) {
+		if(!(ctx->mask.bits) || !(ctx->is_bg_read)) {
 			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 
-			return;
+			goto FINAL;
 		}
 
-		if(ctx->render_status == DJVUPURE_RENDER_STATUS_FG44) {
-			// We don't have support for now
-			if(ctx->count_bgjp) ctx->render_status = DJVUPURE_RENDER_STATUS_FGjp;
+		is_iw44 = ctx->render_status == DJVUPURE_RENDER_STATUS_FG44;
+		if(!djvupurePageImageRendererDecodeLayer(ctx, &(ctx->fg), is_iw44?djvupure_fg44_sign:djvupure_fgjp_sign, is_iw44, 3, fg_buffer)) {
+			ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
+
+			goto FINAL;
 		}
-	
-		if(ctx->render_status == DJVUPURE_RENDER_STATUS_FGjp) {
-			djvupure_chunk_t *fgjp_chunk;
 
-			fgjp_chunk = djvupureContainerGetSubchunkBySign(ctx->page, djvupure_fgjp_sign, 0, 0);
-			if(!fgjp_chunk) {
-				ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
+		{ // All is OK. Now creating layered document
+			djvupurePageImageRendererBlend(ctx, fg_buffer, (uint8_t *)image_buffer);
 
-				goto FINAL;
-			}
+			ctx->render_status = DJVUPURE_RENDER_STATUS_LAST;
+		}
 
-			if(!djvupureFGjpDecode(fgjp_chunk, ctx->info.width, ctx->info.height, fg_buffer)) {
-				ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
+	FINAL:
+		ctx->mask.bits = 0;
 
-				goto FINAL;
-			}
+		return;
+	}
+}
 
-			if(!djvupureImageRotate(ctx->info.width, ctx->info.height, ctx->final_width, ctx->final_height, 3, ctx->info.rotation, fg_buffer)) {
-				ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
+// Page has background, mask and foreground
+static bool djvupurePageImageRendererIsCompound(djvupure_image_renderer_ctx_t *ctx)
+{
+	return (ctx->count_bg44 || ctx->count_bgjp) && (ctx->count_sjbz || ctx->count_smmr) && (ctx->count_fg44 || ctx->count_fgjp);
+}
 
-				goto FINAL;
-			}
+// Layer decoded by separate thread
+typedef struct {
+	djvupure_image_renderer_ctx_t *ctx;
+	djvupure_image_renderer_layer_t *layer; // 0 for mask
+	const uint8_t *sign;
+	bool is_iw44;
+	uint8_t *buf;
+	bool result;
+} djvupure_image_renderer_job_t;
+
+static void DJVUPURE_APIENTRY djvupurePageImageRendererRunJob(void *arg)
+{
+	djvupure_image_renderer_job_t *job;
 
-			is_fg_read = true;
-		}
+	job = (djvupure_image_renderer_job_t *)arg;
 
-		if(is_fg_read) { // All is OK. Now creating layered document
-			uint8_t *p_fg, *p_bg, *p_mask;
-			uint16_t x, y, width, height;
-
-			p_fg = fg_buffer;
-			p_bg = (uint8_t *)image_buffer;
-			p_mask = ctx->mask;
-			width = ctx->final_width;
-			height = ctx->final_height;
-
-			for(y = 0; y < height; y++)
-				for(x = 0; x < width; x++) {
-					if(*(p_mask++)) {
-						*(p_bg++) = *(p_fg++);
-						*(p_bg++) = *(p_fg++);
-						*(p_bg++) = *(p_fg++);
-					} else {
-						p_fg += 3;
-						p_bg += 3;
-					}
-				}
+	if(job->layer)
+		job->result = djvupurePageImageRendererDecodeLayer(job->ctx, job->layer, job->sign, job->is_iw44, 3, job->buf);
+	else
+		job->result = djvupurePageImageRendererDecodeMaskBits(job->ctx, job->buf, job->ctx->mask.stride);
+}
 
-			ctx->render_status = DJVUPURE_RENDER_STATUS_LAST;
-		}
+// Background, mask and foreground of compound page are decoded at once by 3 threads, then they are blended
+static void djvupurePageImageRenderLayers(djvupure_image_renderer_ctx_t *ctx, void *image_buffer)
+{
+	djvupure_image_renderer_job_t jobs[3];
+	void *threads[3] = {0, 0, 0};
+	uint8_t *fg_buffer;
+	bool is_bg_iw44, is_fg_iw44;
 
-	FINAL:
-		if(fg_buffer) free(fg_buffer);
-		if(ctx->mask) {
-			free(ctx->mask);
-			ctx->mask = 0;
-		}
+	if(SIZE_MAX/ctx->rect.width/3 < ctx->rect.height) goto FAILURE;
 
-		return;
+	fg_buffer = djvupurePageImageRendererReserve(ctx, &(ctx->fg_buffer), (size_t)ctx->rect.width*(size_t)ctx->rect.height*3);
+	if(!fg_buffer) goto FAILURE;
+
+	if(!djvupurePageImageRendererAllocMask(ctx)) goto FAILURE;
+
+	// Decoding threads must not modify the tree
+	if(!ContainerLoadSubchunks(ctx->page)) goto FAILURE;
+
+	is_bg_iw44 = ctx->render_status == DJVUPURE_RENDER_STATUS_BG44;
+	is_fg_iw44 = ctx->count_fg44 != 0;
+
+	for(size_t i = 0; i < 3; i++) {
+		jobs[i].ctx = ctx;
+		jobs[i].result = false;
 	}
+
+	jobs[0].layer = &(ctx->bg);
+	jobs[0].sign = is_bg_iw44?djvupure_bg44_sign:djvupure_bgjp_sign;
+	jobs[0].is_iw44 = is_bg_iw44;
+	jobs[0].buf = (uint8_t *)image_buffer;
+	jobs[1].layer = 0;
+	jobs[1].buf = ctx->mask.bits;
+	jobs[2].layer = &(ctx->fg);
+	jobs[2].sign = is_fg_iw44?djvupure_fg44_sign:djvupure_fgjp_sign;
+	jobs[2].is_iw44 = is_fg_iw44;
+	jobs[2].buf = fg_buffer;
+
+	// Calling thread decodes background, layers without thread are decoded after it
+	for(size_t i = 1; i < 3; i++)
+		threads[i] = ThreadCreate(djvupurePageImageRendererRunJob, &(jobs[i]));
+
+	for(size_t i = 0; i < 3; i++)
+		if(!threads[i]) djvupurePageImageRendererRunJob(&(jobs[i]));
+
+	for(size_t i = 1; i < 3; i++)
+		if(threads[i]) ThreadJoin(threads[i]);
+
+	if(!jobs[0].result || !jobs[1].result || !jobs[2].result) goto FAILURE;
+
+	djvupurePageImageRendererBlend(ctx, fg_buffer, (uint8_t *)image_buffer);
+
+	ctx->mask.bits = 0;
+
+	ctx->render_status = DJVUPURE_RENDER_STATUS_LAST;
+
+	return;
+
+FAILURE:
+	ctx->mask.bits = 0;
+
+	ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
 }
 
-DJVUPURE_API int DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererNext(void *image_renderer_ctx, void *image_buffer)
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetSize(void *image_renderer_ctx, uint16_t width, uint16_t height)
 {
 	djvupure_image_renderer_ctx_t *ctx;
+	uint16_t layer_width, layer_height;
 
 	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
 
+	if(ctx->is_started) return false;
+
+	if(!width || !height) return false;
+
+	if(ctx->info.rotation == 5 || ctx->info.rotation == 6) {
+		layer_width = height;
+		layer_height = width;
+	} else {
+		layer_width = width;
+		layer_height = height;
+	}
+
+	// Layers can only be reduced
+	if(layer_width > ctx->info.width || layer_height > ctx->info.height) return false;
+
+	ctx->layer_width = layer_width;
+	ctx->layer_height = layer_height;
+	ctx->final_width = width;
+	ctx->final_height = height;
+
+	ctx->rect.x = ctx->rect.y = 0;
+	ctx->rect.width = ctx->final_width;
+	ctx->rect.height = ctx->final_height;
+	ctx->src_rect.x = ctx->src_rect.y = 0;
+	ctx->src_rect.width = ctx->layer_width;
+	ctx->src_rect.height = ctx->layer_height;
+
+	return true;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetReduction(void *image_renderer_ctx, uint8_t factor, uint16_t *width, uint16_t *height)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+	uint16_t reduced_width, reduced_height;
+
+	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
+
+	if(!factor) return false;
+
+	if(ctx->info.rotation == 5 || ctx->info.rotation == 6) {
+		reduced_width = (uint16_t)((ctx->info.height+factor-1)/factor);
+		reduced_height = (uint16_t)((ctx->info.width+factor-1)/factor);
+	} else {
+		reduced_width = (uint16_t)((ctx->info.width+factor-1)/factor);
+		reduced_height = (uint16_t)((ctx->info.height+factor-1)/factor);
+	}
+
+	if(!djvupurePageImageRendererSetSize(image_renderer_ctx, reduced_width, reduced_height)) return false;
+
+	if(width) *width = reduced_width;
+	if(height) *height = reduced_height;
+
+	return true;
+}
+
+// Sets rendered rectangle, it should be inside of page
+static void djvupurePageImageRendererMapRect(djvupure_image_renderer_ctx_t *ctx, const djvupure_rect_t *rect)
+{
+	ctx->rect = *rect;
+
+	// Layers are decoded before rotation, so rectangle is rotated back
+	switch(ctx->info.rotation) {
+		case 5: // 90deg
+			ctx->src_rect.x = rect->y;
+			ctx->src_rect.y = ctx->layer_height-rect->x-rect->width;
+			ctx->src_rect.width = rect->height;
+			ctx->src_rect.height = rect->width;
+			break;
+		case 6: // 270deg
+			ctx->src_rect.x = ctx->layer_width-rect->y-rect->height;
+			ctx->src_rect.y = rect->x;
+			ctx->src_rect.width = rect->height;
+			ctx->src_rect.height = rect->width;
+			break;
+		case 2: // 180deg
+			ctx->src_rect.x = ctx->layer_width-rect->x-rect->width;
+			ctx->src_rect.y = ctx->layer_height-rect->y-rect->height;
+			ctx->src_rect.width = rect->width;
+			ctx->src_rect.height = rect->height;
+			break;
+		case 1: // 0deg
+		default:
+			ctx->src_rect = *rect;
+	}
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetRect(void *image_renderer_ctx, const djvupure_rect_t *rect)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+
+	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
+
+	if(ctx->is_started) return false;
+
+	if(!rect->width || !rect->height) return false;
+	if(rect->x > ctx->final_width-rect->width || rect->y > ctx->final_height-rect->height) return false;
+
+	djvupurePageImageRendererMapRect(ctx, rect);
+
+	return true;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetTile(void *image_renderer_ctx, uint16_t tile_size, uint32_t column, uint32_t row, djvupure_rect_t *rect)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+	djvupure_rect_t tile;
+	uint32_t x, y;
+
+	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
+
+	if(!tile_size) return false;
+	if(column >= UINT16_MAX || row >= UINT16_MAX) return false;
+
+	x = column*tile_size;
+	y = row*tile_size;
+	if(x >= ctx->final_width || y >= ctx->final_height) return false;
+
+	// Tiles on right and bottom edges are clipped
+	tile.x = (uint16_t)x;
+	tile.y = (uint16_t)y;
+	tile.width = (ctx->final_width-x < tile_size)?(uint16_t)(ctx->final_width-x):tile_size;
+	tile.height = (ctx->final_height-y < tile_size)?(uint16_t)(ctx->final_height-y):tile_size;
+
+	if(!djvupurePageImageRendererSetRect(image_renderer_ctx, &tile)) return false;
+
+	if(rect) *rect = tile;
+
+	return true;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererSetFlags(void *image_renderer_ctx, uint32_t flags)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+
+	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
+
+	if(ctx->is_started) return false;
+
+	ctx->flags = flags;
+
+	return true;
+}
+
+static int djvupurePageImageRendererRenderStage(djvupure_image_renderer_ctx_t *ctx, void *image_buffer)
+{
+	if((ctx->flags & DJVUPURE_RENDER_FLAG_PARALLEL_LAYERS) && djvupurePageImageRendererIsCompound(ctx)) {
+		if(ctx->render_status == DJVUPURE_RENDER_STATUS_BG44 || ctx->render_status == DJVUPURE_RENDER_STATUS_BGjp) djvupurePageImageRenderLayers(ctx, image_buffer);
+	}
+
 	if(ctx->render_status == DJVUPURE_RENDER_STATUS_BG44 || ctx->render_status == DJVUPURE_RENDER_STATUS_BGjp) djvupurePageImageRenderBackground(ctx, image_buffer);
 	if(ctx->render_status == DJVUPURE_RENDER_STATUS_Sjbz || ctx->render_status == DJVUPURE_RENDER_STATUS_Smmr) djvupurePageImageRenderMask(ctx, image_buffer);
 	if(ctx->render_status == DJVUPURE_RENDER_STATUS_FG44 || ctx->render_status == DJVUPURE_RENDER_STATUS_FGjp) djvupurePageImageRenderForeground(ctx, image_buffer);
@@ -375,15 +951,98 @@ DJVUPURE_API int DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererNext(void *im
 	return DJVUPURE_IMAGE_RENDERER_NEXT_STAGE;
 }
 
+DJVUPURE_API int DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererNext(void *image_renderer_ctx, void *image_buffer)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+
+	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
+
+	ctx->is_started = true;
+
+	return djvupurePageImageRendererRenderStage(ctx, image_buffer);
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererRenderBands(void *image_renderer_ctx, uint16_t band_height, djvupure_band_sink_t sink, void *sink_ctx)
+{
+	djvupure_image_renderer_ctx_t *ctx;
+	djvupure_allocator_t *allocator;
+	djvupure_rect_t rect, band;
+	uint8_t *band_buffer = 0;
+	size_t row_size;
+	uint8_t channels;
+	int first_status;
+	bool result = false;
+
+	ctx = (djvupure_image_renderer_ctx_t *)image_renderer_ctx;
+	allocator = djvupurePageImageRendererGetAllocator(ctx);
+
+	if(ctx->is_started) return false;
+	if(!band_height || !sink) return false;
+
+	ctx->is_started = true;
+	ctx->is_banded = true;
+
+	rect = ctx->rect;
+	first_status = ctx->render_status;
+	channels = (first_status == DJVUPURE_RENDER_STATUS_BG44 || first_status == DJVUPURE_RENDER_STATUS_BGjp)?3:1;
+	if(band_height > rect.height) band_height = rect.height;
+
+	if(channels == 1 && (ctx->flags & DJVUPURE_RENDER_FLAG_PACKED_MASK))
+		row_size = ((size_t)rect.width+7)/8;
+	else
+		row_size = (size_t)rect.width*channels;
+
+	band_buffer = djvupurePageImageRendererReserve(ctx, &(ctx->band_buffer), row_size*band_height);
+	if(!band_buffer) goto FINAL;
+
+	// Each band is rendered as rectangle, all stages are repeated for it
+	band = rect;
+	for(uint32_t y = 0; y < rect.height; y += band_height) {
+		int status;
+
+		band.y = (uint16_t)(rect.y+y);
+		band.height = (rect.height-y < band_height)?(uint16_t)(rect.height-y):band_height;
+		djvupurePageImageRendererMapRect(ctx, &band);
+
+		ctx->render_status = first_status;
+		ctx->is_bg_read = false;
+
+		do {
+			status = djvupurePageImageRendererRenderStage(ctx, band_buffer);
+		} while(status == DJVUPURE_IMAGE_RENDERER_NEXT_STAGE);
+
+		if(status != DJVUPURE_IMAGE_RENDERER_LAST_STAGE) goto FINAL;
+
+		if(!sink(sink_ctx, (uint16_t)y, band.height, channels, band_buffer)) goto FINAL;
+	}
+
+	result = true;
+
+FINAL:
+	djvupurePageImageRendererFreeLayers(ctx, allocator);
+	if(!result) ctx->render_status = DJVUPURE_RENDER_STATUS_ERROR;
+
+	return result;
+}
+
 DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupurePageImageRendererDestroy(void *image_renderer_ctx)
 {
 	djvupure_image_renderer_ctx_t* ctx;
+	djvupure_allocator_t allocator, *p_allocator;
 
 	if(!image_renderer_ctx) return;
 
 	ctx = (djvupure_image_renderer_ctx_t*)image_renderer_ctx;
+
+	// Context itself is allocated with allocator, so it's copied
+	p_allocator = 0;
+	if(ctx->has_allocator) {
+		allocator = ctx->allocator;
+		p_allocator = &allocator;
+	}
 	
-	if(ctx->mask) free(ctx->mask);
+	djvupurePageImageRendererFreePage(ctx, p_allocator);
+	djvupurePageImageRendererFreeBuffers(ctx, p_allocator);
 
-	free(image_renderer_ctx);
+	AllocatorFree(p_allocator, image_renderer_ctx);
 }
@@ -26,28 +26,84 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "../include/djvupure.h"
+#include "djvupure_read.h"
+#include "djvupure_arena.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+typedef struct {
+	size_t data_len;
+	uint8_t *data; // Points either right after this struct or to the external memory (i.e. file mapping)
+	djvupure_arena_t *arena; // If not 0, chunk is freed with arena
+} djvupure_raw_ctx_t;
+
+typedef struct {
+	djvupure_raw_ctx_t raw; // data is 0 until chunk is loaded
+	djvupure_io_callback_t io;
+	void *fctx;
+	int64_t offset;
+} djvupure_raw_lazy_ctx_t;
+
 static void DJVUPURE_APIENTRY djvupureRawChunkCallbackFree(void *ctx)
 {
 	if(!ctx) return;
+	if(((djvupure_raw_ctx_t *)ctx)->arena) return;
+	
+	free(ctx);
+}
+
+static void DJVUPURE_APIENTRY djvupureRawLazyChunkCallbackFree(void *ctx)
+{
+	djvupure_raw_lazy_ctx_t *lazy_ctx;
+
+	if(!ctx) return;
+
+	lazy_ctx = (djvupure_raw_lazy_ctx_t *)ctx;
+	if(lazy_ctx->raw.arena) return;
+	if(lazy_ctx->raw.data) free(lazy_ctx->raw.data);
 	
 	free(ctx);
 }
 
+static bool djvupureRawLazyChunkLoad(djvupure_raw_lazy_ctx_t *lazy_ctx)
+{
+	uint8_t *data;
+	int64_t pos;
+	bool result = false;
+
+	if(lazy_ctx->raw.data) return true;
+
+	data = ArenaAlloc(lazy_ctx->raw.arena, lazy_ctx->raw.data_len);
+	if(!data) return false;
+
+	pos = lazy_ctx->io.callback_tell(lazy_ctx->fctx);
+	if(pos < 0) goto FINAL;
+
+	if(lazy_ctx->io.callback_seek(lazy_ctx->fctx, lazy_ctx->offset, DJVUPURE_IO_SEEK_SET)) goto FINAL;
+
+	if(lazy_ctx->io.callback_read(lazy_ctx->fctx, data, lazy_ctx->raw.data_len) == lazy_ctx->raw.data_len) result = true;
+
+	if(lazy_ctx->io.callback_seek(lazy_ctx->fctx, pos, DJVUPURE_IO_SEEK_SET)) result = false;
+
+FINAL:
+	if(result)
+		lazy_ctx->raw.data = data;
+	else
+		ArenaFree(lazy_ctx->raw.arena, data);
+
+	return result;
+}
+
 static bool DJVUPURE_APIENTRY djvupureRawChunkCallbackRender(void *ctx, djvupure_io_callback_t *io, void *fctx)
 {
-	uintptr_t uctx;
-	size_t chunk_len;
+	djvupure_raw_ctx_t *raw_ctx;
 	
 	if(!ctx) return false;
 	
-	uctx = (uintptr_t)ctx;
-	chunk_len = *((size_t *)ctx);
+	raw_ctx = (djvupure_raw_ctx_t *)ctx;
 	
-	if(io->callback_write(fctx, (void *)(uctx+sizeof(size_t)), chunk_len) != chunk_len) return false;
+	if(io->callback_write(fctx, raw_ctx->data, raw_ctx->data_len) != raw_ctx->data_len) return false;
 	
 	return true;
 }
@@ -56,55 +112,144 @@ static size_t DJVUPURE_APIENTRY djvupureRawChunkCallbackSize(void *ctx)
 {
 	if(!ctx) return 0;
 
-	return *((size_t*)ctx);
+	return ((djvupure_raw_ctx_t *)ctx)->data_len;
 }
 
-DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureRawChunkCreate(const uint8_t sign[4], void *data, size_t data_len)
+static bool DJVUPURE_APIENTRY djvupureRawLazyChunkCallbackRender(void *ctx, djvupure_io_callback_t *io, void *fctx)
 {
-	djvupure_chunk_t *chunk = 0;
-	uintptr_t uctx;
+	if(!ctx) return false;
+
+	if(!djvupureRawLazyChunkLoad((djvupure_raw_lazy_ctx_t *)ctx)) return false;
 	
-	if(data_len > SIZE_MAX-sizeof(size_t)) return 0;
+	return djvupureRawChunkCallbackRender(ctx, io, fctx);
+}
+
+// Chunks from arena are freed only with arena
+static void djvupureRawChunkDiscard(djvupure_chunk_t *chunk, djvupure_arena_t *arena)
+{
+	if(!arena) djvupureChunkFree(chunk);
+}
+
+static djvupure_chunk_t *djvupureRawChunkAlloc(djvupure_arena_t *arena, size_t data_len, bool inline_data)
+{
+	djvupure_chunk_t *chunk = 0;
+	djvupure_raw_ctx_t *raw_ctx;
+	size_t ctx_size;
+
+	ctx_size = sizeof(djvupure_raw_ctx_t);
+	if(inline_data) {
+		if(data_len > SIZE_MAX-ctx_size) return 0;
+
+		ctx_size += data_len;
+	}
 	
-	chunk = malloc(sizeof(djvupure_chunk_t));
+	chunk = ArenaAlloc(arena, sizeof(djvupure_chunk_t));
 	if(!chunk) return 0;
 	memset(chunk, 0, sizeof(djvupure_chunk_t));
 	chunk->callback_free = djvupureRawChunkCallbackFree;
 	chunk->callback_render = djvupureRawChunkCallbackRender;
 	chunk->callback_size = djvupureRawChunkCallbackSize;
 	chunk->hash = djvupureChunkGetStructHash();
-	chunk->ctx = 0;
-	memcpy(chunk->sign, sign, 4);
-	
-	chunk->ctx = malloc(data_len+sizeof(size_t));
+	chunk->ctx = ArenaAlloc(arena, ctx_size);
 	if(!chunk->ctx) {
-		free(chunk);
+		ArenaFree(arena, chunk);
 		
 		return 0;
 	}
+
+	raw_ctx = (djvupure_raw_ctx_t *)(chunk->ctx);
+	raw_ctx->data_len = data_len;
+	raw_ctx->data = inline_data?(uint8_t *)(raw_ctx+1):0;
+	raw_ctx->arena = arena;
+	
+	return chunk;
+}
+
+DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureRawChunkCreate(const uint8_t sign[4], void *data, size_t data_len)
+{
+	djvupure_chunk_t *chunk;
+	
+	chunk = djvupureRawChunkAlloc(0, data_len, true);
+	if(!chunk) return 0;
+
+	memcpy(chunk->sign, sign, 4);
+	memcpy(((djvupure_raw_ctx_t *)(chunk->ctx))->data, data, data_len);
+	
+	return chunk;
+}
+
+djvupure_chunk_t * DJVUPURE_APIENTRY RawChunkCreateRef(djvupure_arena_t *arena, const uint8_t sign[4], void *data, size_t data_len)
+{
+	djvupure_chunk_t *chunk;
 	
-	uctx = (uintptr_t)(chunk->ctx);
-	*((size_t *)(chunk->ctx)) = data_len;
-	memcpy((void *)(uctx+sizeof(size_t)), data, data_len);
+	chunk = djvupureRawChunkAlloc(arena, data_len, false);
+	if(!chunk) return 0;
+
+	memcpy(chunk->sign, sign, 4);
+	((djvupure_raw_ctx_t *)(chunk->ctx))->data = (uint8_t *)data;
 	
 	return chunk;
 }
 
 DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureRawChunkRead(djvupure_io_callback_t *io, void *fctx)
+{
+	return RawChunkReadEx(io, fctx, 0);
+}
+
+djvupure_chunk_t * DJVUPURE_APIENTRY RawChunkReadEx(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena)
 {
 	djvupure_chunk_t *chunk = 0;
-	uintptr_t uctx;
+	uint8_t sign[4];
 	int64_t chunk_len;
 	uint8_t chunk_len_be4[4];
+
+	if(io->callback_tell(fctx) % 2)
+		if(io->callback_seek(fctx, 1, DJVUPURE_IO_SEEK_CUR)) goto FAILURE;
+	
+	if(io->callback_read(fctx, sign, 4) != 4) goto FAILURE;
+	if(io->callback_read(fctx, chunk_len_be4, 4) != 4) goto FAILURE;
 	
-	chunk = malloc(sizeof(djvupure_chunk_t));
+	chunk_len = (((int64_t)(chunk_len_be4[0]))<<24)+
+		(((int64_t)(chunk_len_be4[1]))<<16)+
+		(((int64_t)(chunk_len_be4[2]))<<8)+
+		chunk_len_be4[3];
+	
+	if(chunk_len > SIZE_MAX-sizeof(djvupure_raw_ctx_t)) goto FAILURE;
+	
+	chunk = djvupureRawChunkAlloc(arena, (size_t)chunk_len, true);
+	if(!chunk) goto FAILURE;
+
+	memcpy(chunk->sign, sign, 4);
+	
+	if(io->callback_read(fctx, ((djvupure_raw_ctx_t *)(chunk->ctx))->data, (size_t)chunk_len) != chunk_len) goto FAILURE;
+
+	return chunk;
+	
+FAILURE:
+	if(chunk) djvupureRawChunkDiscard(chunk, arena);
+	
+	return 0;
+}
+
+djvupure_chunk_t * DJVUPURE_APIENTRY RawChunkReadLazy(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena)
+{
+	djvupure_chunk_t *chunk = 0;
+	djvupure_raw_lazy_ctx_t *lazy_ctx;
+	int64_t chunk_len;
+	uint8_t chunk_len_be4[4];
+
+	chunk = ArenaAlloc(arena, sizeof(djvupure_chunk_t));
 	if(!chunk) return 0;
 	memset(chunk, 0, sizeof(djvupure_chunk_t));
-	chunk->callback_free = djvupureRawChunkCallbackFree;
-	chunk->callback_render = djvupureRawChunkCallbackRender;
+	chunk->callback_free = djvupureRawLazyChunkCallbackFree;
+	chunk->callback_render = djvupureRawLazyChunkCallbackRender;
 	chunk->callback_size = djvupureRawChunkCallbackSize;
 	chunk->hash = djvupureChunkGetStructHash();
-	chunk->ctx = 0;
+	chunk->ctx = ArenaAlloc(arena, sizeof(djvupure_raw_lazy_ctx_t));
+	if(!chunk->ctx) goto FAILURE;
+	memset(chunk->ctx, 0, sizeof(djvupure_raw_lazy_ctx_t));
+	lazy_ctx = (djvupure_raw_lazy_ctx_t *)(chunk->ctx);
+	lazy_ctx->raw.arena = arena;
 
 	if(io->callback_tell(fctx) % 2)
 		if(io->callback_seek(fctx, 1, DJVUPURE_IO_SEEK_CUR)) goto FAILURE;
@@ -117,31 +262,61 @@ DJVUPURE_API djvupure_chunk_t * DJVUPURE_APIENTRY_EXPORT djvupureRawChunkRead(dj
 		(((int64_t)(chunk_len_be4[2]))<<8)+
 		chunk_len_be4[3];
 	
-	if(chunk_len > SIZE_MAX-sizeof(size_t)) goto FAILURE;
-	
-	chunk->ctx = malloc((size_t)(chunk_len+sizeof(size_t)));
-	if(!chunk->ctx) goto FAILURE;
-	
-	uctx = (uintptr_t)(chunk->ctx);
-	*((size_t *)(chunk->ctx)) = (size_t)chunk_len;
+	if(chunk_len > SIZE_MAX) goto FAILURE;
+
+	lazy_ctx->raw.data_len = (size_t)chunk_len;
+	lazy_ctx->io = *io;
+	lazy_ctx->fctx = fctx;
+	lazy_ctx->offset = io->callback_tell(fctx);
+	if(lazy_ctx->offset < 0) goto FAILURE;
 	
-	if(io->callback_read(fctx, (void *)(uctx+sizeof(size_t)), (size_t)chunk_len) != chunk_len) goto FAILURE;
+	// Skip data, it will be read on first djvupureRawChunkGetDataPointer
+	// Last byte is read, so truncated chunk fails here like in RawChunkReadEx
+	if(chunk_len) {
+		uint8_t last_byte;
+
+		if(io->callback_seek(fctx, chunk_len-1, DJVUPURE_IO_SEEK_CUR)) goto FAILURE;
+		if(io->callback_read(fctx, &last_byte, 1) != 1) goto FAILURE;
+	}
 
 	return chunk;
 	
 FAILURE:
-	if(chunk) djvupureChunkFree(chunk);
+	if(chunk) djvupureRawChunkDiscard(chunk, arena);
 	
 	return 0;
 }
 
 DJVUPURE_API void DJVUPURE_APIENTRY_EXPORT djvupureRawChunkGetDataPointer(djvupure_chunk_t *chunk, void **data, size_t *data_len)
 {
+	djvupure_raw_ctx_t *raw_ctx;
+
 	*data = 0;
 	*data_len = 0;
 
 	if(chunk->hash != djvupureChunkGetStructHash()) return;
 
-	*data_len = *((size_t *)(chunk->ctx));
-	*data = (void *)((uintptr_t)(chunk->ctx)+sizeof(size_t));
+	if(chunk->callback_free == djvupureRawLazyChunkCallbackFree) {
+		if(!djvupureRawLazyChunkLoad((djvupure_raw_lazy_ctx_t *)(chunk->ctx))) return;
+	} else if(chunk->callback_free != djvupureRawChunkCallbackFree) return;
+
+	raw_ctx = (djvupure_raw_ctx_t *)(chunk->ctx);
+
+	*data_len = raw_ctx->data_len;
+	*data = raw_ctx->data;
+}
+
+bool DJVUPURE_APIENTRY RawChunkLoad(djvupure_chunk_t *chunk)
+{
+	if(chunk->hash != djvupureChunkGetStructHash()) return false;
+	if(chunk->callback_free != djvupureRawLazyChunkCallbackFree) return true;
+
+	return djvupureRawLazyChunkLoad((djvupure_raw_lazy_ctx_t *)(chunk->ctx));
+}
+
+djvupure_arena_t * DJVUPURE_APIENTRY RawChunkGetArena(djvupure_chunk_t *chunk)
+{
+	if(chunk->callback_free != djvupureRawChunkCallbackFree && chunk->callback_free != djvupureRawLazyChunkCallbackFree) return 0;
+
+	return ((djvupure_raw_ctx_t *)(chunk->ctx))->arena;
 }
\ No newline at end of file
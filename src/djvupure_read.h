@@ -0,0 +1,70 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*Internal module for chunk tree reading*/
+
+#ifndef DJVUPURE_READ_H
+#define DJVUPURE_READ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+#include "djvupure_arena.h"
+
+// If arena is not 0, chunk is allocated from arena and freed with it
+typedef djvupure_chunk_t * (DJVUPURE_APIENTRY * djvupure_raw_chunk_read_t)(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena);
+
+djvupure_chunk_t * DJVUPURE_APIENTRY RawChunkCreateRef(djvupure_arena_t *arena, const uint8_t sign[4], void *data, size_t data_len);
+djvupure_chunk_t * DJVUPURE_APIENTRY RawChunkReadEx(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena);
+djvupure_chunk_t * DJVUPURE_APIENTRY RawChunkReadLazy(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena);
+djvupure_arena_t * DJVUPURE_APIENTRY RawChunkGetArena(djvupure_chunk_t *chunk); // Returns 0 if chunk isn't from arena
+bool DJVUPURE_APIENTRY RawChunkLoad(djvupure_chunk_t *chunk); // Reads data of lazy chunk, true for other chunks
+
+// If lazy is true, subcontainers are read only on first access
+// If is_arena_owner is true, arena is destroyed with container (or on failure)
+djvupure_chunk_t * DJVUPURE_APIENTRY ContainerReadEx(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, bool lazy, djvupure_arena_t *arena, bool is_arena_owner);
+// Reads only FORM header, subchunks should be read with ContainerReadSubchunksEx
+djvupure_chunk_t * DJVUPURE_APIENTRY ContainerReadHeaderEx(djvupure_io_callback_t *io, void *fctx, djvupure_arena_t *arena, bool is_arena_owner, int64_t *chunk_end);
+// Appends subchunks from current position up to chunk_end
+bool DJVUPURE_APIENTRY ContainerReadSubchunksEx(djvupure_chunk_t *container, djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, bool lazy, int64_t chunk_end);
+// Loads data of all subchunks, so renderer reading them from other threads doesn't modify the tree
+// Returns false if container or any of its subchunks can't be read
+bool DJVUPURE_APIENTRY ContainerLoadSubchunks(djvupure_chunk_t *container);
+// Creates lazy container for FORM chunk at offset without reading anything, its header is checked on first access
+djvupure_chunk_t * DJVUPURE_APIENTRY ContainerCreateStub(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, djvupure_arena_t *arena, const uint8_t subsign[4], int64_t offset);
+// flags are DJVUPURE_DOCUMENT_FLAG_*, if allocator is not 0, arena is used
+djvupure_chunk_t * DJVUPURE_APIENTRY DocumentReadEx(djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, uint32_t flags, djvupure_allocator_t *allocator);
+
+// Initializes dir of document which has only header and dir read, other subchunks are created from dir offsets
+bool DJVUPURE_APIENTRY DirInitLazy(djvupure_chunk_t *dir, djvupure_chunk_t *document, djvupure_io_callback_t *io, void *fctx, djvupure_raw_chunk_read_t raw_read, int64_t chunk_end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
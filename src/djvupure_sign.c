@@ -33,6 +33,8 @@ const uint8_t djvupure_form_sign[4] = { 'F', 'O', 'R', 'M' };
 
 const uint8_t djvupure_document_sign[4] = { 'D', 'J', 'V', 'M' };
 const uint8_t djvupure_page_sign[4] = { 'D', 'J', 'V', 'U' };
+const uint8_t djvupure_djvi_sign[4] = { 'D', 'J', 'V', 'I' };
+const uint8_t djvupure_thum_sign[4] = { 'T', 'H', 'U', 'M' };
 
 const uint8_t djvupure_dir_sign[4] = { 'D', 'I', 'R', 'M' };
 
@@ -44,3 +46,6 @@ const uint8_t djvupure_sjbz_sign[4] = { 'S', 'j', 'b', 'z' };
 const uint8_t djvupure_smmr_sign[4] = { 'S', 'm', 'm', 'r' };
 const uint8_t djvupure_fg44_sign[4] = { 'F', 'G', '4', '4' };
 const uint8_t djvupure_fgjp_sign[4] = { 'F', 'G', 'j', 'p' };
+
+const uint8_t djvupure_djbz_sign[4] = { 'D', 'j', 'b', 'z' };
+const uint8_t djvupure_incl_sign[4] = { 'I', 'N', 'C', 'L' };
@@ -41,6 +41,8 @@ extern const uint8_t djvupure_form_sign[4];
 
 extern const uint8_t djvupure_document_sign[4];
 extern const uint8_t djvupure_page_sign[4];
+extern const uint8_t djvupure_djvi_sign[4];
+extern const uint8_t djvupure_thum_sign[4];
 
 extern const uint8_t djvupure_dir_sign[4];
 
@@ -53,6 +55,9 @@ extern const uint8_t djvupure_smmr_sign[4];
 extern const uint8_t djvupure_fg44_sign[4];
 extern const uint8_t djvupure_fgjp_sign[4];
 
+extern const uint8_t djvupure_djbz_sign[4];
+extern const uint8_t djvupure_incl_sign[4];
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,78 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "../include/djvupure.h"
+#include "djvupure_jb2.h"
+#include "djvupure_sign.h"
+
+#include <string.h>
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSjbzCheckSign(const uint8_t sign[4])
+{
+	if(!memcmp(sign, djvupure_sjbz_sign, 4))
+		return true;
+	else
+		return false;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSjbzIs(djvupure_chunk_t *sjbz)
+{
+	if(djvupureChunkGetStructHash() != sjbz->hash) return false;
+	if(!djvupureSjbzCheckSign(sjbz->sign)) return false;
+
+	return true;
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSjbzGetInfo(djvupure_chunk_t *sjbz, uint16_t *width, uint16_t *height)
+{
+	if(!djvupureSjbzIs(sjbz)) return false;
+
+	return JB2GetInfo(sjbz, width, height);
+}
+
+DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSjbzDecode(djvupure_chunk_t *page, djvupure_chunk_t *document, uint16_t width, uint16_t height, void *buf)
+{
+	djvupure_chunk_t *sjbz;
+	djvupure_jb2_dict_t *dict;
+	djvupure_arena_t *arena;
+	bool result = false;
+
+	if(!djvupurePageIs(page)) return false;
+
+	sjbz = djvupureContainerGetSubchunkBySign(page, djvupure_sjbz_sign, 0, 0);
+	if(!sjbz) return false;
+
+	// Page's own dictionary is freed with arena, shared one stays in document
+	arena = ArenaCreate(0);
+	if(!arena) return false;
+
+	if(JB2GetPageDict(arena, page, document, &dict))
+		result = JB2DecodeRegion(0, sjbz, dict, width, height, 0, 0, width, height, buf);
+
+	ArenaDestroy(arena);
+
+	return result;
+}
\ No newline at end of file
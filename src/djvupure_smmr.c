@@ -28,6 +28,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../include/djvupure.h"
 #include "ccitg4mmr/include/ccitg4mmr.h"
 #include "djvupure_sign.h"
+#include "djvupure_smmr.h"
+#include "djvupure_allocator.h"
+#include "djvupure_image.h"
 
 #include <string.h>
 
@@ -84,22 +87,132 @@ DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSmmrGetInfo(djvupure_chunk_t
 }
 
 DJVUPURE_API bool DJVUPURE_APIENTRY_EXPORT djvupureSmmrDecode(djvupure_chunk_t *smmr, uint16_t width, uint16_t height, void *buf)
+{
+	return SmmrDecodeRegion(0, smmr, width, height, 0, 0, width, height, buf);
+}
+
+// Decodes region as mask or as packed bitmap with rows buf_stride bytes apart
+static bool SmmrDecodeRegionTo(djvupure_allocator_t *allocator, djvupure_chunk_t *smmr, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *buf, size_t buf_stride, bool is_packed)
 {
 	void *chunk_data = 0;
 	size_t chunk_data_len = 0;
 	uint16_t mmr_width, mmr_height;
-	uint8_t mmr_flags;
+	mmr_decoder_t mmr;
+	void *lines = 0;
+	uint8_t *bits = 0;
+	bool result = false;
 	
 	if(!djvupureSmmrIs(smmr)) return false;
+
+	if(x > width || region_width > width-x || y > height || region_height > height-y) return false;
 	
 	djvupureRawChunkGetDataPointer(smmr, &chunk_data, &chunk_data_len);
 	if(!chunk_data || !chunk_data_len) return false;
 
-	if(!MMRParseHeader(chunk_data, chunk_data_len, &mmr_width, &mmr_height, &mmr_flags)) return false;
-	
-	if(mmr_width != width || mmr_height != height) return false;
+	if(!MMRParseHeader(chunk_data, chunk_data_len, &mmr_width, &mmr_height, 0)) return false;
 	
-	memset(buf, 255, width*height);
+	if(mmr_width < width || mmr_height < height) return false;
+
+	if(!region_width || !region_height) return true;
+
+	lines = AllocatorAlloc(allocator, mmrGetLinesSize(mmr_width));
+	if(!lines) goto FINAL;
+
+	if(!mmrDecoderInit(&mmr, chunk_data, chunk_data_len, lines)) goto FINAL;
+
+	if(mmr_width == width && mmr_height == height) {
+		// Rows above region are skipped, region is filled with runs directly
+		if(!mmrSkipRows(&mmr, y)) goto FINAL;
+
+		for(size_t row = 0; row < region_height; row++) {
+			if(is_packed) {
+				if(!mmrDecodeRowBits(&mmr, x, region_width, buf+row*buf_stride)) goto FINAL;
+			} else {
+				if(!mmrDecodeRowBytes(&mmr, x, region_width, 0, 255, buf+row*buf_stride)) goto FINAL;
+			}
+		}
+	} else {
+		uint32_t first_col, last_col, first_row, last_row;
+		size_t stride;
+
+		// Covered pixels are decoded into packed bitmap, then it is reduced with area averaging
+		first_col = (uint32_t)x*mmr_width/width;
+		last_col = ((uint32_t)x+region_width)*mmr_width/width;
+		first_row = (uint32_t)y*mmr_height/height;
+		last_row = ((uint32_t)y+region_height)*mmr_height/height;
+		stride = (last_col-first_col+7)/8;
+
+		bits = AllocatorAlloc(allocator, stride*(last_row-first_row));
+		if(!bits) goto FINAL;
+
+		if(!mmrSkipRows(&mmr, first_row)) goto FINAL;
+
+		for(size_t row = 0; row < last_row-first_row; row++)
+			if(!mmrDecodeRowBits(&mmr, first_col, last_col-first_col, bits+row*stride)) goto FINAL;
+
+		if(is_packed) {
+			if(!ImageBitsFromBitsRegion(allocator, bits, stride, first_col, first_row, mmr_width, mmr_height, width, height, x, y, region_width, region_height, buf, buf_stride)) goto FINAL;
+		} else {
+			if(!ImageMaskFromBitsRegion(allocator, bits, stride, first_col, first_row, mmr_width, mmr_height, width, height, x, y, region_width, region_height, buf)) goto FINAL;
+		}
+	}
+
+	result = true;
+
+FINAL:
+	if(lines) AllocatorFree(allocator, lines);
+	if(bits) AllocatorFree(allocator, bits);
 	
-	return true;
+	return result;
+}
+
+bool DJVUPURE_APIENTRY SmmrDecodeRegion(djvupure_allocator_t *allocator, djvupure_chunk_t *smmr, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, void *buf)
+{
+	return SmmrDecodeRegionTo(allocator, smmr, width, height, x, y, region_width, region_height, (uint8_t *)buf, region_width, false);
 }
+
+bool DJVUPURE_APIENTRY SmmrDecodeRegionBits(djvupure_allocator_t *allocator, djvupure_chunk_t *smmr, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *bits, size_t stride)
+{
+	return SmmrDecodeRegionTo(allocator, smmr, width, height, x, y, region_width, region_height, bits, stride, true);
+}
+
+bool DJVUPURE_APIENTRY SmmrDecodeBits(djvupure_allocator_t *allocator, djvupure_chunk_t *smmr, djvupure_bitmap_t *bitmap)
+{
+	void *chunk_data = 0;
+	size_t chunk_data_len = 0;
+	mmr_decoder_t mmr;
+	void *lines = 0;
+	uint8_t *image = 0;
+	size_t image_stride;
+	bool result = false;
+
+	if(!djvupureSmmrIs(smmr)) return false;
+
+	djvupureRawChunkGetDataPointer(smmr, &chunk_data, &chunk_data_len);
+	if(!chunk_data || !chunk_data_len) return false;
+
+	if(!MMRParseHeader(chunk_data, chunk_data_len, &(bitmap->width), &(bitmap->height), 0)) return false;
+
+	image_stride = ((size_t)bitmap->width+7)/8;
+
+	lines = AllocatorAlloc(allocator, mmrGetLinesSize(bitmap->width));
+	image = AllocatorAlloc(allocator, image_stride*bitmap->height);
+	if(!lines || !image) goto FINAL;
+
+	if(!mmrDecoderInit(&mmr, chunk_data, chunk_data_len, lines)) goto FINAL;
+
+	for(size_t row = 0; row < bitmap->height; row++)
+		if(!mmrDecodeRowBits(&mmr, 0, bitmap->width, image+row*image_stride)) goto FINAL;
+
+	bitmap->bits = image;
+	bitmap->stride = image_stride;
+	image = 0;
+
+	result = true;
+
+FINAL:
+	if(lines) AllocatorFree(allocator, lines);
+	if(image) AllocatorFree(allocator, image);
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*Internal module for MMR decoding*/
+
+#ifndef DJVUPURE_SMMR_H
+#define DJVUPURE_SMMR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+#include "djvupure_image.h"
+
+// Decodes only region of mask reduced to width*height, buf holds region_width*region_height pixels
+bool DJVUPURE_APIENTRY SmmrDecodeRegion(djvupure_allocator_t *allocator, djvupure_chunk_t *smmr, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, void *buf);
+// Same as SmmrDecodeRegion, but region is written as packed bitmap with rows stride bytes apart
+bool DJVUPURE_APIENTRY SmmrDecodeRegionBits(djvupure_allocator_t *allocator, djvupure_chunk_t *smmr, uint16_t width, uint16_t height, uint16_t x, uint16_t y, uint16_t region_width, uint16_t region_height, uint8_t *bits, size_t stride);
+// Decodes whole mask at full resolution, bits of bitmap are freed with allocator
+bool DJVUPURE_APIENTRY SmmrDecodeBits(djvupure_allocator_t *allocator, djvupure_chunk_t *smmr, djvupure_bitmap_t *bitmap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
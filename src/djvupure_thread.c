@@ -0,0 +1,184 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "../include/djvupure.h"
+#include "djvupure_thread.h"
+
+#include <stdlib.h>
+
+typedef struct {
+	djvupure_thread_func_t func;
+	void *arg;
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+} djvupure_thread_t;
+
+#ifdef _WIN32
+static unsigned int __stdcall djvupureThreadStart(void *arg)
+#else
+static void *djvupureThreadStart(void *arg)
+#endif
+{
+	djvupure_thread_t *thread;
+
+	thread = (djvupure_thread_t *)arg;
+	thread->func(thread->arg);
+
+	return 0;
+}
+
+void * DJVUPURE_APIENTRY ThreadCreate(djvupure_thread_func_t func, void *arg)
+{
+	djvupure_thread_t *thread;
+
+	thread = malloc(sizeof(djvupure_thread_t));
+	if(!thread) return 0;
+
+	thread->func = func;
+	thread->arg = arg;
+
+#ifdef _WIN32
+	thread->handle = (HANDLE)_beginthreadex(NULL, 0, djvupureThreadStart, thread, 0, NULL);
+	if(!thread->handle) {
+		free(thread);
+
+		return 0;
+	}
+#else
+	if(pthread_create(&(thread->handle), NULL, djvupureThreadStart, thread)) {
+		free(thread);
+
+		return 0;
+	}
+#endif
+
+	return thread;
+}
+
+void DJVUPURE_APIENTRY ThreadJoin(void *thread)
+{
+	djvupure_thread_t *_thread;
+
+	if(!thread) return;
+
+	_thread = (djvupure_thread_t *)thread;
+
+#ifdef _WIN32
+	WaitForSingleObject(_thread->handle, INFINITE);
+	CloseHandle(_thread->handle);
+#else
+	pthread_join(_thread->handle, NULL);
+#endif
+
+	free(thread);
+}
+
+unsigned int DJVUPURE_APIENTRY ThreadGetProcessorsCount(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+	if(info.dwNumberOfProcessors < 1) return 1;
+
+	return (unsigned int)info.dwNumberOfProcessors;
+#else
+	long count;
+
+	count = sysconf(_SC_NPROCESSORS_ONLN);
+	if(count < 1) return 1;
+
+	return (unsigned int)count;
+#endif
+}
+
+void * DJVUPURE_APIENTRY MutexCreate(void)
+{
+#ifdef _WIN32
+	CRITICAL_SECTION *mutex;
+
+	mutex = malloc(sizeof(CRITICAL_SECTION));
+	if(!mutex) return 0;
+
+	InitializeCriticalSection(mutex);
+#else
+	pthread_mutex_t *mutex;
+
+	mutex = malloc(sizeof(pthread_mutex_t));
+	if(!mutex) return 0;
+
+	if(pthread_mutex_init(mutex, NULL)) {
+		free(mutex);
+
+		return 0;
+	}
+#endif
+
+	return mutex;
+}
+
+void DJVUPURE_APIENTRY MutexDestroy(void *mutex)
+{
+	if(!mutex) return;
+
+#ifdef _WIN32
+	DeleteCriticalSection((CRITICAL_SECTION *)mutex);
+#else
+	pthread_mutex_destroy((pthread_mutex_t *)mutex);
+#endif
+
+	free(mutex);
+}
+
+void DJVUPURE_APIENTRY MutexLock(void *mutex)
+{
+#ifdef _WIN32
+	EnterCriticalSection((CRITICAL_SECTION *)mutex);
+#else
+	pthread_mutex_lock((pthread_mutex_t *)mutex);
+#endif
+}
+
+void DJVUPURE_APIENTRY MutexUnlock(void *mutex)
+{
+#ifdef _WIN32
+	LeaveCriticalSection((CRITICAL_SECTION *)mutex);
+#else
+	pthread_mutex_unlock((pthread_mutex_t *)mutex);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*Internal module for threads and mutexes*/
+
+#ifndef DJVUPURE_THREAD_H
+#define DJVUPURE_THREAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+
+typedef void (DJVUPURE_APIENTRY * djvupure_thread_func_t)(void *arg);
+
+void * DJVUPURE_APIENTRY ThreadCreate(djvupure_thread_func_t func, void *arg); // Returns 0 on error
+void DJVUPURE_APIENTRY ThreadJoin(void *thread); // Waits for thread and frees it
+unsigned int DJVUPURE_APIENTRY ThreadGetProcessorsCount(void);
+
+void * DJVUPURE_APIENTRY MutexCreate(void); // Returns 0 on error
+void DJVUPURE_APIENTRY MutexDestroy(void *mutex);
+void DJVUPURE_APIENTRY MutexLock(void *mutex);
+void DJVUPURE_APIENTRY MutexUnlock(void *mutex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,440 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "djvupure_zp.h"
+
+typedef struct {
+	uint16_t p; // LPS interval size
+	uint16_t m; // MPS adaptation threshold
+	uint8_t up; // Next state after MPS
+	uint8_t dn; // Next state after LPS
+} djvupure_zp_state_t;
+
+// Default ZP-coder adaptation table
+static const djvupure_zp_state_t djvupure_zp_table[256] = {
+	{ 0x8000, 0x0000, 84, 145 },
+	{ 0x8000, 0x0000, 3, 4 },
+	{ 0x8000, 0x0000, 4, 3 },
+	{ 0x6bbd, 0x10a5, 5, 1 },
+	{ 0x6bbd, 0x10a5, 6, 2 },
+	{ 0x5d45, 0x1f28, 7, 3 },
+	{ 0x5d45, 0x1f28, 8, 4 },
+	{ 0x51b9, 0x2bd3, 9, 5 },
+	{ 0x51b9, 0x2bd3, 10, 6 },
+	{ 0x4813, 0x36e3, 11, 7 },
+	{ 0x4813, 0x36e3, 12, 8 },
+	{ 0x3fd5, 0x408c, 13, 9 },
+	{ 0x3fd5, 0x408c, 14, 10 },
+	{ 0x38b1, 0x48fd, 15, 11 },
+	{ 0x38b1, 0x48fd, 16, 12 },
+	{ 0x3275, 0x505d, 17, 13 },
+	{ 0x3275, 0x505d, 18, 14 },
+	{ 0x2cfd, 0x56d0, 19, 15 },
+	{ 0x2cfd, 0x56d0, 20, 16 },
+	{ 0x2825, 0x5c71, 21, 17 },
+	{ 0x2825, 0x5c71, 22, 18 },
+	{ 0x23ab, 0x615b, 23, 19 },
+	{ 0x23ab, 0x615b, 24, 20 },
+	{ 0x1f87, 0x65a5, 25, 21 },
+	{ 0x1f87, 0x65a5, 26, 22 },
+	{ 0x1bbb, 0x6962, 27, 23 },
+	{ 0x1bbb, 0x6962, 28, 24 },
+	{ 0x1845, 0x6ca2, 29, 25 },
+	{ 0x1845, 0x6ca2, 30, 26 },
+	{ 0x1523, 0x6f74, 31, 27 },
+	{ 0x1523, 0x6f74, 32, 28 },
+	{ 0x1253, 0x71e6, 33, 29 },
+	{ 0x1253, 0x71e6, 34, 30 },
+	{ 0x0fcf, 0x7404, 35, 31 },
+	{ 0x0fcf, 0x7404, 36, 32 },
+	{ 0x0d95, 0x75d6, 37, 33 },
+	{ 0x0d95, 0x75d6, 38, 34 },
+	{ 0x0b9d, 0x7768, 39, 35 },
+	{ 0x0b9d, 0x7768, 40, 36 },
+	{ 0x09e3, 0x78c2, 41, 37 },
+	{ 0x09e3, 0x78c2, 42, 38 },
+	{ 0x0861, 0x79ea, 43, 39 },
+	{ 0x0861, 0x79ea, 44, 40 },
+	{ 0x0711, 0x7ae7, 45, 41 },
+	{ 0x0711, 0x7ae7, 46, 42 },
+	{ 0x05f1, 0x7bbe, 47, 43 },
+	{ 0x05f1, 0x7bbe, 48, 44 },
+	{ 0x04f9, 0x7c75, 49, 45 },
+	{ 0x04f9, 0x7c75, 50, 46 },
+	{ 0x0425, 0x7d0f, 51, 47 },
+	{ 0x0425, 0x7d0f, 52, 48 },
+	{ 0x0371, 0x7d91, 53, 49 },
+	{ 0x0371, 0x7d91, 54, 50 },
+	{ 0x02d9, 0x7dfe, 55, 51 },
+	{ 0x02d9, 0x7dfe, 56, 52 },
+	{ 0x0259, 0x7e5a, 57, 53 },
+	{ 0x0259, 0x7e5a, 58, 54 },
+	{ 0x01ed, 0x7ea6, 59, 55 },
+	{ 0x01ed, 0x7ea6, 60, 56 },
+	{ 0x0193, 0x7ee6, 61, 57 },
+	{ 0x0193, 0x7ee6, 62, 58 },
+	{ 0x0149, 0x7f1a, 63, 59 },
+	{ 0x0149, 0x7f1a, 64, 60 },
+	{ 0x010b, 0x7f45, 65, 61 },
+	{ 0x010b, 0x7f45, 66, 62 },
+	{ 0x00d5, 0x7f6b, 67, 63 },
+	{ 0x00d5, 0x7f6b, 68, 64 },
+	{ 0x00a5, 0x7f8d, 69, 65 },
+	{ 0x00a5, 0x7f8d, 70, 66 },
+	{ 0x007b, 0x7faa, 71, 67 },
+	{ 0x007b, 0x7faa, 72, 68 },
+	{ 0x0057, 0x7fc3, 73, 69 },
+	{ 0x0057, 0x7fc3, 74, 70 },
+	{ 0x003b, 0x7fd7, 75, 71 },
+	{ 0x003b, 0x7fd7, 76, 72 },
+	{ 0x0023, 0x7fe7, 77, 73 },
+	{ 0x0023, 0x7fe7, 78, 74 },
+	{ 0x0013, 0x7ff2, 79, 75 },
+	{ 0x0013, 0x7ff2, 80, 76 },
+	{ 0x0007, 0x7ffa, 81, 77 },
+	{ 0x0007, 0x7ffa, 82, 78 },
+	{ 0x0001, 0x7fff, 81, 79 },
+	{ 0x0001, 0x7fff, 82, 80 },
+	{ 0x5695, 0x0000, 9, 85 },
+	{ 0x24ee, 0x0000, 86, 226 },
+	{ 0x8000, 0x0000, 5, 6 },
+	{ 0x0d30, 0x0000, 88, 176 },
+	{ 0x481a, 0x0000, 89, 143 },
+	{ 0x0481, 0x0000, 90, 138 },
+	{ 0x3579, 0x0000, 91, 141 },
+	{ 0x017a, 0x0000, 92, 112 },
+	{ 0x24ef, 0x0000, 93, 135 },
+	{ 0x007b, 0x0000, 94, 104 },
+	{ 0x1978, 0x0000, 95, 133 },
+	{ 0x0028, 0x0000, 96, 100 },
+	{ 0x10ca, 0x0000, 97, 129 },
+	{ 0x000d, 0x0000, 82, 98 },
+	{ 0x0b5d, 0x0000, 99, 127 },
+	{ 0x0034, 0x0000, 76, 72 },
+	{ 0x078a, 0x0000, 101, 125 },
+	{ 0x00a0, 0x0000, 70, 102 },
+	{ 0x050f, 0x0000, 103, 123 },
+	{ 0x0117, 0x0000, 66, 60 },
+	{ 0x0358, 0x0000, 105, 121 },
+	{ 0x01ea, 0x0000, 106, 110 },
+	{ 0x0234, 0x0000, 107, 119 },
+	{ 0x0144, 0x0000, 66, 108 },
+	{ 0x0173, 0x0000, 109, 117 },
+	{ 0x0234, 0x0000, 60, 54 },
+	{ 0x00f5, 0x0000, 111, 115 },
+	{ 0x0353, 0x0000, 56, 48 },
+	{ 0x00a1, 0x0000, 69, 113 },
+	{ 0x05c5, 0x0000, 114, 134 },
+	{ 0x011a, 0x0000, 65, 59 },
+	{ 0x03cf, 0x0000, 116, 132 },
+	{ 0x01aa, 0x0000, 61, 55 },
+	{ 0x0285, 0x0000, 118, 130 },
+	{ 0x0286, 0x0000, 57, 51 },
+	{ 0x01ab, 0x0000, 120, 128 },
+	{ 0x03d3, 0x0000, 53, 47 },
+	{ 0x011a, 0x0000, 122, 126 },
+	{ 0x05c5, 0x0000, 49, 41 },
+	{ 0x00ba, 0x0000, 124, 62 },
+	{ 0x08ad, 0x0000, 43, 37 },
+	{ 0x007a, 0x0000, 72, 66 },
+	{ 0x0ccc, 0x0000, 39, 31 },
+	{ 0x01eb, 0x0000, 60, 54 },
+	{ 0x1302, 0x0000, 33, 25 },
+	{ 0x02e6, 0x0000, 56, 50 },
+	{ 0x1b81, 0x0000, 29, 131 },
+	{ 0x045e, 0x0000, 52, 46 },
+	{ 0x24ef, 0x0000, 23, 17 },
+	{ 0x0690, 0x0000, 48, 40 },
+	{ 0x2865, 0x0000, 23, 15 },
+	{ 0x09de, 0x0000, 42, 136 },
+	{ 0x3987, 0x0000, 137, 7 },
+	{ 0x0dc8, 0x0000, 38, 32 },
+	{ 0x2c99, 0x0000, 21, 139 },
+	{ 0x10ca, 0x0000, 140, 172 },
+	{ 0x3b5f, 0x0000, 15, 9 },
+	{ 0x0b5d, 0x0000, 142, 170 },
+	{ 0x5695, 0x0000, 9, 85 },
+	{ 0x078a, 0x0000, 144, 168 },
+	{ 0x8000, 0x0000, 141, 248 },
+	{ 0x050f, 0x0000, 146, 166 },
+	{ 0x24ee, 0x0000, 147, 247 },
+	{ 0x0358, 0x0000, 148, 164 },
+	{ 0x0d30, 0x0000, 149, 197 },
+	{ 0x0234, 0x0000, 150, 162 },
+	{ 0x0481, 0x0000, 151, 95 },
+	{ 0x0173, 0x0000, 152, 160 },
+	{ 0x017a, 0x0000, 153, 173 },
+	{ 0x00f5, 0x0000, 154, 158 },
+	{ 0x007b, 0x0000, 155, 165 },
+	{ 0x00a1, 0x0000, 70, 156 },
+	{ 0x0028, 0x0000, 157, 161 },
+	{ 0x011a, 0x0000, 66, 60 },
+	{ 0x000d, 0x0000, 81, 159 },
+	{ 0x01aa, 0x0000, 62, 56 },
+	{ 0x0034, 0x0000, 75, 71 },
+	{ 0x0286, 0x0000, 58, 52 },
+	{ 0x00a0, 0x0000, 69, 163 },
+	{ 0x03d3, 0x0000, 54, 48 },
+	{ 0x0117, 0x0000, 65, 59 },
+	{ 0x05c5, 0x0000, 50, 42 },
+	{ 0x01ea, 0x0000, 167, 171 },
+	{ 0x08ad, 0x0000, 44, 38 },
+	{ 0x0144, 0x0000, 65, 169 },
+	{ 0x0ccc, 0x0000, 40, 32 },
+	{ 0x0234, 0x0000, 59, 53 },
+	{ 0x1302, 0x0000, 34, 26 },
+	{ 0x0353, 0x0000, 55, 47 },
+	{ 0x1b81, 0x0000, 30, 174 },
+	{ 0x05c5, 0x0000, 175, 193 },
+	{ 0x24ef, 0x0000, 24, 18 },
+	{ 0x03cf, 0x0000, 177, 191 },
+	{ 0x2b74, 0x0000, 178, 222 },
+	{ 0x0285, 0x0000, 179, 189 },
+	{ 0x201d, 0x0000, 180, 218 },
+	{ 0x01ab, 0x0000, 181, 187 },
+	{ 0x1715, 0x0000, 182, 216 },
+	{ 0x011a, 0x0000, 183, 185 },
+	{ 0x0fb7, 0x0000, 184, 214 },
+	{ 0x00ba, 0x0000, 69, 61 },
+	{ 0x0a67, 0x0000, 186, 212 },
+	{ 0x01eb, 0x0000, 59, 53 },
+	{ 0x06e7, 0x0000, 188, 210 },
+	{ 0x02e6, 0x0000, 55, 49 },
+	{ 0x0496, 0x0000, 190, 208 },
+	{ 0x045e, 0x0000, 51, 45 },
+	{ 0x030d, 0x0000, 192, 206 },
+	{ 0x0690, 0x0000, 47, 39 },
+	{ 0x0206, 0x0000, 194, 204 },
+	{ 0x09de, 0x0000, 41, 195 },
+	{ 0x0155, 0x0000, 196, 202 },
+	{ 0x0dc8, 0x0000, 37, 31 },
+	{ 0x00e1, 0x0000, 198, 200 },
+	{ 0x2b74, 0x0000, 199, 243 },
+	{ 0x0094, 0x0000, 72, 64 },
+	{ 0x201d, 0x0000, 201, 239 },
+	{ 0x0188, 0x0000, 62, 56 },
+	{ 0x1715, 0x0000, 203, 237 },
+	{ 0x0252, 0x0000, 58, 52 },
+	{ 0x0fb7, 0x0000, 205, 235 },
+	{ 0x0383, 0x0000, 54, 48 },
+	{ 0x0a67, 0x0000, 207, 233 },
+	{ 0x0547, 0x0000, 50, 44 },
+	{ 0x06e7, 0x0000, 209, 231 },
+	{ 0x07e2, 0x0000, 46, 38 },
+	{ 0x0496, 0x0000, 211, 229 },
+	{ 0x0bc0, 0x0000, 40, 34 },
+	{ 0x030d, 0x0000, 213, 227 },
+	{ 0x1178, 0x0000, 36, 28 },
+	{ 0x0206, 0x0000, 215, 225 },
+	{ 0x19da, 0x0000, 30, 22 },
+	{ 0x0155, 0x0000, 217, 223 },
+	{ 0x24ef, 0x0000, 26, 16 },
+	{ 0x00e1, 0x0000, 219, 221 },
+	{ 0x320e, 0x0000, 20, 220 },
+	{ 0x0094, 0x0000, 71, 63 },
+	{ 0x432a, 0x0000, 14, 8 },
+	{ 0x0188, 0x0000, 61, 55 },
+	{ 0x447d, 0x0000, 14, 224 },
+	{ 0x0252, 0x0000, 57, 51 },
+	{ 0x5ece, 0x0000, 8, 2 },
+	{ 0x0383, 0x0000, 53, 47 },
+	{ 0x8000, 0x0000, 228, 87 },
+	{ 0x0547, 0x0000, 49, 43 },
+	{ 0x481a, 0x0000, 230, 246 },
+	{ 0x07e2, 0x0000, 45, 37 },
+	{ 0x3579, 0x0000, 232, 244 },
+	{ 0x0bc0, 0x0000, 39, 33 },
+	{ 0x24ef, 0x0000, 234, 238 },
+	{ 0x1178, 0x0000, 35, 27 },
+	{ 0x1978, 0x0000, 138, 236 },
+	{ 0x19da, 0x0000, 29, 21 },
+	{ 0x2865, 0x0000, 24, 16 },
+	{ 0x24ef, 0x0000, 25, 15 },
+	{ 0x3987, 0x0000, 240, 8 },
+	{ 0x320e, 0x0000, 19, 241 },
+	{ 0x2c99, 0x0000, 22, 242 },
+	{ 0x432a, 0x0000, 13, 7 },
+	{ 0x3b5f, 0x0000, 16, 10 },
+	{ 0x447d, 0x0000, 13, 245 },
+	{ 0x5695, 0x0000, 10, 2 },
+	{ 0x5ece, 0x0000, 7, 1 },
+	{ 0x8000, 0x0000, 244, 83 },
+	{ 0x8000, 0x0000, 249, 250 },
+	{ 0x5695, 0x0000, 10, 2 },
+	{ 0x481a, 0x0000, 89, 143 },
+	{ 0x481a, 0x0000, 230, 246 },
+	{ 0x0000, 0x0000, 0, 0 },
+	{ 0x0000, 0x0000, 0, 0 },
+	{ 0x0000, 0x0000, 0, 0 },
+	{ 0x0000, 0x0000, 0, 0 },
+	{ 0x0000, 0x0000, 0, 0 }
+};
+
+// Number of leading one bits in byte
+static const uint8_t djvupure_zp_ffzt[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+	4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 7, 8
+};
+
+static void djvupureZPPreload(djvupure_zp_t *zp)
+{
+	while(zp->scount <= 24) {
+		uint8_t byte;
+
+		if(zp->pos < zp->data_len)
+			byte = zp->data[zp->pos++];
+		else {
+			byte = 0xff;
+			if(zp->delay > 0) zp->delay--;
+			else zp->is_overrun = true;
+		}
+
+		zp->buffer = (zp->buffer<<8)|byte;
+		zp->scount += 8;
+	}
+}
+
+static int djvupureZPFfz(uint32_t x)
+{
+	if(x >= 0xff00) return djvupure_zp_ffzt[x&0xff]+8;
+
+	return djvupure_zp_ffzt[(x>>8)&0xff];
+}
+
+static void djvupureZPSetFence(djvupure_zp_t *zp)
+{
+	zp->fence = zp->code;
+	if(zp->code >= 0x8000) zp->fence = 0x7fff;
+}
+
+void DJVUPURE_APIENTRY ZPInit(djvupure_zp_t *zp, const void *data, size_t data_len)
+{
+	zp->data = (const uint8_t *)data;
+	zp->data_len = data_len;
+	zp->pos = 0;
+	zp->a = 0;
+	zp->buffer = 0;
+	zp->scount = 0;
+	zp->delay = 25;
+	zp->is_overrun = false;
+
+	zp->code = (zp->pos < data_len)?(zp->data[zp->pos++]<<8):0xff00;
+	zp->code |= (zp->pos < data_len)?zp->data[zp->pos++]:0xff;
+
+	djvupureZPPreload(zp);
+	djvupureZPSetFence(zp);
+}
+
+static int djvupureZPDecodeLps(djvupure_zp_t *zp, uint32_t z)
+{
+	int shift;
+
+	z = 0x10000-z;
+	zp->a += z;
+	zp->code += z;
+
+	shift = djvupureZPFfz(zp->a);
+	zp->scount -= shift;
+	zp->a = (zp->a<<shift)&0xffff;
+	zp->code = ((zp->code<<shift)&0xffff)|((zp->buffer>>zp->scount)&((1<<shift)-1));
+	if(zp->scount < 16) djvupureZPPreload(zp);
+	djvupureZPSetFence(zp);
+
+	return 1;
+}
+
+static int djvupureZPDecodeMps(djvupure_zp_t *zp, uint32_t z)
+{
+	zp->scount--;
+	zp->a = (z<<1)&0xffff;
+	zp->code = ((zp->code<<1)&0xffff)|((zp->buffer>>zp->scount)&1);
+	if(zp->scount < 16) djvupureZPPreload(zp);
+	djvupureZPSetFence(zp);
+
+	return 0;
+}
+
+int DJVUPURE_APIENTRY ZPDecode(djvupure_zp_t *zp, djvupure_zp_context_t *ctx)
+{
+	uint32_t z, d;
+	int bit;
+
+	bit = *ctx&1;
+
+	z = zp->a+djvupure_zp_table[*ctx].p;
+	if(z <= zp->fence) {
+		zp->a = z;
+
+		return bit;
+	}
+
+	// Avoid interval reversion
+	d = 0x6000+((z+zp->a)>>2);
+	if(z > d) z = d;
+
+	if(z > zp->code) {
+		*ctx = djvupure_zp_table[*ctx].dn;
+
+		return bit^djvupureZPDecodeLps(zp, z);
+	} else {
+		if(zp->a >= djvupure_zp_table[*ctx].m) *ctx = djvupure_zp_table[*ctx].up;
+
+		return bit^djvupureZPDecodeMps(zp, z);
+	}
+}
+
+static int djvupureZPDecodeSimple(djvupure_zp_t *zp, uint32_t z)
+{
+	if(z > zp->code)
+		return djvupureZPDecodeLps(zp, z);
+	else
+		return djvupureZPDecodeMps(zp, z);
+}
+
+int DJVUPURE_APIENTRY ZPDecodePassthrough(djvupure_zp_t *zp)
+{
+	return djvupureZPDecodeSimple(zp, 0x8000+(zp->a>>1));
+}
+
+int DJVUPURE_APIENTRY ZPDecodePassthroughIW(djvupure_zp_t *zp)
+{
+	return djvupureZPDecodeSimple(zp, 0x8000+((zp->a*3)>>3));
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+/*
+BSD 2-Clause License
+
+Copyright (c) 2023, Mikhail Morozov
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+/*Internal module for ZP-coder decoding*/
+
+#ifndef DJVUPURE_ZP_H
+#define DJVUPURE_ZP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/djvupure.h"
+
+// Adaptive probability state, must be zeroed before decoding
+typedef uint8_t djvupure_zp_context_t;
+
+typedef struct {
+	const uint8_t *data;
+	size_t data_len;
+	size_t pos;
+	uint32_t a;
+	uint32_t code;
+	uint32_t fence;
+	uint32_t buffer;
+	int scount;
+	int delay;
+	bool is_overrun; // Set if decoder has read too far beyond end of data
+} djvupure_zp_t;
+
+void DJVUPURE_APIENTRY ZPInit(djvupure_zp_t *zp, const void *data, size_t data_len);
+int DJVUPURE_APIENTRY ZPDecode(djvupure_zp_t *zp, djvupure_zp_context_t *ctx);
+int DJVUPURE_APIENTRY ZPDecodePassthrough(djvupure_zp_t *zp);
+int DJVUPURE_APIENTRY ZPDecodePassthroughIW(djvupure_zp_t *zp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -418,6 +418,10 @@ typedef struct
 //
 
 STBIDEF stbi_uc *stbi_load_from_memory   (stbi_uc           const *buffer, int len   , int *x, int *y, int *channels_in_file, int desired_channels);
+#ifndef STBI_NO_JPEG
+// djvupure: decodes jpeg reduced by 1 << scale_shift (scale_shift is 0..3) to width x height 3 channel output with rows stride bytes apart, no image buffer is allocated
+STBIDEF int      stbi_load_jpeg_into_from_memory(stbi_uc const *buffer, int len, int scale_shift, int width, int height, stbi_uc *output, size_t stride);
+#endif
 STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk  , void *user, int *x, int *y, int *channels_in_file, int desired_channels);
 
 #ifndef STBI_NO_STDIO
@@ -1954,6 +1958,7 @@ typedef struct
       stbi_uc *linebuf;
       short   *coeff;   // progressive only
       int      coeff_w, coeff_h; // number of 8x8 coefficient blocks
+      int      shift; // djvupure: blocks are reduced to (8 >> shift) pixels by idct
    } img_comp[4];
 
    stbi__uint32   code_buffer; // jpeg entropy-coded buffer
@@ -1978,6 +1983,13 @@ typedef struct
    void (*idct_block_kernel)(stbi_uc *out, int out_stride, short data[64]);
    void (*YCbCr_to_RGB_kernel)(stbi_uc *out, const stbi_uc *y, const stbi_uc *pcb, const stbi_uc *pcr, int count, int step);
    stbi_uc *(*resample_row_hv_2_kernel)(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs);
+
+// djvupure: caller's output buffer, 0 if output is allocated
+   stbi_uc *out_buffer;
+   size_t out_stride;
+   stbi__uint32 out_width, out_height;
+// djvupure: image is reduced by 1 << scale_shift
+   int scale_shift;
 } stbi__jpeg;
 
 static int stbi__build_huffman(stbi__huffman *h, int *count)
@@ -2489,6 +2501,56 @@ static void stbi__idct_block(stbi_uc *out, int out_stride, short data[64])
    }
 }
 
+// djvupure: reduced idct, n x n block (n is 4, 2 or 1) is the full idct averaged over (8/n) x (8/n) pixels,
+// so image is reduced as by box filter without computing all pixels
+static const int stbi__idct_reduced_4[32] = { // [x*8+u], C(u)/2 * average of cos((2i+1)*u*pi/16) for i in 2x..2x+1, * 4096
+   1448,  1856,  1338,   652,     0,  -435,  -554,  -369,
+   1448,   769, -1338, -1573,     0,  1051,   554,  -153,
+   1448,  -769, -1338,  1573,     0, -1051,   554,   153,
+   1448, -1856,  1338,  -652,     0,   435,  -554,   369
+};
+static const int stbi__idct_reduced_2[16] = { // same for i in 4x..4x+3
+   1448,  1312,     0,  -461,     0,   308,     0,  -261,
+   1448, -1312,     0,   461,     0,  -308,     0,   261
+};
+
+static void stbi__idct_block_reduced(stbi_uc *out, int out_stride, short data[64], int n)
+{
+   int i,j,k,val[32];
+   const int *t = n == 4 ? stbi__idct_reduced_4 : stbi__idct_reduced_2;
+
+   // average of all pixels of block is its dc
+   if (n == 1) {
+      out[0] = stbi__clamp(((data[0] + 4) >> 3) + 128);
+      return;
+   }
+
+   // rows, 2 extra bits of precision are kept; sums of weights are below 1.7, so it doesn't overflow
+   for (j=0; j < 8; ++j) {
+      const short *d = data + j*8;
+      if (d[0]==0 && d[1]==0 && d[2]==0 && d[3]==0 && d[4]==0 && d[5]==0 && d[6]==0 && d[7]==0) {
+         for (i=0; i < n; ++i)
+            val[j*n+i] = 0;
+         continue;
+      }
+      for (i=0; i < n; ++i) {
+         int sum = 512;
+         for (k=0; k < 8; ++k)
+            sum += t[i*8+k] * d[k];
+         val[j*n+i] = sum >> 10;
+      }
+   }
+
+   // columns
+   for (j=0; j < n; ++j, out += out_stride)
+      for (i=0; i < n; ++i) {
+         int sum = 1 << 13;
+         for (k=0; k < 8; ++k)
+            sum += t[j*8+k] * val[k*n+i];
+         out[i] = stbi__clamp((sum >> 14) + 128);
+      }
+}
+
 #ifdef STBI_SSE2
 // sse2 integer IDCT. not the fastest possible implementation but it
 // produces bit-identical results to the generic C version so it's
@@ -2912,6 +2974,28 @@ static void stbi__jpeg_reset(stbi__jpeg *j)
    // since we don't even allow 1<<30 pixels
 }
 
+// djvupure: idct of block at (x, y) pixels of full size component
+static void stbi__jpeg_idct(stbi__jpeg *z, int n, int x, int y, short data[64])
+{
+   int shift = z->img_comp[n].shift, stride = z->img_comp[n].w2 >> shift;
+   stbi_uc *out = z->img_comp[n].data + stride*(y >> shift) + (x >> shift);
+
+   if (shift == 1) {
+      // full simd idct with averaging is faster than reduced one for halving
+      STBI_SIMD_ALIGN(stbi_uc, pixels[64]);
+      int i,j;
+      z->idct_block_kernel(pixels, 8, data);
+      for (j=0; j < 4; ++j, out += stride)
+         for (i=0; i < 4; ++i) {
+            const stbi_uc *p = pixels + j*16 + i*2;
+            out[i] = (stbi_uc) ((p[0] + p[1] + p[8] + p[9] + 2) >> 2);
+         }
+   } else if (shift)
+      stbi__idct_block_reduced(out, stride, data, 8 >> shift);
+   else
+      z->idct_block_kernel(out, stride, data);
+}
+
 static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
 {
    stbi__jpeg_reset(z);
@@ -2930,7 +3014,7 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                int ha = z->img_comp[n].ha;
                if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               stbi__jpeg_idct(z, n, i*8, j*8, data);
                // every data block is an MCU, so countdown the restart interval
                if (--z->todo <= 0) {
                   if (z->code_bits < 24) stbi__grow_buffer_unsafe(z);
@@ -2958,7 +3042,7 @@ static int stbi__parse_entropy_coded_data(stbi__jpeg *z)
                         int y2 = (j*z->img_comp[n].v + y)*8;
                         int ha = z->img_comp[n].ha;
                         if (!stbi__jpeg_decode_block(z, data, z->huff_dc+z->img_comp[n].hd, z->huff_ac+ha, z->fast_ac[ha], n, z->dequant[z->img_comp[n].tq])) return 0;
-                        z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*y2+x2, z->img_comp[n].w2, data);
+                        stbi__jpeg_idct(z, n, x2, y2, data);
                      }
                   }
                }
@@ -3055,7 +3139,7 @@ static void stbi__jpeg_finish(stbi__jpeg *z)
             for (i=0; i < w; ++i) {
                short *data = z->img_comp[n].coeff + 64 * (i + j * z->img_comp[n].coeff_w);
                stbi__jpeg_dequantize(data, z->dequant[z->img_comp[n].tq]);
-               z->idct_block_kernel(z->img_comp[n].data+z->img_comp[n].w2*j*8+i*8, z->img_comp[n].w2, data);
+               stbi__jpeg_idct(z, n, i*8, j*8, data);
             }
          }
       }
@@ -3299,7 +3383,17 @@ static int stbi__process_frame_header(stbi__jpeg *z, int scan)
       z->img_comp[i].coeff = 0;
       z->img_comp[i].raw_coeff = 0;
       z->img_comp[i].linebuf = NULL;
-      z->img_comp[i].raw_data = stbi__malloc_mad2(z->img_comp[i].w2, z->img_comp[i].h2, 15);
+      // djvupure: subsampled components are reduced less, so they aren't upsampled more than needed;
+      // with uneven subsampling all components are reduced alike
+      z->img_comp[i].shift = z->scale_shift;
+      {
+         int hs = h_max / z->img_comp[i].h, vs = v_max / z->img_comp[i].v, m = hs < vs ? hs : vs, l = 0;
+         if (!(hs & (hs-1)) && !(vs & (vs-1))) {
+            while ((1 << l) < m) ++l;
+            z->img_comp[i].shift = z->scale_shift > l ? z->scale_shift - l : 0;
+         }
+      }
+      z->img_comp[i].raw_data = stbi__malloc_mad2(z->img_comp[i].w2 >> z->img_comp[i].shift, z->img_comp[i].h2 >> z->img_comp[i].shift, 15);
       if (z->img_comp[i].raw_data == NULL)
          return stbi__free_jpeg_components(z, i+1, stbi__err("outofmem", "Out of memory"));
       // align blocks for idct using mmx/sse
@@ -3623,7 +3717,7 @@ static void stbi__YCbCr_to_RGB_row(stbi_uc *out, const stbi_uc *y, const stbi_uc
       out[0] = (stbi_uc)r;
       out[1] = (stbi_uc)g;
       out[2] = (stbi_uc)b;
-      out[3] = 255;
+      if (step == 4) out[3] = 255; // djvupure: don't write past the row
       out += step;
    }
 }
@@ -3757,7 +3851,7 @@ static void stbi__YCbCr_to_RGB_simd(stbi_uc *out, stbi_uc const *y, stbi_uc cons
       out[0] = (stbi_uc)r;
       out[1] = (stbi_uc)g;
       out[2] = (stbi_uc)b;
-      out[3] = 255;
+      if (step == 4) out[3] = 255; // djvupure: don't write past the row
       out += step;
    }
 }
@@ -3769,6 +3863,8 @@ static void stbi__setup_jpeg(stbi__jpeg *j)
    j->idct_block_kernel = stbi__idct_block;
    j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_row;
    j->resample_row_hv_2_kernel = stbi__resample_row_hv_2;
+   j->out_buffer = NULL;
+   j->scale_shift = 0;
 
 #ifdef STBI_SSE2
    if (stbi__sse2_available()) {
@@ -3819,6 +3915,20 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
    // load a jpeg image from whichever source, but leave in YCbCr format
    if (!stbi__decode_jpeg_image(z)) { stbi__cleanup_jpeg(z); return NULL; }
 
+   // djvupure: components were decoded reduced, so image is processed further at reduced size
+   if (z->scale_shift) {
+      int shift = z->scale_shift;
+      z->s->img_x = (z->s->img_x + (1 << shift) - 1) >> shift;
+      z->s->img_y = (z->s->img_y + (1 << shift) - 1) >> shift;
+      for (n=0; n < z->s->img_n; ++n) {
+         shift = z->img_comp[n].shift;
+         z->img_comp[n].x = (z->img_comp[n].x + (1 << shift) - 1) >> shift;
+         z->img_comp[n].y = (z->img_comp[n].y + (1 << shift) - 1) >> shift;
+         z->img_comp[n].w2 >>= shift;
+         z->img_comp[n].h2 >>= shift;
+      }
+   }
+
    // determine actual number of components to generate
    n = req_comp ? req_comp : z->s->img_n >= 3 ? 3 : 1;
 
@@ -3852,6 +3962,9 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
 
          r->hs      = z->img_h_max / z->img_comp[k].h;
          r->vs      = z->img_v_max / z->img_comp[k].v;
+         // djvupure: upsampling of reduced component
+         r->hs      = (r->hs << z->img_comp[k].shift) >> z->scale_shift;
+         r->vs      = (r->vs << z->img_comp[k].shift) >> z->scale_shift;
          r->ystep   = r->vs >> 1;
          r->w_lores = (z->s->img_x + r->hs-1) / r->hs;
          r->ypos    = 0;
@@ -3865,12 +3978,17 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
       }
 
       // can't error after this so, this is safe
-      output = (stbi_uc *) stbi__malloc_mad3(n, z->s->img_x, z->s->img_y, 1);
-      if (!output) { stbi__cleanup_jpeg(z); return stbi__errpuc("outofmem", "Out of memory"); }
+      if (z->out_buffer) { // djvupure: output goes to caller's buffer
+         if (z->s->img_x != z->out_width || z->s->img_y != z->out_height || n != 3) { stbi__cleanup_jpeg(z); return stbi__errpuc("bad size", "Output size doesn't match image"); }
+         output = z->out_buffer;
+      } else {
+         output = (stbi_uc *) stbi__malloc_mad3(n, z->s->img_x, z->s->img_y, 1);
+         if (!output) { stbi__cleanup_jpeg(z); return stbi__errpuc("outofmem", "Out of memory"); }
+      }
 
       // now go ahead and resample
       for (j=0; j < z->s->img_y; ++j) {
-         stbi_uc *out = output + n * z->s->img_x * j;
+         stbi_uc *out = z->out_buffer ? output + z->out_stride * j : output + n * z->s->img_x * j;
          for (k=0; k < decode_n; ++k) {
             stbi__resample *r = &res_comp[k];
             int y_bot = r->ystep >= (r->vs >> 1);
@@ -3893,7 +4011,7 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
                      out[0] = y[i];
                      out[1] = coutput[1][i];
                      out[2] = coutput[2][i];
-                     out[3] = 255;
+                     if (n == 4) out[3] = 255; // djvupure: don't write past the row
                      out += n;
                   }
                } else {
@@ -3906,7 +4024,7 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
                      out[0] = stbi__blinn_8x8(coutput[0][i], m);
                      out[1] = stbi__blinn_8x8(coutput[1][i], m);
                      out[2] = stbi__blinn_8x8(coutput[2][i], m);
-                     out[3] = 255;
+                     if (n == 4) out[3] = 255; // djvupure: don't write past the row
                      out += n;
                   }
                } else if (z->app14_color_transform == 2) { // YCCK
@@ -3924,7 +4042,7 @@ static stbi_uc *load_jpeg_image(stbi__jpeg *z, int *out_x, int *out_y, int *comp
             } else
                for (i=0; i < z->s->img_x; ++i) {
                   out[0] = out[1] = out[2] = y[i];
-                  out[3] = 255; // not used if n==3
+                  if (n == 4) out[3] = 255; // djvupure: don't write past the row
                   out += n;
                }
          } else {
@@ -3984,6 +4102,29 @@ static void *stbi__jpeg_load(stbi__context *s, int *x, int *y, int *comp, int re
    return result;
 }
 
+// djvupure: same as stbi__jpeg_load, but output is written to caller's buffer
+STBIDEF int stbi_load_jpeg_into_from_memory(stbi_uc const *buffer, int len, int scale_shift, int width, int height, stbi_uc *output, size_t stride)
+{
+   stbi__context s;
+   stbi__jpeg *j;
+   stbi_uc *result;
+   int x, y, comp;
+   stbi__start_mem(&s,buffer,len);
+   j = (stbi__jpeg *) stbi__malloc(sizeof(stbi__jpeg));
+   if (!j) return stbi__err("outofmem", "Out of memory");
+   j->s = &s;
+   if (scale_shift < 0 || scale_shift > 3) { STBI_FREE(j); return stbi__err("bad scale", "Internal error"); }
+   stbi__setup_jpeg(j);
+   j->scale_shift = scale_shift;
+   j->out_buffer = output;
+   j->out_stride = stride;
+   j->out_width = (stbi__uint32) width;
+   j->out_height = (stbi__uint32) height;
+   result = load_jpeg_image(j, &x, &y, &comp, 3);
+   STBI_FREE(j);
+   return result != NULL;
+}
+
 static int stbi__jpeg_test(stbi__context *s)
 {
    int r;
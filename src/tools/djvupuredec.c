@@ -35,23 +35,38 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wchar.h>
 #include <locale.h>
 
 bool RenderPageToFile(djvupure_chunk_t *page, djvupure_chunk_t *document, int format, wchar_t *fname);
+bool RenderPageToFileByBands(djvupure_chunk_t *page, djvupure_chunk_t *document, int format, uint16_t band_height, wchar_t *fname);
+bool DJVUPURE_APIENTRY SaveBandToFile(void *sink_ctx, uint16_t y, uint16_t nof_rows, uint8_t channels, void *band_buffer);
+bool SaveImageToFile(uint16_t image_width, uint16_t image_height, uint8_t image_channels, void *image_buffer, int format, wchar_t *fname);
+bool DJVUPURE_APIENTRY SavePageToFile(void *sink_ctx, size_t index, uint16_t width, uint16_t height, uint8_t channels, void *image_buffer);
 
 enum {
 	DJVUPUREDEC_FORMAT_PNM
 };
 
+typedef struct {
+	int format;
+	wchar_t *fname;
+} djvupuredec_sink_t;
+
+typedef struct {
+	FILE *f;
+	uint16_t width;
+} djvupuredec_band_sink_t;
+
 int wmain(int argc, wchar_t **argv)
 {
-	djvupure_io_callback_t io;
 	djvupure_chunk_t *document = 0, *page;
-	size_t index = 0;
-	void *fctx = 0;
+	size_t index = 0, last_index = 0;
+	void *fmap = 0;
 	int format = DJVUPUREDEC_FORMAT_PNM;
-	int result = EXIT_FAILURE, arg_start = 2;
+	int result = EXIT_FAILURE, arg_start = 2, nof_threads = 0, band_height = 0;
+	bool is_batch = false;
 
 	setlocale(LC_CTYPE, "");
 
@@ -64,9 +79,12 @@ int wmain(int argc, wchar_t **argv)
 		_command = wcsrchr(command, '/');
 		if(_command) command = _command+1;
 
-		wprintf(L"%ls -format=fmt [-page=pagenum] document.djvu output.fmt\n"
+		wprintf(L"%ls -format=fmt [-page=pagenum | -pages=first-last] [-threads=num] [-band=rows] document.djvu output.fmt\n"
 			L"\tfmt is a file format. The only file format supported is pnm\n"
-			L"\tpagenum is a single page number. Default is 1\n",
+			L"\tpagenum is a single page number. Default is 1\n"
+			L"\tfirst-last is a range of pages, page number is added to output file name\n"
+			L"\tnum is a number of threads for range of pages. Default is number of processors\n"
+			L"\trows is a number of rows rendered at once for single page, it limits memory usage\n",
 			command);
 
 		return EXIT_SUCCESS;
@@ -86,9 +104,34 @@ int wmain(int argc, wchar_t **argv)
 		return EXIT_FAILURE;
 	}
 
-	if(!wcsncmp(argv[2], L"-page=", 6)) {
-		index = _wtoi(argv[1]+6)-1;
-		arg_start++;
+	for(; arg_start < argc && argv[arg_start][0] == L'-'; arg_start++) {
+		if(!wcsncmp(argv[arg_start], L"-page=", 6)) {
+			index = _wtoi(argv[arg_start]+6)-1;
+		} else if(!wcsncmp(argv[arg_start], L"-pages=", 7)) {
+			wchar_t *last;
+
+			last = wcschr(argv[arg_start]+7, L'-');
+			if(!last || _wtoi(argv[arg_start]+7) < 1 || _wtoi(last+1) < _wtoi(argv[arg_start]+7)) {
+				wprintf(L"Error: wrong range of pages\n");
+
+				return EXIT_FAILURE;
+			}
+
+			index = _wtoi(argv[arg_start]+7)-1;
+			last_index = _wtoi(last+1)-1;
+			is_batch = true;
+		} else if(!wcsncmp(argv[arg_start], L"-threads=", 9)) {
+			nof_threads = _wtoi(argv[arg_start]+9);
+			if(nof_threads < 0) nof_threads = 0;
+		} else if(!wcsncmp(argv[arg_start], L"-band=", 6)) {
+			band_height = _wtoi(argv[arg_start]+6);
+			if(band_height < 1 || band_height > UINT16_MAX) {
+				wprintf(L"Error: wrong number of rows in band\n");
+
+				return EXIT_FAILURE;
+			}
+		} else
+			break;
 	}
 
 	if(argc-arg_start < 2) {
@@ -97,20 +140,36 @@ int wmain(int argc, wchar_t **argv)
 		return EXIT_FAILURE;
 	}
 
-	djvupureFileSetIoCallbacks(&io);
-	
-	fctx = djvupureFileOpenW(argv[arg_start], false);
-	if(!fctx) goto FINAL;
+	fmap = djvupureFileMapW(argv[arg_start]);
+	if(!fmap) goto FINAL;
 	
-	document = djvupureDocumentRead(&io, fctx);
-	djvupureFileClose(fctx);
-	fctx = 0;
+	document = djvupureDocumentMap(fmap);
 	if(!document) goto FINAL;
+
+	if(is_batch) {
+		djvupuredec_sink_t sink;
+
+		sink.format = format;
+		sink.fname = argv[arg_start+1];
+
+		if(!djvupureDocumentRenderPagesWithFlags(document, index, last_index-index+1, SavePageToFile, &sink, (unsigned int)nof_threads, 0, djvupureFileOpenU8, djvupureFileClose, DJVUPURE_RENDER_FLAG_PACKED_MASK)) {
+			wprintf(L"Can't decode pages to files\n");
+
+			goto FINAL;
+		}
+
+		result = EXIT_SUCCESS;
+
+		goto FINAL;
+	}
 	
 	page = djvupureDocumentGetPage(document, index, djvupureFileOpenU8, djvupureFileClose);
 	if(!page) goto FINAL;
 	
-	if(!RenderPageToFile(page, document, format, argv[arg_start+1])) {
+	if(band_height) {
+		if(!RenderPageToFileByBands(page, document, format, (uint16_t)band_height, argv[arg_start+1]))
+			wprintf(L"Can't decode page to file\n");
+	} else if(!RenderPageToFile(page, document, format, argv[arg_start+1])) {
 		wprintf(L"Can't decode page to file\n");
 	}
 
@@ -121,8 +180,8 @@ int wmain(int argc, wchar_t **argv)
 	result = EXIT_SUCCESS;
 	
 FINAL:
-	if(fctx) djvupureFileClose(fctx);
 	if(document) djvupureChunkFree(document);
+	if(fmap) djvupureFileUnmap(fmap);
 	
 	return result;
 }
@@ -132,15 +191,23 @@ bool RenderPageToFile(djvupure_chunk_t *page, djvupure_chunk_t *document, int fo
 	void *image_renderer_ctx = 0, *image_buffer = 0;
 	uint16_t image_width, image_height;
 	uint8_t image_channels;
+	size_t row_size;
 	bool result = false;
 
 	image_renderer_ctx = djvupurePageImageRendererCreate(page, document, &image_width, &image_height, &image_channels);
 	if(!image_renderer_ctx) return false;
 
-	if(SIZE_MAX/image_width < image_height) goto FINAL;
-	if(SIZE_MAX/((size_t)image_width*(size_t)image_height) < image_channels) goto FINAL;
+	// Mask is rendered packed as in pbm file
+	if(!djvupurePageImageRendererSetFlags(image_renderer_ctx, DJVUPURE_RENDER_FLAG_PACKED_MASK)) goto FINAL;
+
+	if(image_channels == 1)
+		row_size = ((size_t)image_width+7)/8;
+	else
+		row_size = (size_t)image_width*image_channels;
 
-	image_buffer = malloc((size_t)image_width*(size_t)image_height*(size_t)image_channels);
+	if(SIZE_MAX/row_size < image_height) goto FINAL;
+
+	image_buffer = malloc(row_size*image_height);
 	if(!image_buffer) goto FINAL;
 
 	while(1) {
@@ -153,16 +220,83 @@ bool RenderPageToFile(djvupure_chunk_t *page, djvupure_chunk_t *document, int fo
 		else if(step != DJVUPURE_IMAGE_RENDERER_NEXT_STAGE) goto FINAL;
 	}
 
+	result = SaveImageToFile(image_width, image_height, image_channels, image_buffer, format, fname);
+
+FINAL:
+	if(image_renderer_ctx) djvupurePageImageRendererDestroy(image_renderer_ctx);
+	if(image_buffer) free(image_buffer);
+
+	return result;
+}
+
+// Writes header of pnm file, then rows are written by bands
+bool RenderPageToFileByBands(djvupure_chunk_t *page, djvupure_chunk_t *document, int format, uint16_t band_height, wchar_t *fname)
+{
+	void *image_renderer_ctx = 0;
+	djvupuredec_band_sink_t sink;
+	uint16_t image_width, image_height;
+	uint8_t image_channels;
+	bool result = false;
+
+	if(format != DJVUPUREDEC_FORMAT_PNM) return false;
+
+	sink.f = 0;
+
+	image_renderer_ctx = djvupurePageImageRendererCreate(page, document, &image_width, &image_height, &image_channels);
+	if(!image_renderer_ctx) return false;
+
+	if(image_channels != 1 && image_channels != 3) goto FINAL;
+
+	if(!djvupurePageImageRendererSetFlags(image_renderer_ctx, DJVUPURE_RENDER_FLAG_PACKED_MASK)) goto FINAL;
+
+	sink.width = image_width;
+
+	sink.f = djvupureFileOpenW(fname, true);
+	if(!sink.f) goto FINAL;
+
+	if(image_channels == 1)
+		fprintf(sink.f, "P4\n%u %u\n", image_width, image_height);
+	else
+		fprintf(sink.f, "P6\n%u %u\n255\n", image_width, image_height);
+
+	result = djvupurePageImageRendererRenderBands(image_renderer_ctx, band_height, SaveBandToFile, &sink);
+
+FINAL:
+	if(image_renderer_ctx) djvupurePageImageRendererDestroy(image_renderer_ctx);
+	if(sink.f) djvupureFileClose(sink.f);
+
+	return result;
+}
+
+bool DJVUPURE_APIENTRY SaveBandToFile(void *sink_ctx, uint16_t y, uint16_t nof_rows, uint8_t channels, void *band_buffer)
+{
+	djvupuredec_band_sink_t *sink;
+	size_t line_size;
+
+	(void)y;
+
+	sink = (djvupuredec_band_sink_t *)sink_ctx;
+
+	// Mask rows are packed as in pbm file
+	if(channels == 3)
+		line_size = (size_t)sink->width*3;
+	else
+		line_size = ((size_t)sink->width+7)/8;
+
+	return fwrite(band_buffer, line_size, nof_rows, sink->f) == nof_rows;
+}
+
+bool SaveImageToFile(uint16_t image_width, uint16_t image_height, uint8_t image_channels, void *image_buffer, int format, wchar_t *fname)
+{
+	bool result = false;
+
 	if(format == DJVUPUREDEC_FORMAT_PNM) {
-		djvupure_io_callback_t io;
 		void *fctx = 0;
 
-		if(image_channels != 1 && image_channels != 3) goto FINAL;
-
-		djvupureFileSetIoCallbacks(&io);
+		if(image_channels != 1 && image_channels != 3) return false;
 
 		fctx = djvupureFileOpenW(fname, true);
-		if(!fctx) goto FINAL;
+		if(!fctx) return false;
 
 		if(image_channels == 1) {
 			if(pbmSave(image_width, image_height, image_buffer, (FILE *)fctx)) result = true;
@@ -173,9 +307,41 @@ bool RenderPageToFile(djvupure_chunk_t *page, djvupure_chunk_t *document, int fo
 		djvupureFileClose(fctx);
 	}
 
-FINAL:
-	if(image_renderer_ctx) djvupurePageImageRendererDestroy(image_renderer_ctx);
-	if(image_buffer) free(image_buffer);
+	return result;
+}
+
+// Saves page to file with page number added before extension, it's called from several threads
+bool DJVUPURE_APIENTRY SavePageToFile(void *sink_ctx, size_t index, uint16_t width, uint16_t height, uint8_t channels, void *image_buffer)
+{
+	djvupuredec_sink_t *sink;
+	wchar_t *fname, *ext, *slash;
+	size_t fname_len, base_len;
+	bool result;
+
+	sink = (djvupuredec_sink_t *)sink_ctx;
+
+	if(!image_buffer) {
+		wprintf(L"Can't decode page %zu\n", index+1);
+
+		return true;
+	}
+
+	fname_len = wcslen(sink->fname)+32;
+	fname = malloc(fname_len*sizeof(wchar_t));
+	if(!fname) return false;
+
+	ext = wcsrchr(sink->fname, L'.');
+	slash = wcsrchr(sink->fname, L'/');
+	if(!slash) slash = wcsrchr(sink->fname, L'\\');
+	if(!ext || (slash && ext < slash)) ext = sink->fname+wcslen(sink->fname);
+	base_len = ext-sink->fname;
+
+	swprintf(fname, fname_len, L"%.*ls_%zu%ls", (int)base_len, sink->fname, index+1, ext);
+
+	result = SaveImageToFile(width, height, channels, image_buffer, sink->format, fname);
+	if(!result) wprintf(L"Can't save page %zu to file\n", index+1);
+
+	free(fname);
 
 	return result;
 }
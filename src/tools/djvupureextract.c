@@ -41,10 +41,9 @@ bool ExtractChunkFromPage(djvupure_chunk_t *page, const uint8_t sign[4], wchar_t
 
 int wmain(int argc, wchar_t **argv)
 {
-	djvupure_io_callback_t io;
 	djvupure_chunk_t *document = 0, *page;
 	size_t index = 0;
-	void *fctx = 0;
+	void *fmap = 0;
 	int result = EXIT_FAILURE, arg_start = 1;
 
 	setlocale(LC_CTYPE, "");
@@ -77,14 +76,10 @@ int wmain(int argc, wchar_t **argv)
 		arg_start++;
 	}
 
-	djvupureFileSetIoCallbacks(&io);
+	fmap = djvupureFileMapW(argv[arg_start]);
+	if(!fmap) goto FINAL;
 	
-	fctx = djvupureFileOpenW(argv[arg_start], false);
-	if(!fctx) goto FINAL;
-	
-	document = djvupureDocumentRead(&io, fctx);
-	djvupureFileClose(fctx);
-	fctx = 0;
+	document = djvupureDocumentMap(fmap);
 	if(!document) goto FINAL;
 	
 	page = djvupureDocumentGetPage(document, index, djvupureFileOpenU8, djvupureFileClose);
@@ -121,8 +116,8 @@ int wmain(int argc, wchar_t **argv)
 	result = EXIT_SUCCESS;
 	
 FINAL:
-	if(fctx) djvupureFileClose(fctx);
 	if(document) djvupureChunkFree(document);
+	if(fmap) djvupureFileUnmap(fmap);
 	
 	return result;
 }
@@ -107,7 +107,18 @@ int wmain(int argc, wchar_t **argv)
 		size_t chunk_no;
 
 		if((chunk_no = djvupureContainerFindSubchunkBySign(page, djvupure_sjbz_sign, 0, 0)) != nof_chunks) {
-			wprintf(L"Generate INFO chunk: Found Sjbz chunk, but it is unsupported\n");
+			djvupure_chunk_t *sjbz;
+
+			sjbz = djvupureContainerGetSubchunk(page, chunk_no);
+
+			if(sjbz) {
+				if(!djvupureSjbzGetInfo(sjbz, &(info.width), &(info.height)))
+					wprintf(L"Generate INFO chunk: Can't get info from Sjbz chunk\n");
+				else
+					info_found = true;
+			} else {
+				wprintf(L"Generate INFO chunk: Can't retrieve Sjbz chunk\n");
+			}
 		}
 		if(!info_found && (chunk_no = djvupureContainerFindSubchunkBySign(page, djvupure_smmr_sign, 0, 0)) != nof_chunks) {
 			djvupure_chunk_t *smmr;
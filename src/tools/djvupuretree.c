@@ -37,7 +37,7 @@ static void PrintChunks(djvupure_chunk_t *chunk, size_t level, size_t offset);
 int wmain(int argc, wchar_t **argv)
 {
 	wchar_t *filename;
-	void *fctx;
+	void *fmap;
 	djvupure_io_callback_t io;
 	djvupure_chunk_t *document;
 
@@ -74,8 +74,8 @@ int wmain(int argc, wchar_t **argv)
 	
 	wprintf(L"Opening \"%ls\"\n", filename);
 	
-	fctx = djvupureFileOpenW(filename, false);
-	if(!fctx) {
+	fmap = djvupureFileMapW(filename);
+	if(!fmap) {
 		wprintf(L"Can't open file\n");
 		
 		return EXIT_FAILURE;
@@ -83,10 +83,10 @@ int wmain(int argc, wchar_t **argv)
 	
 	djvupureFileSetIoCallbacks(&io);
 	
-	document = djvupureDocumentRead(&io, fctx);
-	djvupureFileClose(fctx);
+	document = djvupureDocumentMap(fmap);
 	if(!document) {
 		wprintf(L"Can't open document\n");
+		djvupureFileUnmap(fmap);
 		
 		return EXIT_FAILURE;
 	}
@@ -97,9 +97,15 @@ int wmain(int argc, wchar_t **argv)
 	
 #ifdef _DEBUG
 	if(argc > 2) {
+		void *fctx;
 		bool result;
 		fctx = djvupureFileOpenW(argv[2], true);
-		if(!fctx) return EXIT_FAILURE;
+		if(!fctx) {
+			djvupureChunkFree(document);
+			djvupureFileUnmap(fmap);
+
+			return EXIT_FAILURE;
+		}
 		
 		result = djvupureDocumentRender(document, &io, fctx);
 		djvupureFileClose(fctx);
@@ -109,6 +115,7 @@ int wmain(int argc, wchar_t **argv)
 		else {
 			wprintf(L"Can't save document\n");
 			djvupureChunkFree(document);
+			djvupureFileUnmap(fmap);
 			
 			return EXIT_FAILURE;
 		}
@@ -116,6 +123,7 @@ int wmain(int argc, wchar_t **argv)
 #endif
 
 	djvupureChunkFree(document);
+	djvupureFileUnmap(fmap);
 
 	return EXIT_SUCCESS;
 }